@@ -0,0 +1,412 @@
+// -----------------------------------------------------------------------------
+// Shot-search computer player for the 8-Ball Pool Game
+//
+// ai_start() hands a copy of the table to a search thread, which plays
+// candidate shots on a SimPool in batches of AI_BATCH_SIZE and checks the
+// time budget between batches. The coarse grid covers every direction at a
+// few speeds; each refinement round then samples a finer grid around the
+// best shots found so far. The game polls for the result each frame.
+// -----------------------------------------------------------------------------
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "ai.h"
+#include "simpool.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Shot scores
+#define SCORE_POCKETED 100.0f    // Per ball of the computer's group pocketed
+#define SCORE_FOUL -150.0f       // Any foul (the opponent gets ball in hand)
+#define SCORE_LOSS -1000.0f      // The shot lost the game
+#define SCORE_WIN 1000.0f        // The shot won the game
+#define SCORE_TIMEOUT -50.0f     // Still moving after MAX_SHOT_SECONDS
+#define SCORE_LEAVE 5.0f         // Most per ball to play next left next to a pocket
+#define LEAVE_DISTANCE 150.0f    // Balls further from a pocket earn nothing
+
+#define CANDIDATE_CAPACITY (AI_ANGLE_SAMPLES * AI_POWER_SAMPLES)
+
+// A candidate shot: direction of cue ball travel (radians) and speed
+typedef struct {
+    float angle;
+    float power;
+    float score;
+} Candidate;
+
+struct AiPlayer {
+    SimPool* pool;
+    pthread_t thread;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;      // Signalled when a search is requested or on shutdown
+    pthread_cond_t finished;  // Signalled when a search ends
+    unsigned request;         // Incremented by every ai_start()
+    bool searching;
+    bool done;                // move holds an unclaimed result
+    bool shuttingDown;
+    atomic_bool cancelled;
+    AiMove move;
+
+    // Owned by the search thread while searching
+    Table start;              // Copy of the table to play from
+    Match match;              // The game before the shot; the computer is to shoot
+    double deadline;          // now_seconds() when the budget runs out
+    Candidate best[AI_REFINE_KEEP]; // Best candidates so far, best first
+    int bestCount;
+    int evaluated;
+    Candidate candidates[CANDIDATE_CAPACITY];
+    Vec2D cues[AI_BATCH_SIZE];
+    ShotResult results[AI_BATCH_SIZE];
+};
+
+// --- Function Prototypes ---
+static void* search_main(void* arg);
+static AiMove search(AiPlayer* ai);
+static bool evaluate(AiPlayer* ai, int count);
+static void keep_if_best(AiPlayer* ai, Candidate candidate);
+static Vec2D candidate_cue(Candidate candidate);
+static double now_seconds();
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Creates a computer player and its search thread.
+ * @param numThreads Threads to simulate with, including the search thread;
+ * 0 or less means one per CPU core.
+ * @return The player, or NULL on failure.
+ */
+AiPlayer* ai_create(int numThreads) {
+    AiPlayer* ai = calloc(1, sizeof(AiPlayer));
+    if (ai == NULL) {
+        return NULL;
+    }
+    ai->pool = simpool_create(numThreads);
+    if (ai->pool == NULL) {
+        free(ai);
+        return NULL;
+    }
+    pthread_mutex_init(&ai->lock, NULL);
+    pthread_cond_init(&ai->wake, NULL);
+    pthread_cond_init(&ai->finished, NULL);
+    atomic_init(&ai->cancelled, false);
+
+    if (pthread_create(&ai->thread, NULL, search_main, ai) != 0) {
+        pthread_cond_destroy(&ai->finished);
+        pthread_cond_destroy(&ai->wake);
+        pthread_mutex_destroy(&ai->lock);
+        simpool_destroy(ai->pool);
+        free(ai);
+        return NULL;
+    }
+    return ai;
+}
+
+/**
+ * @brief Starts searching for a shot in the background.
+ * @param ai The player.
+ * @param table The table to shoot on (must be aiming with the cue ball on
+ * the table). It is copied, so it may change during the search.
+ * @param match The game, with the computer to shoot. Also copied.
+ * @param budgetSeconds How long to search for. At least one batch of
+ * candidates is always simulated.
+ * @return false if a search is already running or the table has no shot.
+ */
+bool ai_start(AiPlayer* ai, const Table* table, const Match* match, double budgetSeconds) {
+    if (table->state != STATE_AIMING || !ball_active(table, 0)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&ai->lock);
+    if (ai->searching) {
+        pthread_mutex_unlock(&ai->lock);
+        return false;
+    }
+    ai->start = *table;
+    ai->match = *match;
+    ai->start.fastForward = true; // Resting positions are all that is scored
+    ai->start.profileClock = NULL;
+    ai->deadline = now_seconds() + budgetSeconds;
+    ai->searching = true;
+    ai->done = false;
+    atomic_store(&ai->cancelled, false);
+    ai->request++;
+    pthread_cond_signal(&ai->wake);
+    pthread_mutex_unlock(&ai->lock);
+    return true;
+}
+
+/**
+ * @brief Collects the result of a finished search. Each result is returned
+ * once.
+ * @param ai The player.
+ * @param move Receives the chosen shot.
+ * @return true if a search has finished since the last call.
+ */
+bool ai_poll(AiPlayer* ai, AiMove* move) {
+    pthread_mutex_lock(&ai->lock);
+    bool done = ai->done;
+    if (done) {
+        *move = ai->move;
+        ai->done = false;
+    }
+    pthread_mutex_unlock(&ai->lock);
+    return done;
+}
+
+/**
+ * @brief Returns true while a search is running.
+ */
+bool ai_busy(AiPlayer* ai) {
+    pthread_mutex_lock(&ai->lock);
+    bool searching = ai->searching;
+    pthread_mutex_unlock(&ai->lock);
+    return searching;
+}
+
+/**
+ * @brief Abandons the current search, if any, and discards its result.
+ * Waits for the batch being simulated to finish.
+ */
+void ai_cancel(AiPlayer* ai) {
+    atomic_store(&ai->cancelled, true);
+    pthread_mutex_lock(&ai->lock);
+    while (ai->searching) {
+        pthread_cond_wait(&ai->finished, &ai->lock);
+    }
+    ai->done = false;
+    pthread_mutex_unlock(&ai->lock);
+}
+
+/**
+ * @brief Stops the search thread and frees the player.
+ */
+void ai_destroy(AiPlayer* ai) {
+    if (ai == NULL) {
+        return;
+    }
+
+    atomic_store(&ai->cancelled, true);
+    pthread_mutex_lock(&ai->lock);
+    ai->shuttingDown = true;
+    pthread_cond_signal(&ai->wake);
+    pthread_mutex_unlock(&ai->lock);
+    pthread_join(ai->thread, NULL);
+
+    simpool_destroy(ai->pool);
+    pthread_cond_destroy(&ai->finished);
+    pthread_cond_destroy(&ai->wake);
+    pthread_mutex_destroy(&ai->lock);
+    free(ai);
+}
+
+/**
+ * @brief Scores the outcome of a shot for the player who took it, from the
+ * rules' verdict on the shot's events: balls of the player's group
+ * pocketed, minus penalties for a foul and for shots that never stop, or a
+ * win or loss if the shot ended the game. A shot that keeps the turn also
+ * earns a little for each ball the player can play next left close to a
+ * pocket.
+ * @param match The game before the shot.
+ * @param after The table after the shot.
+ * @return The score; higher is better.
+ */
+float ai_score_shot(const Match* match, const Table* after) {
+    ShotVerdict verdict = rules_judge(match, after);
+    if (verdict.gameOver) {
+        return verdict.won ? SCORE_WIN : SCORE_LOSS;
+    }
+
+    float score = SCORE_POCKETED * verdict.ownPocketed;
+    if (verdict.foul != FOUL_NONE) {
+        score += SCORE_FOUL;
+    }
+    if (after->state == STATE_SIMULATING) {
+        score += SCORE_TIMEOUT;
+    }
+    if (!verdict.keepsTurn) {
+        return score;
+    }
+
+    for (BallMask next = rules_targets(after, verdict.group); next != 0; next &= next - 1) {
+        int i = lowest_ball(next);
+        float nearest = LEAVE_DISTANCE;
+        for (int p = 0; p < NUM_POCKETS; ++p) {
+            float dx = after->geometry.pockets[p].pos.x - after->px[i];
+            float dy = after->geometry.pockets[p].pos.y - after->py[i];
+            float dist = sqrtf(dx * dx + dy * dy);
+            if (dist < nearest) nearest = dist;
+        }
+        score += SCORE_LEAVE * (1.0f - nearest / LEAVE_DISTANCE);
+    }
+    return score;
+}
+
+/**
+ * @brief Search thread body: runs each requested search and publishes its
+ * result unless it was cancelled.
+ */
+static void* search_main(void* arg) {
+    AiPlayer* ai = arg;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&ai->lock);
+    for (;;) {
+        while (!ai->shuttingDown && ai->request == seen) {
+            pthread_cond_wait(&ai->wake, &ai->lock);
+        }
+        if (ai->shuttingDown) {
+            break;
+        }
+        seen = ai->request;
+        pthread_mutex_unlock(&ai->lock);
+
+        AiMove move = search(ai);
+
+        pthread_mutex_lock(&ai->lock);
+        ai->move = move;
+        ai->done = !atomic_load(&ai->cancelled);
+        ai->searching = false;
+        pthread_cond_broadcast(&ai->finished);
+    }
+    ai->searching = false;
+    pthread_cond_broadcast(&ai->finished);
+    pthread_mutex_unlock(&ai->lock);
+    return NULL;
+}
+
+/**
+ * @brief Searches the coarse grid, then refines around the best candidates
+ * until the budget runs out or AI_MAX_ROUNDS rounds are done.
+ * @return The best shot found.
+ */
+static AiMove search(AiPlayer* ai) {
+    const float angleStep = 2.0f * (float)M_PI / AI_ANGLE_SAMPLES;
+    const float powerStep = (AI_MAX_POWER - AI_MIN_POWER) / (AI_POWER_SAMPLES - 1);
+    ai->bestCount = 0;
+    ai->evaluated = 0;
+
+    // Coarse grid: every direction at a few speeds
+    int count = 0;
+    for (int p = 0; p < AI_POWER_SAMPLES; ++p) {
+        for (int a = 0; a < AI_ANGLE_SAMPLES; ++a) {
+            ai->candidates[count++] = (Candidate){a * angleStep, AI_MIN_POWER + p * powerStep, 0.0f};
+        }
+    }
+    bool inBudget = evaluate(ai, count);
+
+    // Refinement: a grid half as wide around each of the best shots per round
+    int rounds = 0;
+    const int half = AI_REFINE_GRID / 2;
+    while (inBudget && rounds < AI_MAX_ROUNDS) {
+        float scale = 1.0f / (float)(2 << rounds);
+        Candidate centers[AI_REFINE_KEEP];
+        int numCenters = ai->bestCount;
+        for (int c = 0; c < numCenters; ++c) centers[c] = ai->best[c];
+
+        count = 0;
+        for (int c = 0; c < numCenters; ++c) {
+            for (int dp = -half; dp <= half; ++dp) {
+                for (int da = -half; da <= half; ++da) {
+                    if (da == 0 && dp == 0) continue;
+                    float power = centers[c].power + dp * powerStep * scale;
+                    if (power < AI_MIN_POWER || power > AI_MAX_POWER) continue;
+                    ai->candidates[count++] = (Candidate){centers[c].angle + da * angleStep * scale, power, 0.0f};
+                }
+            }
+        }
+        inBudget = evaluate(ai, count);
+        if (inBudget) rounds++;
+    }
+
+    AiMove move = {{0.0f, 0.0f}, 0.0f, ai->evaluated, rounds};
+    if (ai->bestCount > 0) {
+        move.cue = candidate_cue(ai->best[0]);
+        move.score = ai->best[0].score;
+    }
+    return move;
+}
+
+/**
+ * @brief Simulates and scores the first count entries of ai->candidates,
+ * one batch at a time, keeping the best.
+ * @return false if the budget ran out (or the search was cancelled) before
+ * every candidate was simulated.
+ */
+static bool evaluate(AiPlayer* ai, int count) {
+    for (int first = 0; first < count; first += AI_BATCH_SIZE) {
+        if (atomic_load(&ai->cancelled) || (ai->evaluated > 0 && now_seconds() >= ai->deadline)) {
+            return false;
+        }
+        int batch = count - first < AI_BATCH_SIZE ? count - first : AI_BATCH_SIZE;
+        for (int i = 0; i < batch; ++i) {
+            ai->cues[i] = candidate_cue(ai->candidates[first + i]);
+        }
+        simpool_run(ai->pool, &ai->start, ai->cues, ai->results, batch);
+        for (int i = 0; i < batch; ++i) {
+            Candidate candidate = ai->candidates[first + i];
+            candidate.score = ai_score_shot(&ai->match, &ai->results[i].table);
+            keep_if_best(ai, candidate);
+        }
+        ai->evaluated += batch;
+    }
+    return !atomic_load(&ai->cancelled) && now_seconds() < ai->deadline;
+}
+
+/**
+ * @brief Inserts a candidate into the best list if it beats the worst
+ * entry. Ties keep the earlier candidate, so results do not depend on the
+ * thread count.
+ */
+static void keep_if_best(AiPlayer* ai, Candidate candidate) {
+    int i = ai->bestCount;
+    if (i == AI_REFINE_KEEP) {
+        if (candidate.score <= ai->best[i - 1].score) {
+            return;
+        }
+        i--;
+    } else {
+        ai->bestCount++;
+    }
+    while (i > 0 && ai->best[i - 1].score < candidate.score) {
+        ai->best[i] = ai->best[i - 1];
+        i--;
+    }
+    ai->best[i] = candidate;
+}
+
+/**
+ * @brief Returns the cue ball velocity a candidate plays.
+ */
+static Vec2D candidate_cue(Candidate candidate) {
+    return (Vec2D){cosf(candidate.angle) * candidate.power, sinf(candidate.angle) * candidate.power};
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now_seconds() {
+#ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double)count.QuadPart / frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
@@ -0,0 +1,56 @@
+// -----------------------------------------------------------------------------
+// Shot-search computer player for the 8-Ball Pool Game
+//
+// Picks a shot by simulating thousands of candidate cue velocities on
+// copies of the table with the batch simulator, first on a coarse
+// angle x power grid and then on finer grids around the best candidates.
+// The search runs on its own thread (plus a worker pool) so the game keeps
+// rendering while the computer thinks.
+// -----------------------------------------------------------------------------
+
+#ifndef AI_H
+#define AI_H
+
+#include <stdbool.h>
+#include "physics.h"
+#include "rules.h"
+
+// Coarse search grid
+#define AI_ANGLE_SAMPLES 360
+#define AI_POWER_SAMPLES 8
+#define AI_MIN_POWER 4.0f   // Cue speeds searched, table units per base frame
+#define AI_MAX_POWER 75.0f
+
+// Refinement: each round re-samples an AI_REFINE_GRID x AI_REFINE_GRID grid
+// around each of the AI_REFINE_KEEP best shots so far, half as wide as the
+// round before
+#define AI_REFINE_KEEP 8
+#define AI_REFINE_GRID 5
+#define AI_MAX_ROUNDS 8
+
+// Candidates simulated between time budget checks
+#define AI_BATCH_SIZE 512
+
+#define AI_DEFAULT_BUDGET 2.0 // Seconds per move
+
+// The chosen shot
+typedef struct {
+    Vec2D cue;      // Cue velocity to play
+    float score;    // See ai_score_shot()
+    int evaluated;  // Candidates simulated
+    int rounds;     // Refinement rounds completed
+} AiMove;
+
+// Opaque computer player
+typedef struct AiPlayer AiPlayer;
+
+// --- Function Prototypes ---
+AiPlayer* ai_create(int numThreads);
+bool ai_start(AiPlayer* ai, const Table* table, const Match* match, double budgetSeconds);
+bool ai_poll(AiPlayer* ai, AiMove* move);
+bool ai_busy(AiPlayer* ai);
+void ai_cancel(AiPlayer* ai);
+void ai_destroy(AiPlayer* ai);
+float ai_score_shot(const Match* match, const Table* after);
+
+#endif
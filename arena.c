@@ -0,0 +1,117 @@
+// -----------------------------------------------------------------------------
+// Bump arenas for the 8-Ball Pool Game
+//
+// Allocations are rounded up to ARENA_ALIGN and carved off the front of the
+// block. When one does not fit the arena returns NULL (and counts it)
+// rather than growing, so an arena sized for the steady state never calls
+// the heap after arena_init().
+//
+// The allocation counter works by linking with
+// -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc: every call to those in
+// the linked objects then lands in the __wrap_ functions below, which count
+// it and forward to the C library.
+// -----------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "arena.h"
+
+#ifdef POOL_COUNT_ALLOCS
+static atomic_uint_fast64_t gHeapAllocations;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* block, size_t size);
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void* __wrap_realloc(void* block, size_t size);
+#endif
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Allocates an arena's block.
+ * @param arena The arena to initialize.
+ * @param capacity Bytes the arena can hand out between resets.
+ * @return false if the block could not be allocated (the arena is then
+ * empty, and every allocation from it fails).
+ */
+bool arena_init(Arena* arena, size_t capacity) {
+    arena->base = malloc(capacity);
+    arena->capacity = arena->base != NULL ? capacity : 0;
+    arena->used = 0;
+    arena->peak = 0;
+    arena->failures = 0;
+    return arena->base != NULL;
+}
+
+/**
+ * @brief Takes memory from an arena. It stays valid until the next
+ * arena_reset() and is not zeroed.
+ * @param arena The arena.
+ * @param size Bytes needed.
+ * @return ARENA_ALIGN-aligned memory, or NULL if the arena is full.
+ */
+void* arena_alloc(Arena* arena, size_t size) {
+    size_t rounded = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (arena->base == NULL || rounded < size || rounded > arena->capacity - arena->used) {
+        arena->failures++;
+        return NULL;
+    }
+    void* block = arena->base + arena->used;
+    arena->used += rounded;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    return block;
+}
+
+/**
+ * @brief Gives back everything allocated from an arena.
+ */
+void arena_reset(Arena* arena) {
+    arena->used = 0;
+}
+
+/**
+ * @brief Frees an arena's block. Freeing an arena that failed to
+ * initialize does nothing.
+ */
+void arena_free(Arena* arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+/**
+ * @brief Returns the number of heap allocations made so far by the code
+ * built with POOL_COUNT_ALLOCS, on any thread. Always 0 in other builds.
+ */
+uint64_t heap_allocations() {
+#ifdef POOL_COUNT_ALLOCS
+    return atomic_load_explicit(&gHeapAllocations, memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+#ifdef POOL_COUNT_ALLOCS
+
+// --- Heap Allocation Counter ---
+
+void* __wrap_malloc(size_t size) {
+    atomic_fetch_add_explicit(&gHeapAllocations, 1, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    atomic_fetch_add_explicit(&gHeapAllocations, 1, memory_order_relaxed);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* block, size_t size) {
+    atomic_fetch_add_explicit(&gHeapAllocations, 1, memory_order_relaxed);
+    return __real_realloc(block, size);
+}
+
+#endif
@@ -0,0 +1,38 @@
+// -----------------------------------------------------------------------------
+// Bump arenas for the 8-Ball Pool Game
+//
+// An arena hands out memory from one block allocated up front and gets it
+// all back at once with arena_reset(), so scratch that lives for a frame
+// (or a shot) costs a pointer bump instead of a heap allocation. Not
+// thread-safe: each thread keeps its own arena.
+//
+// Builds with POOL_COUNT_ALLOCS (the benchmark's) also count every
+// malloc(), calloc() and realloc() made by the code linked with them, so a
+// hot path that starts allocating can be caught (see bench.c).
+// -----------------------------------------------------------------------------
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARENA_ALIGN 16 // Every allocation is aligned for the SIMD kernels
+
+typedef struct {
+    unsigned char* base; // NULL until initialized
+    size_t capacity;
+    size_t used;
+    size_t peak;         // Most bytes ever in use, to size the arena
+    uint64_t failures;   // Allocations that did not fit
+} Arena;
+
+// --- Function Prototypes ---
+bool arena_init(Arena* arena, size_t capacity);
+void* arena_alloc(Arena* arena, size_t size);
+void arena_reset(Arena* arena);
+void arena_free(Arena* arena);
+uint64_t heap_allocations();
+
+#endif
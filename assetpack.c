@@ -0,0 +1,446 @@
+// -----------------------------------------------------------------------------
+// Packed game assets for the 8-Ball Pool Game
+//
+// File format (little-endian):
+//   header (ASSET_HEADER_SIZE bytes): "PAST", u32 version, u32 slot count
+//     (a power of two), u32 asset count
+//   slots (ASSET_SLOT_SIZE bytes each): u64 name hash, u32 name offset,
+//     u32 name length, u32 data offset, u32 data size; a slot with a zero
+//     name length is empty
+//   names, then each asset's data aligned to ASSET_ALIGN
+//
+// Offsets are from the start of the pack. The slots are an open-addressing
+// hash table keyed by the FNV-1a hash of the name, with linear probing and
+// at least half of them empty, so a lookup reads a slot or two. Every slot is
+// checked once when a pack is opened; lookups then trust the index.
+// -----------------------------------------------------------------------------
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "assetpack.h"
+
+struct AssetPack {
+    const unsigned char* data; // The whole pack
+    size_t size;
+    uint32_t slotCount;
+    uint32_t assetCount;
+    bool mapped;               // data is a file mapping, not the executable's
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+// The pack linked into the executable by the ASSETS build option
+#ifdef POOL_ASSET_PACK
+#ifdef _WIN32
+#define ASSET_SECTION ".section .rdata,\"dr\"\n"
+#else
+#define ASSET_SECTION ".section .rodata\n"
+#endif
+__asm__(ASSET_SECTION
+        ".balign 16\n"
+        "embedded_assets:\n"
+        ".incbin \"" POOL_ASSET_PACK "\"\n"
+        "embedded_assets_end:\n"
+        ".previous\n");
+extern const unsigned char embedded_assets[];
+extern const unsigned char embedded_assets_end[];
+#endif
+
+// --- Function Prototypes ---
+static AssetPack* load_index(AssetPack* pack);
+static uint64_t hash_name(const char* name, size_t length);
+static bool map_file(AssetPack* pack, const char* path);
+static void unmap_file(AssetPack* pack);
+static unsigned char* read_file(const char* path, size_t* size);
+static void put_u32(unsigned char* p, uint32_t v);
+static void put_u64(unsigned char* p, uint64_t v);
+static uint32_t get_u32(const unsigned char* p);
+static uint64_t get_u64(const unsigned char* p);
+
+
+// --- Reader ---
+
+/**
+ * @brief Maps an asset pack from disk.
+ * @param path The pack file.
+ * @return The pack, or NULL if it cannot be read or is not a valid pack.
+ */
+AssetPack* assetpack_open(const char* path) {
+    AssetPack* pack = calloc(1, sizeof(AssetPack));
+    if (pack == NULL) {
+        printf("Out of memory!\n");
+        return NULL;
+    }
+    if (!map_file(pack, path)) {
+        printf("Could not open asset pack '%s'!\n", path);
+        free(pack);
+        return NULL;
+    }
+    pack->mapped = true;
+    return load_index(pack);
+}
+
+/**
+ * @brief Returns the pack linked into the executable.
+ * @return The pack, or NULL if the build has none.
+ */
+AssetPack* assetpack_embedded() {
+#ifdef POOL_ASSET_PACK
+    AssetPack* pack = calloc(1, sizeof(AssetPack));
+    if (pack == NULL) {
+        printf("Out of memory!\n");
+        return NULL;
+    }
+    pack->data = embedded_assets;
+    pack->size = (size_t)(embedded_assets_end - embedded_assets);
+    return load_index(pack);
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * @brief Looks an asset up by name.
+ * @param pack The pack; NULL finds nothing.
+ * @param name The asset's name.
+ * @param data Receives a pointer to the asset's bytes in the pack, valid
+ * until the pack is freed.
+ * @param size Receives the asset's size in bytes.
+ * @return false if the pack has no such asset.
+ */
+bool assetpack_find(const AssetPack* pack, const char* name, const void** data, size_t* size) {
+    if (pack == NULL) {
+        return false;
+    }
+    size_t length = strlen(name);
+    uint64_t hash = hash_name(name, length);
+    uint32_t mask = pack->slotCount - 1;
+    for (uint32_t i = (uint32_t)hash & mask;; i = (i + 1) & mask) {
+        const unsigned char* slot = pack->data + ASSET_HEADER_SIZE + (size_t)i * ASSET_SLOT_SIZE;
+        uint32_t nameLength = get_u32(slot + 12);
+        if (nameLength == 0) {
+            return false;
+        }
+        if (get_u64(slot) == hash && nameLength == length &&
+            memcmp(pack->data + get_u32(slot + 8), name, length) == 0) {
+            *data = pack->data + get_u32(slot + 16);
+            *size = get_u32(slot + 20);
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Returns the number of assets in a pack.
+ */
+int assetpack_count(const AssetPack* pack) {
+    return pack != NULL ? (int)pack->assetCount : 0;
+}
+
+/**
+ * @brief Unmaps a pack and frees it. NULL is ignored.
+ */
+void assetpack_free(AssetPack* pack) {
+    if (pack == NULL) {
+        return;
+    }
+    if (pack->mapped) {
+        unmap_file(pack);
+    }
+    free(pack);
+}
+
+/**
+ * @brief Checks a pack's header and every slot of its index, so lookups
+ * never read outside the pack.
+ * @return The pack, or NULL (and the pack freed) if it is not valid.
+ */
+static AssetPack* load_index(AssetPack* pack) {
+    const unsigned char* p = pack->data;
+    bool ok = pack->size >= ASSET_HEADER_SIZE && memcmp(p, ASSET_MAGIC, 4) == 0 &&
+              get_u32(p + 4) == ASSET_VERSION;
+    if (ok) {
+        pack->slotCount = get_u32(p + 8);
+        pack->assetCount = get_u32(p + 12);
+        ok = pack->slotCount > 0 && (pack->slotCount & (pack->slotCount - 1)) == 0 &&
+             pack->assetCount < pack->slotCount &&
+             (pack->size - ASSET_HEADER_SIZE) / ASSET_SLOT_SIZE >= pack->slotCount;
+    }
+
+    uint32_t used = 0;
+    for (uint32_t i = 0; ok && i < pack->slotCount; ++i) {
+        const unsigned char* slot = p + ASSET_HEADER_SIZE + (size_t)i * ASSET_SLOT_SIZE;
+        uint64_t nameOffset = get_u32(slot + 8);
+        uint64_t nameLength = get_u32(slot + 12);
+        uint64_t dataOffset = get_u32(slot + 16);
+        uint64_t dataSize = get_u32(slot + 20);
+        if (nameLength == 0) {
+            continue;
+        }
+        used++;
+        ok = nameOffset + nameLength <= pack->size && dataOffset + dataSize <= pack->size &&
+             hash_name((const char*)p + nameOffset, (size_t)nameLength) == get_u64(slot);
+    }
+    if (!ok || used != pack->assetCount) {
+        printf("Not a valid asset pack!\n");
+        assetpack_free(pack);
+        return NULL;
+    }
+    return pack;
+}
+
+
+// --- Writer ---
+
+/**
+ * @brief Packs files into a new asset pack.
+ * @param path The pack to write.
+ * @param names Each asset's name.
+ * @param files The file holding each asset.
+ * @param count The number of assets; names must be unique and non-empty.
+ * @return false if a file cannot be read or the pack cannot be written
+ * (reported on stdout).
+ */
+bool assetpack_write(const char* path, const char* const* names, const char* const* files, int count) {
+    uint32_t slotCount = 1;
+    while (slotCount < (uint32_t)count * 2 + 1) slotCount *= 2;
+    unsigned char** contents = calloc((size_t)count + 1, sizeof(unsigned char*));
+    size_t* sizes = calloc((size_t)count + 1, sizeof(size_t));
+    size_t indexSize = ASSET_HEADER_SIZE + (size_t)slotCount * ASSET_SLOT_SIZE;
+    unsigned char* index = calloc(1, indexSize);
+    bool ok = contents != NULL && sizes != NULL && index != NULL;
+    if (!ok) {
+        printf("Out of memory!\n");
+    }
+    for (int i = 0; ok && i < count; ++i) {
+        ok = names[i][0] != '\0';
+        for (int j = 0; ok && j < i; ++j) {
+            ok = strcmp(names[i], names[j]) != 0;
+        }
+        if (!ok) {
+            printf("Asset names must be unique and not empty ('%s')!\n", names[i]);
+        }
+    }
+
+    // Lay the pack out: the index, the names, then the data
+    size_t end = indexSize;
+    for (int i = 0; ok && i < count; ++i) {
+        end += strlen(names[i]);
+    }
+    for (int i = 0; ok && i < count; ++i) {
+        contents[i] = read_file(files[i], &sizes[i]);
+        ok = contents[i] != NULL;
+        end = (end + ASSET_ALIGN - 1) & ~(size_t)(ASSET_ALIGN - 1);
+        end += sizes[i];
+    }
+    if (ok && end > UINT32_MAX) {
+        printf("Asset pack '%s' would be over 4 GB!\n", path);
+        ok = false;
+    }
+
+    memcpy(index, ASSET_MAGIC, 4);
+    put_u32(index + 4, ASSET_VERSION);
+    put_u32(index + 8, slotCount);
+    put_u32(index + 12, (uint32_t)count);
+    size_t nameOffset = indexSize;
+    size_t dataOffset = indexSize;
+    for (int i = 0; ok && i < count; ++i) {
+        dataOffset += strlen(names[i]);
+    }
+    for (int i = 0; ok && i < count; ++i) {
+        size_t length = strlen(names[i]);
+        uint64_t hash = hash_name(names[i], length);
+        uint32_t i0 = (uint32_t)hash & (slotCount - 1);
+        unsigned char* slot = index + ASSET_HEADER_SIZE + (size_t)i0 * ASSET_SLOT_SIZE;
+        while (get_u32(slot + 12) != 0) {
+            i0 = (i0 + 1) & (slotCount - 1);
+            slot = index + ASSET_HEADER_SIZE + (size_t)i0 * ASSET_SLOT_SIZE;
+        }
+        dataOffset = (dataOffset + ASSET_ALIGN - 1) & ~(size_t)(ASSET_ALIGN - 1);
+        put_u64(slot, hash);
+        put_u32(slot + 8, (uint32_t)nameOffset);
+        put_u32(slot + 12, (uint32_t)length);
+        put_u32(slot + 16, (uint32_t)dataOffset);
+        put_u32(slot + 20, (uint32_t)sizes[i]);
+        nameOffset += length;
+        dataOffset += sizes[i];
+    }
+
+    FILE* out = ok ? fopen(path, "wb") : NULL;
+    if (ok && out == NULL) {
+        printf("Could not create asset pack '%s'!\n", path);
+        ok = false;
+    }
+    if (ok) {
+        static const unsigned char zeros[ASSET_ALIGN] = {0};
+        size_t written = fwrite(index, 1, indexSize, out);
+        size_t position = indexSize;
+        for (int i = 0; i < count; ++i) {
+            size_t length = strlen(names[i]);
+            written += fwrite(names[i], 1, length, out);
+            position += length;
+        }
+        for (int i = 0; i < count; ++i) {
+            size_t padding = ((position + ASSET_ALIGN - 1) & ~(size_t)(ASSET_ALIGN - 1)) - position;
+            written += fwrite(zeros, 1, padding, out);
+            written += fwrite(contents[i], 1, sizes[i], out);
+            position += padding + sizes[i];
+        }
+        ok = fclose(out) == 0 && written == position;
+        if (!ok) {
+            printf("Could not write asset pack '%s'!\n", path);
+        }
+    }
+
+    for (int i = 0; contents != NULL && i < count; ++i) {
+        free(contents[i]);
+    }
+    free(contents);
+    free(sizes);
+    free(index);
+    return ok;
+}
+
+
+// --- Helpers ---
+
+/**
+ * @brief Returns the FNV-1a 64-bit hash of a name.
+ */
+static uint64_t hash_name(const char* name, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ (unsigned char)name[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Maps a whole file read-only into pack->data.
+ * @return false if the file cannot be opened or mapped.
+ */
+static bool map_file(AssetPack* pack, const char* path) {
+#ifdef _WIN32
+    pack->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (pack->file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(pack->file, &size) || size.QuadPart == 0) {
+        CloseHandle(pack->file);
+        return false;
+    }
+    pack->mapping = CreateFileMappingA(pack->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (pack->mapping == NULL) {
+        CloseHandle(pack->file);
+        return false;
+    }
+    pack->data = MapViewOfFile(pack->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (pack->data == NULL) {
+        CloseHandle(pack->mapping);
+        CloseHandle(pack->file);
+        return false;
+    }
+    pack->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    pack->data = data;
+    pack->size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+/**
+ * @brief Releases the mapping made by map_file().
+ */
+static void unmap_file(AssetPack* pack) {
+#ifdef _WIN32
+    UnmapViewOfFile(pack->data);
+    CloseHandle(pack->mapping);
+    CloseHandle(pack->file);
+#else
+    munmap((void*)pack->data, pack->size);
+#endif
+    pack->data = NULL;
+}
+
+/**
+ * @brief Reads a whole file into a new buffer.
+ * @param size Receives the file's size.
+ * @return The buffer (free() it), or NULL if the file cannot be read
+ * (reported on stdout).
+ */
+static unsigned char* read_file(const char* path, size_t* size) {
+    FILE* in = fopen(path, "rb");
+    if (in == NULL) {
+        printf("Could not open '%s'!\n", path);
+        return NULL;
+    }
+    unsigned char* data = NULL;
+    long length = -1;
+    if (fseek(in, 0, SEEK_END) == 0) {
+        length = ftell(in);
+    }
+    if (length >= 0 && fseek(in, 0, SEEK_SET) == 0) {
+        data = malloc((size_t)length + 1);
+    }
+    if (data != NULL && fread(data, 1, (size_t)length, in) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(in);
+    if (data == NULL) {
+        printf("Could not read '%s'!\n", path);
+        return NULL;
+    }
+    *size = (size_t)length;
+    return data;
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void put_u64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t get_u64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
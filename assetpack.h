@@ -0,0 +1,38 @@
+// -----------------------------------------------------------------------------
+// Packed game assets for the 8-Ball Pool Game
+//
+// An asset pack is one file holding any number of named assets (fonts,
+// images, sounds) behind a hash index. A pack is either mapped from disk or
+// linked into the executable (build with ASSETS=FILE), and assets are used
+// in place: finding one returns a pointer into the pack, never a copy. The
+// mapping is read-only, so pages are only read from disk as assets use them.
+//
+// This module has no SDL dependency; the game wraps assets it loads with
+// SDL_RWFromConstMem().
+// -----------------------------------------------------------------------------
+
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ASSET_MAGIC "PAST"
+#define ASSET_VERSION 1
+#define ASSET_HEADER_SIZE 16
+#define ASSET_SLOT_SIZE 24
+#define ASSET_ALIGN 16 // Each asset's data starts on a 16-byte boundary
+
+// Opaque pack
+typedef struct AssetPack AssetPack;
+
+// --- Function Prototypes ---
+AssetPack* assetpack_open(const char* path);
+AssetPack* assetpack_embedded();
+bool assetpack_find(const AssetPack* pack, const char* name, const void** data, size_t* size);
+int assetpack_count(const AssetPack* pack);
+void assetpack_free(AssetPack* pack);
+bool assetpack_write(const char* path, const char* const* names, const char* const* files, int count);
+
+#endif
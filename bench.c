@@ -0,0 +1,322 @@
+// -----------------------------------------------------------------------------
+// Deterministic physics benchmark for the 8-Ball Pool Game
+//
+// Plays a fixed set of canonical shots from the standard rack through
+// update() and reports throughput and a checksum of the final tables. It
+// then breaks every other table variant into a second checksum, so the
+// 8-ball one stays comparable with earlier runs, and every variant with the
+// event solver into a third. A checksum that differs from the one recorded
+// below means the physics results changed; update it when that is intended.
+// Built with POOL_COUNT_ALLOCS (as `make bench` does), it also fails if
+// playing a shot, with either solver, allocates from the heap: shots must
+// run on fixed-capacity state alone.
+//
+// To build and run: `make bench`
+// -----------------------------------------------------------------------------
+
+#define _POSIX_C_SOURCE 200809L // For clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <time.h>
+#include "physics.h"
+#include "arena.h"
+
+#define BENCH_REPEATS 200 // Default number of times each shot is played
+
+// Checksum of all canonical shots at DEFAULT_PHYSICS_HZ. The integer
+// backend has its own, which every compiler and target must reproduce.
+#ifdef POOL_FIXED_POINT
+#define BENCH_CHECKSUM 0x6104170a0234d41fULL
+#else
+#define BENCH_CHECKSUM 0xae9867d3f43020d6ULL
+#endif
+
+// Checksum of VARIANT_BREAK on every other variant with the fixed-step
+// solver. Like BENCH_CHECKSUM, the integer backend's must match everywhere.
+#ifdef POOL_FIXED_POINT
+#define BENCH_VARIANT_CHECKSUM 0x578c082c65f94202ULL
+#else
+#define BENCH_VARIANT_CHECKSUM 0x566b73e452777420ULL
+#endif
+
+// Checksum of VARIANT_BREAK on every variant with the event solver. That
+// solver works in floats (and libm) in both backends, so the value is only
+// tied to the float build's target: it fails there, and is only reported
+// by POOL_FIXED_POINT builds.
+#define BENCH_EVENTS_CHECKSUM 0x4cc4590f054bf10dULL
+
+// A canonical shot. Cue velocities are given directly, so the results do
+// not depend on the platform's trigonometric functions.
+typedef struct {
+    const char* name;
+    Vec2D cue;
+} BenchShot;
+
+static const BenchShot SHOTS[] = {
+    {"break",    {75.0f, 0.0f}},               // Full-power break straight at the apex
+    {"safety",   {5.5f, 0.0f}},                // Barely reaches the rack
+    {"scratch",  {64.3987732f, 6.72540426f}},  // Break that pockets the cue ball
+    {"8-ball",   {63.4346313f, 4.19219494f}}   // Break that pockets the 8-ball
+};
+#define NUM_SHOTS ((int)(sizeof(SHOTS) / sizeof(SHOTS[0])))
+
+static const Vec2D VARIANT_BREAK = {75.0f, 0.0f}; // The full break, on each variant's rack
+
+// --- Function Prototypes ---
+static int time_shot(const Table* rack, Vec2D cue, int repeats, Table* table, double* seconds,
+                     bool* deterministic);
+static uint64_t pair_stage_ns(const Table* rack, Vec2D cue, int repeats);
+static uint64_t bench_ns();
+static int play_shot(const Table* rack, Vec2D cue, Table* table);
+static void print_pocketed(const Table* table);
+
+
+// --- Function Implementations ---
+
+int main(int argc, char* args[]) {
+    int repeats = BENCH_REPEATS;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(args[i], "--repeats") == 0 && i + 1 < argc) {
+            repeats = atoi(args[++i]);
+        } else {
+            printf("Usage: %s [--repeats N]\n", args[0]);
+            return 1;
+        }
+    }
+    if (repeats < 1) repeats = 1;
+
+    Table rack;
+    init_table(&rack, DEFAULT_PHYSICS_HZ);
+    Table eventRack = rack;
+    eventRack.solver = SOLVER_EVENTS;
+
+    uint64_t checksum = TABLE_HASH_SEED;
+    uint64_t totalSteps = 0;
+    uint64_t totalPairs = 0;
+    double totalSeconds = 0.0;
+    uint64_t pairNs = 0; // Time in the ball-ball stage of the fixed-step shots
+    int totalShots = 0;
+    bool deterministic = true;
+    uint64_t shotAllocations = 0;
+
+    printf("%-15s %7s %8s %10s  %-16s  %s\n", "shot", "steps", "pairs", "steps/s", "checksum", "pocketed");
+    for (int s = 0; s < NUM_SHOTS; ++s) {
+        Table table;
+        double seconds;
+        uint64_t allocationsBefore = heap_allocations();
+        int steps = time_shot(&rack, SHOTS[s].cue, repeats, &table, &seconds, &deterministic);
+
+        // The timed shots only use the fixed-step solver; check the other
+        // one allocates nothing either
+        Table events;
+        play_shot(&eventRack, SHOTS[s].cue, &events);
+        shotAllocations += heap_allocations() - allocationsBefore;
+
+        checksum = table_hash(&table, checksum);
+        totalSteps += (uint64_t)steps * repeats;
+        totalPairs += table.collisions.totalTested * repeats;
+        totalSeconds += seconds;
+        pairNs += pair_stage_ns(&rack, SHOTS[s].cue, repeats);
+        totalShots += repeats;
+
+        printf("%-15s %7d %8llu %10.0f  %016llx  ", SHOTS[s].name, steps,
+               (unsigned long long)table.collisions.totalTested,
+               seconds > 0.0 ? steps * repeats / seconds : 0.0,
+               (unsigned long long)table_hash(&table, TABLE_HASH_SEED));
+        print_pocketed(&table);
+    }
+
+    // The break on every other variant, and on every variant with the event
+    // solver, into checksums of their own
+    uint64_t variantChecksum = TABLE_HASH_SEED;
+    uint64_t eventsChecksum = TABLE_HASH_SEED;
+    for (int v = 0; v < VARIANT_COUNT; ++v) {
+        for (int solver = SOLVER_FIXED_STEP; solver <= SOLVER_EVENTS; ++solver) {
+            if (v == VARIANT_EIGHT_BALL && solver == SOLVER_FIXED_STEP) continue;
+
+            Table variantRack;
+            init_table(&variantRack, DEFAULT_PHYSICS_HZ);
+            variantRack.variant = (TableVariant)v;
+            variantRack.solver = (Solver)solver;
+            setup_table(&variantRack);
+
+            Table table;
+            double seconds;
+            uint64_t allocationsBefore = heap_allocations();
+            int steps = time_shot(&variantRack, VARIANT_BREAK, repeats, &table, &seconds, &deterministic);
+            shotAllocations += heap_allocations() - allocationsBefore;
+
+            if (solver == SOLVER_EVENTS) {
+                eventsChecksum = table_hash(&table, eventsChecksum);
+            } else {
+                variantChecksum = table_hash(&table, variantChecksum);
+            }
+            totalSteps += (uint64_t)steps * repeats;
+            totalSeconds += seconds;
+            totalShots += repeats;
+            if (solver == SOLVER_FIXED_STEP) {
+                totalPairs += table.collisions.totalTested * repeats;
+                pairNs += pair_stage_ns(&variantRack, VARIANT_BREAK, repeats);
+            }
+
+            char name[32];
+            snprintf(name, sizeof(name), "%s/%s", variant_name((TableVariant)v),
+                     solver == SOLVER_EVENTS ? "events" : "step");
+            printf("%-15s %7d %8llu %10.0f  %016llx  ", name, steps,
+                   (unsigned long long)table.collisions.totalTested,
+                   seconds > 0.0 ? steps * repeats / seconds : 0.0,
+                   (unsigned long long)table_hash(&table, TABLE_HASH_SEED));
+            print_pocketed(&table);
+        }
+    }
+
+    double shots = totalShots;
+    printf("\n%d shots x %d repeats in %.3f s\n", totalShots / repeats, repeats, totalSeconds);
+    if (totalSeconds > 0.0) {
+        printf("steps/sec         %.0f\n", totalSteps / totalSeconds);
+        printf("shots/sec         %.1f\n", shots / totalSeconds);
+    }
+    if (totalPairs > 0) {
+        printf("ns per pair test  %.1f\n", (double)pairNs / totalPairs);
+    }
+
+    int status = 0;
+    if (!deterministic) {
+        printf("NONDETERMINISTIC: repeats of the same shot gave different results\n");
+        status = 1;
+    }
+#ifdef POOL_COUNT_ALLOCS
+    if (shotAllocations == 0) {
+        printf("heap allocations  0 (ok)\n");
+    } else {
+        printf("heap allocations  %llu (ALLOCATED: shots must not use the heap)\n",
+               (unsigned long long)shotAllocations);
+        status = 1;
+    }
+#endif
+    if (checksum == BENCH_CHECKSUM) {
+        printf("checksum          %016llx (ok)\n", (unsigned long long)checksum);
+    } else {
+        printf("checksum          %016llx (DRIFT: expected %016llx)\n",
+               (unsigned long long)checksum, (unsigned long long)BENCH_CHECKSUM);
+        status = 1;
+    }
+    if (variantChecksum == BENCH_VARIANT_CHECKSUM) {
+        printf("variant checksum  %016llx (ok)\n", (unsigned long long)variantChecksum);
+    } else {
+        printf("variant checksum  %016llx (DRIFT: expected %016llx)\n",
+               (unsigned long long)variantChecksum, (unsigned long long)BENCH_VARIANT_CHECKSUM);
+        status = 1;
+    }
+#ifdef POOL_FIXED_POINT
+    printf("events checksum   %016llx (float solver, not checked)\n", (unsigned long long)eventsChecksum);
+#else
+    if (eventsChecksum == BENCH_EVENTS_CHECKSUM) {
+        printf("events checksum   %016llx (ok)\n", (unsigned long long)eventsChecksum);
+    } else {
+        printf("events checksum   %016llx (DRIFT: expected %016llx)\n",
+               (unsigned long long)eventsChecksum, (unsigned long long)BENCH_EVENTS_CHECKSUM);
+        status = 1;
+    }
+#endif
+    return status;
+}
+
+/**
+ * @brief Plays one shot repeats times, timing it and checking every repeat
+ * ends on the same table.
+ * @param rack The table to play from.
+ * @param cue The cue ball's velocity.
+ * @param repeats How many times to play it (at least 1).
+ * @param table Receives the table after the shot.
+ * @param seconds Receives the CPU time all the repeats took.
+ * @param deterministic Set to false if two repeats ended differently.
+ * @return The number of steps the shot took.
+ */
+static int time_shot(const Table* rack, Vec2D cue, int repeats, Table* table, double* seconds,
+                     bool* deterministic) {
+    uint64_t shotHash = 0;
+    int steps = 0;
+    clock_t start = clock();
+    for (int r = 0; r < repeats; ++r) {
+        steps = play_shot(rack, cue, table);
+        uint64_t hash = table_hash(table, TABLE_HASH_SEED);
+        if (r > 0 && hash != shotHash) *deterministic = false;
+        shotHash = hash;
+    }
+    *seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    return steps;
+}
+
+/**
+ * @brief Times the ball-ball stage (broad and narrow phase) of a shot. The
+ * shot is played again with a profile clock rather than during time_shot(),
+ * so reading the clock does not slow the timed steps.
+ * @param rack The table to play from.
+ * @param cue The cue ball's velocity.
+ * @param repeats How many times to play it.
+ * @return Nanoseconds spent in PHYS_STAGE_BALLS over all the repeats.
+ */
+static uint64_t pair_stage_ns(const Table* rack, Vec2D cue, int repeats) {
+    Table profiled = *rack;
+    profiled.profileClock = bench_ns;
+    uint64_t ns = 0;
+    for (int r = 0; r < repeats; ++r) {
+        Table table;
+        play_shot(&profiled, cue, &table);
+        ns += table.stageTicks[PHYS_STAGE_BALLS];
+    }
+    return ns;
+}
+
+/**
+ * @brief Returns a monotonic time in nanoseconds, as the profile clock.
+ */
+static uint64_t bench_ns() {
+#ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((double)count.QuadPart * 1e9 / frequency.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Plays one shot from the rack, stepping update() until the table
+ * is no longer simulating or MAX_SHOT_SECONDS have passed.
+ * @param rack The table to play from.
+ * @param cue The cue ball's velocity.
+ * @param table Receives the table after the shot.
+ * @return The number of physics steps simulated.
+ */
+static int play_shot(const Table* rack, Vec2D cue, Table* table) {
+    *table = *rack;
+    strike_cue_ball(table, cue);
+
+    const int maxSteps = MAX_SHOT_SECONDS * table->physicsHz;
+    int steps = 0;
+    while (table->state == STATE_SIMULATING && steps < maxSteps) {
+        update(table);
+        steps++;
+    }
+    return steps;
+}
+
+/**
+ * @brief Prints the ids of the pocketed balls and a newline.
+ */
+static void print_pocketed(const Table* table) {
+    for (int i = 0; i < table->ballCount; ++i) {
+        if (!ball_active(table, i)) printf(" %d", i);
+    }
+    printf("\n");
+}
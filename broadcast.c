@@ -0,0 +1,556 @@
+// -----------------------------------------------------------------------------
+// Spectator broadcasts for the 8-Ball Pool Game
+//
+// Wire format (all integers little-endian):
+//   header: "PBCS", u32 version, u32 physicsHz, u32 BROADCAST_HZ,
+//           u32 rackSeed, u32 variant
+//   frame:  u16 size, u8 flags, u8 zero, u32 tick, u32 toggled, u32 moved,
+//           then for each ball in moved (lowest id first) its quantized
+//           x,y as i16
+//
+// "toggled" holds the balls that left or came back onto the table and
+// "moved" the balls on the table whose quantized position changed. The
+// server only sends a frame when something changed, so a table at rest costs
+// nothing; a frame of one rolling ball is 20 bytes.
+//
+// The server is a single thread. Each tick it steps the table, encodes one
+// frame into a ring shared by every viewer and then hands each viewer,
+// on a nonblocking socket, everything it has not had yet in one send. A
+// viewer that falls a whole ring behind is dropped. A new viewer is sent
+// the header and a keyframe of the table as last broadcast, then joins the
+// ring at its head.
+// -----------------------------------------------------------------------------
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "net.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "headless.h"
+#include "broadcast.h"
+
+// Bytes a spectator buffers; enough for several seconds of frames
+#define SPECTATOR_BUFFER_SIZE (1 << 14)
+
+// A connected viewer
+typedef struct {
+    NetSocket sock;
+    uint64_t sent; // Ring offset of the next byte it gets
+} Viewer;
+
+// The server's state
+typedef struct {
+    NetSocket listener;
+    Viewer* viewers;
+    int viewerCount;
+    unsigned char* ring;
+    uint64_t head;                 // Ring offset after the latest frame
+    uint32_t tick;                 // Frames broadcast so far
+    int16_t sentPos[MAX_BALLS][2]; // The table as last broadcast
+    BallMask sentActive;
+    const Table* rack;
+} Broadcast;
+
+struct Spectator {
+    NetSocket sock;
+    bool closed;
+    unsigned char buffer[SPECTATOR_BUFFER_SIZE]; // Received, not yet applied
+    int start;
+    int length;
+    int16_t pos[MAX_BALLS][2];
+    BallMask active;
+    BallMask balls; // Every ball of the broadcast's variant
+};
+
+// --- Function Prototypes ---
+static void broadcast_frame(Broadcast* b, const Table* table, bool cut);
+static int encode_frame(unsigned char* p, uint8_t flags, uint32_t tick, BallMask toggled,
+                        BallMask moved, int16_t pos[MAX_BALLS][2]);
+static void flush_viewers(Broadcast* b);
+static void drop_viewer(Broadcast* b, int index);
+static void serve_until(Broadcast* b, double deadline);
+static void add_viewer(Broadcast* b, NetSocket sock);
+static int frame_size(Spectator* spectator, int offset);
+static int16_t quantize(float value);
+static double now_seconds();
+static void put_u16(unsigned char* p, uint16_t v);
+static void put_u32(unsigned char* p, uint32_t v);
+static uint16_t get_u16(const unsigned char* p);
+static uint32_t get_u32(const unsigned char* p);
+
+
+// --- Server ---
+
+/**
+ * @brief Plays every shot in a shot file from the rack, in real time, and
+ * broadcasts the table to everyone who connects until the last shot has
+ * come to rest.
+ * @param port The port spectators connect to.
+ * @param shotsPath The shot file (see headless.c).
+ * @param rack The racked table each shot is played from.
+ * @return 0 on success, 1 on failure (suitable as a process exit code).
+ */
+int run_broadcast(int port, const char* shotsPath, const Table* rack) {
+    FILE* in = fopen(shotsPath, "r");
+    if (in == NULL) {
+        printf("Could not open shot file '%s'!\n", shotsPath);
+        return 1;
+    }
+    if (!net_startup()) {
+        fclose(in);
+        return 1;
+    }
+
+    Broadcast b = {0};
+    b.rack = rack;
+    b.listener = net_listen(port);
+    b.viewers = malloc(BROADCAST_MAX_VIEWERS * sizeof(Viewer));
+    b.ring = malloc(BROADCAST_RING_SIZE);
+    if (b.listener == NET_INVALID_SOCKET || b.viewers == NULL || b.ring == NULL) {
+        if (b.listener != NET_INVALID_SOCKET) printf("Out of memory!\n");
+        net_close(b.listener);
+        free(b.viewers);
+        free(b.ring);
+        net_shutdown();
+        fclose(in);
+        return 1;
+    }
+    printf("Broadcasting on port %d\n", port);
+
+    // Viewers see the rack before the first shot; each shot starts from it
+    Table table = *rack;
+    table.fastForward = false; // Spectators see every step
+    for (int i = 0; i < table.ballCount; ++i) {
+        b.sentPos[i][0] = quantize(table.px[i]);
+        b.sentPos[i][1] = quantize(table.py[i]);
+    }
+    b.sentActive = table.active;
+
+    const double start = now_seconds();
+    int pause = BROADCAST_PAUSE_SECONDS * BROADCAST_HZ;
+    int lineNumber = 0;
+    int shotNumber = 0;
+    int status = 0;
+    uint64_t shotTicks = 0;
+    uint64_t shotSteps = 0;
+    for (;;) {
+        bool cut = false;
+        if (table.state != STATE_SIMULATING) {
+            if (pause > 0) {
+                pause--;
+            } else {
+                Shot shot;
+                int read = read_shot(in, shotsPath, &lineNumber, &shot);
+                if (read <= 0) {
+                    status = read < 0;
+                    break;
+                }
+                table = *rack;
+                table.fastForward = false;
+                strike_cue_ball(&table, shot_cue(shot));
+                cut = true;
+                shotTicks = 0;
+                shotSteps = 0;
+                printf("Shot %d, %d viewers\n", ++shotNumber, b.viewerCount);
+            }
+        }
+
+        // Keep the table's steps in time with the broadcast's ticks
+        if (table.state == STATE_SIMULATING) {
+            shotTicks++;
+            uint64_t target = shotTicks * (uint64_t)table.physicsHz / BROADCAST_HZ;
+            while (shotSteps < target && table.state == STATE_SIMULATING) {
+                update(&table);
+                shotSteps++;
+            }
+            if (table.state != STATE_SIMULATING) {
+                pause = BROADCAST_PAUSE_SECONDS * BROADCAST_HZ;
+            }
+        }
+
+        broadcast_frame(&b, &table, cut);
+        flush_viewers(&b);
+        b.tick++;
+        serve_until(&b, start + (double)b.tick / BROADCAST_HZ);
+    }
+
+    printf("Broadcast finished after %d shots\n", shotNumber);
+    while (b.viewerCount > 0) {
+        drop_viewer(&b, b.viewerCount - 1);
+    }
+    net_close(b.listener);
+    free(b.viewers);
+    free(b.ring);
+    net_shutdown();
+    fclose(in);
+    return status;
+}
+
+/**
+ * @brief Appends a frame of whatever changed since the last one to the
+ * ring. Nothing is appended if nothing changed.
+ * @param b The server.
+ * @param table The table after this tick's steps.
+ * @param cut True if the balls jumped (a new rack) this tick.
+ */
+static void broadcast_frame(Broadcast* b, const Table* table, bool cut) {
+    BallMask toggled = table->active ^ b->sentActive;
+    BallMask moved = 0;
+    for (BallMask m = table->active; m != 0; m &= m - 1) {
+        int i = lowest_ball(m);
+        int16_t x = quantize(table->px[i]);
+        int16_t y = quantize(table->py[i]);
+        if (x != b->sentPos[i][0] || y != b->sentPos[i][1]) {
+            b->sentPos[i][0] = x;
+            b->sentPos[i][1] = y;
+            moved |= (BallMask)1 << i;
+        }
+    }
+    b->sentActive = table->active;
+    if (toggled == 0 && moved == 0) {
+        return;
+    }
+
+    unsigned char frame[BROADCAST_MAX_FRAME_SIZE];
+    int size = encode_frame(frame, cut ? BROADCAST_CUT : 0, b->tick, toggled, moved, b->sentPos);
+    int offset = (int)(b->head % BROADCAST_RING_SIZE);
+    int first = size < BROADCAST_RING_SIZE - offset ? size : BROADCAST_RING_SIZE - offset;
+    memcpy(b->ring + offset, frame, first);
+    memcpy(b->ring, frame + first, size - first);
+    b->head += size;
+}
+
+/**
+ * @brief Encodes a frame.
+ * @param p Receives the frame; BROADCAST_MAX_FRAME_SIZE bytes.
+ * @param pos Quantized positions; those of the balls in moved are sent.
+ * @return The frame's size in bytes.
+ */
+static int encode_frame(unsigned char* p, uint8_t flags, uint32_t tick, BallMask toggled,
+                        BallMask moved, int16_t pos[MAX_BALLS][2]) {
+    int size = BROADCAST_FRAME_HEADER_SIZE + ball_count(moved) * 4;
+    put_u16(p, (uint16_t)size);
+    p[2] = flags;
+    p[3] = 0;
+    put_u32(p + 4, tick);
+    put_u32(p + 8, toggled);
+    put_u32(p + 12, moved);
+    unsigned char* q = p + BROADCAST_FRAME_HEADER_SIZE;
+    for (; moved != 0; moved &= moved - 1, q += 4) {
+        int i = lowest_ball(moved);
+        put_u16(q, (uint16_t)pos[i][0]);
+        put_u16(q + 2, (uint16_t)pos[i][1]);
+    }
+    return size;
+}
+
+/**
+ * @brief Sends each viewer everything in the ring it has not had yet,
+ * dropping viewers that have fallen a whole ring behind or gone away.
+ */
+static void flush_viewers(Broadcast* b) {
+    for (int v = b->viewerCount - 1; v >= 0; --v) {
+        Viewer* viewer = &b->viewers[v];
+        uint64_t pending = b->head - viewer->sent;
+        if (pending > BROADCAST_RING_SIZE) {
+            drop_viewer(b, v);
+            continue;
+        }
+        // At most two sends, when the pending bytes wrap around the ring
+        while (pending > 0) {
+            int offset = (int)(viewer->sent % BROADCAST_RING_SIZE);
+            int chunk = pending < (uint64_t)(BROADCAST_RING_SIZE - offset) ? (int)pending : BROADCAST_RING_SIZE - offset;
+            int sent = net_send(viewer->sock, b->ring + offset, chunk);
+            if (sent < 0) {
+                drop_viewer(b, v);
+                break;
+            }
+            viewer->sent += sent;
+            pending -= sent;
+            if (sent < chunk) {
+                break; // Its socket is full; it gets the rest next tick
+            }
+        }
+    }
+}
+
+/**
+ * @brief Disconnects a viewer; the last viewer takes its slot.
+ */
+static void drop_viewer(Broadcast* b, int index) {
+    net_close(b->viewers[index].sock);
+    b->viewers[index] = b->viewers[--b->viewerCount];
+}
+
+/**
+ * @brief Accepts new viewers until a deadline.
+ * @param deadline The time (see now_seconds()) to return at.
+ */
+static void serve_until(Broadcast* b, double deadline) {
+    for (;;) {
+        int remainingMs = (int)((deadline - now_seconds()) * 1000.0);
+        if (remainingMs <= 0) {
+            return;
+        }
+        if (net_wait(b->listener, remainingMs) > 0) {
+            NetSocket sock = net_accept(b->listener);
+            if (sock != NET_INVALID_SOCKET) {
+                add_viewer(b, sock);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Sends a new viewer the header and a keyframe, then adds it to the
+ * viewers fed from the ring. A viewer that cannot take them at once, or one
+ * past BROADCAST_MAX_VIEWERS, is turned away.
+ */
+static void add_viewer(Broadcast* b, NetSocket sock) {
+    if (b->viewerCount == BROADCAST_MAX_VIEWERS || !net_set_blocking(sock, false)) {
+        net_close(sock);
+        return;
+    }
+
+    unsigned char hello[BROADCAST_HEADER_SIZE + BROADCAST_MAX_FRAME_SIZE];
+    memcpy(hello, BROADCAST_MAGIC, 4);
+    put_u32(hello + 4, BROADCAST_VERSION);
+    put_u32(hello + 8, (uint32_t)b->rack->physicsHz);
+    put_u32(hello + 12, BROADCAST_HZ);
+    put_u32(hello + 16, b->rack->rackSeed);
+    put_u32(hello + 20, (uint32_t)b->rack->variant);
+    int size = BROADCAST_HEADER_SIZE + encode_frame(hello + BROADCAST_HEADER_SIZE, BROADCAST_KEYFRAME | BROADCAST_CUT,
+                                                    b->tick, b->sentActive, b->sentActive, b->sentPos);
+    if (net_send(sock, hello, size) != size) {
+        net_close(sock);
+        return;
+    }
+    b->viewers[b->viewerCount++] = (Viewer){sock, b->head};
+}
+
+
+// --- Spectator ---
+
+/**
+ * @brief Connects to a broadcast and sets a table up to show it.
+ * @param host The server's name or address.
+ * @param port The server's port.
+ * @param table Receives the broadcast's physics rate, variant and rack; its
+ * balls are set by the frames applied with spectator_apply().
+ * @return The connection, or NULL on failure.
+ */
+Spectator* spectator_connect(const char* host, int port, Table* table) {
+    if (!net_startup()) {
+        return NULL;
+    }
+    NetSocket sock = net_connect(host, port);
+    if (sock == NET_INVALID_SOCKET) {
+        net_shutdown();
+        return NULL;
+    }
+
+    unsigned char header[BROADCAST_HEADER_SIZE];
+    if (!net_recv_all(sock, header, sizeof(header)) || memcmp(header, BROADCAST_MAGIC, 4) != 0 ||
+        get_u32(header + 4) != BROADCAST_VERSION || get_u32(header + 12) != BROADCAST_HZ ||
+        get_u32(header + 20) >= VARIANT_COUNT) {
+        printf("%s is not running a compatible broadcast!\n", host);
+        net_close(sock);
+        net_shutdown();
+        return NULL;
+    }
+    Spectator* spectator = calloc(1, sizeof(Spectator));
+    if (spectator == NULL) {
+        printf("Out of memory!\n");
+        net_close(sock);
+        net_shutdown();
+        return NULL;
+    }
+    spectator->sock = sock;
+
+    set_physics_rate(table, (int)get_u32(header + 8));
+    table->rackSeed = get_u32(header + 16);
+    table->variant = (TableVariant)get_u32(header + 20);
+    setup_table(table);
+    spectator->balls = all_balls(table);
+    table->active = 0; // Until the keyframe arrives
+    table->state = STATE_SIMULATING;
+    return spectator;
+}
+
+/**
+ * @brief Reads whatever the server has sent without blocking.
+ * @return false once the broadcast has ended or the connection failed;
+ * frames already received can still be applied.
+ */
+bool spectator_receive(Spectator* spectator) {
+    if (spectator->start > 0) {
+        memmove(spectator->buffer, spectator->buffer + spectator->start, spectator->length - spectator->start);
+        spectator->length -= spectator->start;
+        spectator->start = 0;
+    }
+    while (!spectator->closed && spectator->length < SPECTATOR_BUFFER_SIZE &&
+           net_wait(spectator->sock, 0) > 0) {
+        int received = net_recv(spectator->sock, spectator->buffer + spectator->length,
+                                SPECTATOR_BUFFER_SIZE - spectator->length);
+        if (received <= 0) {
+            spectator->closed = true;
+        } else {
+            spectator->length += received;
+        }
+    }
+    return !spectator->closed;
+}
+
+/**
+ * @brief Returns the tick of the next frame to apply.
+ * @return false if no whole frame has been received.
+ */
+bool spectator_next_tick(Spectator* spectator, uint32_t* tick) {
+    if (frame_size(spectator, spectator->start) == 0) {
+        return false;
+    }
+    *tick = get_u32(spectator->buffer + spectator->start + 4);
+    return true;
+}
+
+/**
+ * @brief Returns the tick of the latest frame received.
+ * @return false if no whole frame has been received.
+ */
+bool spectator_latest_tick(Spectator* spectator, uint32_t* tick) {
+    bool found = false;
+    int size;
+    for (int offset = spectator->start; (size = frame_size(spectator, offset)) > 0; offset += size) {
+        *tick = get_u32(spectator->buffer + offset + 4);
+        found = true;
+    }
+    return found;
+}
+
+/**
+ * @brief Applies the next frame to a table's balls. The table stays in
+ * STATE_SIMULATING, as it is being played elsewhere.
+ * @param spectator The connection; spectator_next_tick() must have found a
+ * frame.
+ * @param table The table set up by spectator_connect().
+ * @return The frame's flags.
+ */
+uint8_t spectator_apply(Spectator* spectator, Table* table) {
+    const unsigned char* p = spectator->buffer + spectator->start;
+    spectator->start += frame_size(spectator, spectator->start);
+
+    uint8_t flags = p[2];
+    if (flags & BROADCAST_KEYFRAME) {
+        spectator->active = 0;
+    }
+    spectator->active ^= get_u32(p + 8);
+    BallMask moved = get_u32(p + 12);
+    const unsigned char* q = p + BROADCAST_FRAME_HEADER_SIZE;
+    for (; moved != 0; moved &= moved - 1, q += 4) {
+        int i = lowest_ball(moved);
+        spectator->pos[i][0] = (int16_t)get_u16(q);
+        spectator->pos[i][1] = (int16_t)get_u16(q + 2);
+    }
+
+    for (int i = 0; i < table->ballCount; ++i) {
+        table->px[i] = spectator->pos[i][0] / (float)BROADCAST_UNITS_PER_TABLE_UNIT;
+        table->py[i] = spectator->pos[i][1] / (float)BROADCAST_UNITS_PER_TABLE_UNIT;
+        table->vx[i] = 0.0f;
+        table->vy[i] = 0.0f;
+    }
+    table->active = spectator->active;
+    table->state = STATE_SIMULATING;
+    return flags;
+}
+
+/**
+ * @brief Disconnects from a broadcast and frees the connection. NULL is
+ * ignored.
+ */
+void spectator_close(Spectator* spectator) {
+    if (spectator == NULL) {
+        return;
+    }
+    net_close(spectator->sock);
+    free(spectator);
+    net_shutdown();
+}
+
+/**
+ * @brief Returns the size of the whole frame received at a buffer offset,
+ * or 0 if it has not all arrived. A malformed frame closes the connection
+ * and reads as missing.
+ */
+static int frame_size(Spectator* spectator, int offset) {
+    int available = spectator->length - offset;
+    if (available < BROADCAST_FRAME_HEADER_SIZE) {
+        return 0;
+    }
+    const unsigned char* p = spectator->buffer + offset;
+    int size = get_u16(p);
+    if (size != BROADCAST_FRAME_HEADER_SIZE + ball_count(get_u32(p + 12)) * 4 ||
+        ((get_u32(p + 8) | get_u32(p + 12)) & ~spectator->balls) != 0) {
+        spectator->closed = true;
+        spectator->length = offset;
+        return 0;
+    }
+    return size <= available ? size : 0;
+}
+
+
+// --- Helpers ---
+
+/**
+ * @brief Converts a position to broadcast units, saturating at 16 bits
+ * (positions on the table are far inside that range).
+ */
+static int16_t quantize(float value) {
+    long q = lrintf(value * BROADCAST_UNITS_PER_TABLE_UNIT);
+    if (q < INT16_MIN) q = INT16_MIN;
+    if (q > INT16_MAX) q = INT16_MAX;
+    return (int16_t)q;
+}
+
+/**
+ * @brief Returns a monotonic time in seconds.
+ */
+static double now_seconds() {
+#ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double)count.QuadPart / frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+static void put_u16(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint16_t get_u16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
@@ -0,0 +1,51 @@
+// -----------------------------------------------------------------------------
+// Spectator broadcasts for the 8-Ball Pool Game
+//
+// A broadcast server plays a shot file on one authoritative table in real
+// time and streams it to any number of spectators over TCP. Each broadcast
+// frame carries only what changed since the previous one: the quantized
+// positions of the balls that moved and the balls that left or came back
+// onto the table. Spectators rebuild the table from the frames and draw it
+// with the game's renderer.
+// -----------------------------------------------------------------------------
+
+#ifndef BROADCAST_H
+#define BROADCAST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "physics.h"
+
+#define BROADCAST_MAGIC "PBCS"
+#define BROADCAST_VERSION 2
+
+#define BROADCAST_HZ 60                   // Frames per second of table time
+#define BROADCAST_UNITS_PER_TABLE_UNIT 16 // Position quantum is 1/16 table unit
+#define BROADCAST_RING_SIZE (1 << 16)     // Bytes of frames kept for viewers that lag
+#define BROADCAST_MAX_VIEWERS 1024
+#define BROADCAST_PAUSE_SECONDS 2         // Rest shown before each shot
+#define BROADCAST_DELAY_FRAMES 6          // Frames a spectator buffers against jitter
+#define BROADCAST_HEADER_SIZE 24
+#define BROADCAST_FRAME_HEADER_SIZE 16
+#define BROADCAST_MAX_FRAME_SIZE (BROADCAST_FRAME_HEADER_SIZE + MAX_BALLS * 4)
+
+// Frame flags
+#define BROADCAST_KEYFRAME 0x1 // Changes are from an empty table (first frame)
+#define BROADCAST_CUT 0x2      // The balls jumped (a new rack); do not interpolate
+
+_Static_assert(MAX_BALLS <= 32, "Broadcast frames hold 32-ball masks");
+
+// Opaque spectator connection
+typedef struct Spectator Spectator;
+
+// --- Function Prototypes ---
+int run_broadcast(int port, const char* shotsPath, const Table* rack);
+
+Spectator* spectator_connect(const char* host, int port, Table* table);
+bool spectator_receive(Spectator* spectator);
+bool spectator_next_tick(Spectator* spectator, uint32_t* tick);
+bool spectator_latest_tick(Spectator* spectator, uint32_t* tick);
+uint8_t spectator_apply(Spectator* spectator, Table* table);
+void spectator_close(Spectator* spectator);
+
+#endif
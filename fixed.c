@@ -0,0 +1,709 @@
+// -----------------------------------------------------------------------------
+// Fixed-point physics backend for the 8-Ball Pool Game
+//
+// In builds with POOL_FIXED_POINT (`make FIXED_POINT=1`), update() runs the
+// integer kernels here instead of the float kernels in physics.c. Integer
+// arithmetic is exact, so a shot gives the same bits with every compiler,
+// target and math library, and replays recorded on one platform play back
+// on every other.
+//
+// During a shot the ball state lives in table->fixed and the float arrays
+// are refreshed from it after every step, so the renderer, trajectory logs
+// and everything else keep reading floats. Positions have 14 fractional
+// bits: every position on the table is then exactly a float, so a table
+// racked or edited through the float arrays loads back without loss when
+// the next shot is struck (fixed_load()). Velocities have 20 fractional
+// bits so that friction still bites at MAX_PHYSICS_HZ, where a step takes
+// only 0.06% off a ball's speed. Products are taken in 64 bits and rounded
+// half away from zero, so mirrored shots stay mirrored.
+//
+// The per-step constants are derived without libm: stepFriction is the
+// root FRICTION^(BASE/hz) found by bisection on integer powers.
+//
+// As in physics.c, the step is compiled once per table variant with the
+// variant's ball count and diameter as constants.
+// -----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stddef.h>
+#include "physics.h"
+
+#ifdef POOL_FIXED_POINT
+
+// Fractional bits of each quantity
+#define POS_BITS 14    // Positions
+#define VEL_BITS 20    // Velocities
+#define NORMAL_BITS 30 // Unit vectors
+#define RATE_BITS 32   // Per-step factors (scale, friction)
+#define TRAVEL_BITS 16 // FixedState.travel
+
+#define POS_ONE ((int64_t)1 << POS_BITS)
+#define VEL_ONE ((int64_t)1 << VEL_BITS)
+#define NORMAL_ONE ((int64_t)1 << NORMAL_BITS)
+#define RATE_ONE ((uint64_t)1 << RATE_BITS)
+
+// Shifts taking products back to a position
+#define STEP_SHIFT (RATE_BITS + VEL_BITS - POS_BITS)     // Velocity * scale
+#define TRAVEL_SHIFT (TRAVEL_BITS + VEL_BITS - POS_BITS) // Velocity * travel
+
+// Fast-forward tests paths on positions truncated to 1/16 unit, where every
+// product fits in 64 bits. Truncation moves a point by less than 1.5 check
+// units, so tests are widened by CHECK_SLACK.
+#define CHECK_SHIFT (POS_BITS - 4)
+#define CHECK_SLACK 3
+
+#define MIN_SPEED ((int64_t)(MIN_VELOCITY * (float)VEL_ONE))
+
+// Fastest speed a velocity holds; strike_cue_ball() keeps shots well inside
+// it, and no collision makes a ball faster than the cue ball was
+#define MAX_VELOCITY_FIXED ((int64_t)INT32_MAX)
+_Static_assert((int64_t)MAX_CUE_SPEED * VEL_ONE * 2 < MAX_VELOCITY_FIXED, "MAX_CUE_SPEED overflows the velocities");
+
+// Forces a kernel into its caller, so the caller's constant arguments fold
+// into it
+#define KERNEL static inline __attribute__((always_inline))
+
+// A point in fixed-point table units
+typedef struct {
+    int32_t x;
+    int32_t y;
+} FixedPoint;
+
+// A point in fast-forward check units
+typedef struct {
+    int64_t x;
+    int64_t y;
+} CheckPoint;
+
+// --- Function Prototypes ---
+KERNEL void fixed_step(Table* table, uint64_t start, int balls, int diameter);
+static BallMask integrate_balls(Table* table);
+static void clamp_to_cushions(Table* table);
+KERNEL BallMask collide_balls(Table* table, int balls, int diameter);
+KERNEL bool resolve_ball_pair(Table* table, int i, int j, int diameter);
+static void pocket_balls(Table* table, BallMask candidates);
+KERNEL bool fast_forward_to_rest(Table* table, int diameter);
+KERNEL bool paths_clear(const Table* table, BallMask moving, const FixedPoint* from,
+                        const FixedPoint* to, const int64_t* margin, int diameter);
+static bool point_near_segment(CheckPoint a, CheckPoint b, CheckPoint p, int64_t dist);
+static bool segments_near(CheckPoint a, CheckPoint b, CheckPoint c, CheckPoint d, int64_t dist);
+static void store_view(Table* table, BallMask balls);
+static uint64_t end_stage(Table* table, PhysicsStage stage, uint64_t start);
+static uint64_t rate_pow(uint64_t x, int n);
+static uint64_t isqrt64(uint64_t n);
+static int32_t load_velocity(float v);
+
+// --- Variant Kernels ---
+// One integer step function per variant, as STEP_KERNELS in physics.c
+#define DEFINE_FIXED_KERNEL(id, name, balls, ballRadius, pocketRadius) \
+    static void fixed_step_##id(Table* table, uint64_t start) { fixed_step(table, start, balls, 2 * (ballRadius)); }
+TABLE_VARIANTS(DEFINE_FIXED_KERNEL)
+#undef DEFINE_FIXED_KERNEL
+
+#define FIXED_KERNEL_ENTRY(id, name, balls, ballRadius, pocketRadius) [id] = fixed_step_##id,
+static void (*const FIXED_KERNELS[VARIANT_COUNT])(Table* table, uint64_t start) = {TABLE_VARIANTS(FIXED_KERNEL_ENTRY)};
+#undef FIXED_KERNEL_ENTRY
+
+// --- Inline Helpers ---
+
+// Returns a * b >> bits, rounded half away from zero. |a * b| must fit in
+// 63 bits. For negative products the shift floors (p + half - 1), which is
+// exactly -round(-p), so no branch is needed.
+static inline int64_t mul_round(int64_t a, int64_t b, int bits) {
+    int64_t p = a * b;
+    return (p + ((int64_t)1 << (bits - 1)) - (p < 0)) >> bits;
+}
+
+// Returns true if ball i has no velocity
+static inline bool fixed_at_rest(const FixedState* fs, int i) {
+    return fs->vx[i] == 0 && fs->vy[i] == 0;
+}
+
+// Returns a point in check units
+static inline CheckPoint to_check(FixedPoint p) {
+    return (CheckPoint){p.x >> CHECK_SHIFT, p.y >> CHECK_SHIFT};
+}
+
+// Returns a distance in check units, rounded up and widened by CHECK_SLACK
+static inline int64_t check_dist(int64_t dist) {
+    return (dist >> CHECK_SHIFT) + 1 + CHECK_SLACK;
+}
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Derives the integer per-step constants from table->physicsHz;
+ * called by set_physics_rate().
+ * @param table The table to configure.
+ */
+void fixed_set_rate(Table* table) {
+    FixedState* fs = &table->fixed;
+    int num = BASE_PHYSICS_HZ;
+    int den = table->physicsHz;
+    fs->scale = ((int64_t)num << RATE_BITS) / den;
+
+    // stepFriction = FRICTION^(num/den): the largest x with x^den <= FRICTION^num
+    for (int a = num, b = den; b != 0;) {
+        int r = a % b;
+        a = b;
+        b = r;
+        if (b == 0) {
+            num /= a;
+            den /= a;
+        }
+    }
+    uint64_t target = rate_pow((uint64_t)(FRICTION * (float)RATE_ONE), num);
+    uint64_t lo = 0;
+    uint64_t hi = RATE_ONE - 1;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+        if (rate_pow(mid, den) <= target) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    fs->friction = (int64_t)lo;
+
+    // A ball left alone coasts scale * F / (1 - F) per unit of speed. Its
+    // rounded velocity strays by at most 0.5 / (1 - F) from the exact decay,
+    // and each step rounds its position by 0.5 more.
+    uint64_t rest = RATE_ONE - lo;
+    fs->travel = (int64_t)((((uint64_t)fs->scale * lo >> RATE_BITS) << TRAVEL_BITS) / rest) + 1;
+    uint64_t maxError = (RATE_ONE / 2) / rest + 1;
+    fs->drift = (int64_t)((maxError * (uint64_t)fs->scale + ((uint64_t)1 << STEP_SHIFT) - 1) >> STEP_SHIFT) + 1;
+}
+
+/**
+ * @brief Loads the integer state from the table's float arrays and
+ * geometry, then snaps the floats to it. Called by setup_table() and
+ * strike_cue_ball(), so edits to the float arrays between shots are picked
+ * up by the next shot. The scaling is exact, and rounding to the nearest
+ * integer is IEEE-defined, so every platform loads the same state.
+ * @param table The table to load.
+ */
+void fixed_load(Table* table) {
+    FixedState* fs = &table->fixed;
+    const TableGeometry* geo = &table->geometry;
+    for (int i = 0; i < BALL_LANES; ++i) {
+        fs->px[i] = (int32_t)lrintf(table->px[i] * (float)POS_ONE);
+        fs->py[i] = (int32_t)lrintf(table->py[i] * (float)POS_ONE);
+        fs->vx[i] = load_velocity(table->vx[i]);
+        fs->vy[i] = load_velocity(table->vy[i]);
+    }
+
+    fs->cushionX1 = (int32_t)lrintf(geo->cushionX1 * (float)POS_ONE);
+    fs->cushionY1 = (int32_t)lrintf(geo->cushionY1 * (float)POS_ONE);
+    fs->cushionX2 = (int32_t)lrintf(geo->cushionX2 * (float)POS_ONE);
+    fs->cushionY2 = (int32_t)lrintf(geo->cushionY2 * (float)POS_ONE);
+    for (int p = 0; p < NUM_POCKETS; ++p) {
+        fs->pocketX[p] = (int32_t)lrintf(geo->pockets[p].pos.x * (float)POS_ONE);
+        fs->pocketY[p] = (int32_t)lrintf(geo->pockets[p].pos.y * (float)POS_ONE);
+        fs->pocketRadiusSq[p] = (int64_t)(geo->pocketRadiusSq[p] * (float)(POS_ONE * POS_ONE));
+    }
+    fs->reachY1 = (int32_t)lrintf(geo->reachY1 * (float)POS_ONE);
+    fs->reachY2 = (int32_t)lrintf(geo->reachY2 * (float)POS_ONE);
+
+    for (int i = 0; i < BALL_LANES; ++i) {
+        table->px[i] = (float)fs->px[i] * (1.0f / POS_ONE);
+        table->py[i] = (float)fs->py[i] * (1.0f / POS_ONE);
+        table->vx[i] = (float)fs->vx[i] * (1.0f / VEL_ONE);
+        table->vy[i] = (float)fs->vy[i] * (1.0f / VEL_ONE);
+    }
+}
+
+/**
+ * @brief Advances a simulating table by one fixed step in integers: the
+ * same stages, sleep rules and fast-forward as the float path of update().
+ * @param table The table to step.
+ * @param start The tick count when the step began (0 if not profiled).
+ */
+void fixed_update(Table* table, uint64_t start) {
+    FIXED_KERNELS[table->variant](table, start);
+}
+
+/**
+ * @brief The body of fixed_update(), inlined into one step function per
+ * variant where balls and diameter are the variant's constants.
+ * @param table The table to step.
+ * @param start The tick count when the step began (0 if not profiled).
+ * @param balls The variant's ball count.
+ * @param diameter The variant's ball diameter.
+ */
+KERNEL void fixed_step(Table* table, uint64_t start, int balls, int diameter) {
+    // 1-3. Apply friction, update positions and stop slow balls
+    BallMask moving = integrate_balls(table);
+    start = end_stage(table, PHYS_STAGE_INTEGRATE, start);
+
+    // 4. Handle collision with cushions
+    clamp_to_cushions(table);
+    start = end_stage(table, PHYS_STAGE_CUSHIONS, start);
+
+    // 5. Handle ball-ball collisions
+    BallMask touched = collide_balls(table, balls, diameter);
+    start = end_stage(table, PHYS_STAGE_BALLS, start);
+
+    // 6. Handle pocketing
+    BallMask stepped = table->awake | touched; // Every ball this step can have changed
+    pocket_balls(table, stepped & table->active);
+    table->stepCount++;
+
+    // Integers have no -0, so a cushion reflection needs no extra step
+    table->awake = (moving | touched) & table->active;
+
+    if (moving == 0) {
+        table->state = STATE_AIMING;
+    } else if (table->fastForward && table->state == STATE_SIMULATING &&
+               table->stepCount % FAST_FORWARD_INTERVAL == 0) {
+        fast_forward_to_rest(table, diameter);
+    }
+    store_view(table, stepped);
+    end_stage(table, PHYS_STAGE_POCKETS, start);
+}
+
+/**
+ * @brief Copies balls' integer state to the table's float arrays. Positions
+ * convert exactly; velocities round to the nearest float.
+ * @param table The table to refresh.
+ * @param balls The balls whose state may have changed.
+ */
+static void store_view(Table* table, BallMask balls) {
+    const FixedState* fs = &table->fixed;
+    for (BallMask left = balls; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        table->px[i] = (float)fs->px[i] * (1.0f / POS_ONE);
+        table->py[i] = (float)fs->py[i] * (1.0f / POS_ONE);
+        table->vx[i] = (float)fs->vx[i] * (1.0f / VEL_ONE);
+        table->vy[i] = (float)fs->vy[i] * (1.0f / VEL_ONE);
+    }
+}
+
+/**
+ * @brief Adds the ticks since start to a stage's total, if the table is
+ * being profiled.
+ * @return The current tick count, i.e. the start of the next stage.
+ */
+static uint64_t end_stage(Table* table, PhysicsStage stage, uint64_t start) {
+    if (table->profileClock == NULL) {
+        return 0;
+    }
+    uint64_t now = table->profileClock();
+    table->stageTicks[stage] += now - start;
+    return now;
+}
+
+
+// --- Integer Kernels ---
+// Plain scalar loops over the awake balls. Every product needs 64 bits
+// (velocity times a 32-bit factor), so they gain nothing from 32-bit SIMD
+// lanes; skipping sleeping balls is what keeps them cheap.
+
+/**
+ * @brief Applies one step of friction, moves every awake ball and stops
+ * balls slower than MIN_VELOCITY, as integrate_balls() in physics.c.
+ * @return The balls that are still moving after this step.
+ */
+static BallMask integrate_balls(Table* table) {
+    FixedState* fs = &table->fixed;
+    const int64_t minSpeedSq = MIN_SPEED * MIN_SPEED;
+    BallMask moving = 0;
+    for (BallMask left = table->awake; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        int64_t vx = mul_round(fs->vx[i], fs->friction, RATE_BITS);
+        int64_t vy = mul_round(fs->vy[i], fs->friction, RATE_BITS);
+        fs->px[i] += (int32_t)mul_round(vx, fs->scale, STEP_SHIFT);
+        fs->py[i] += (int32_t)mul_round(vy, fs->scale, STEP_SHIFT);
+        if (vx * vx + vy * vy < minSpeedSq) {
+            vx = 0;
+            vy = 0;
+        } else {
+            moving |= (BallMask)1 << i;
+        }
+        fs->vx[i] = (int32_t)vx;
+        fs->vy[i] = (int32_t)vy;
+    }
+    return moving;
+}
+
+/**
+ * @brief Clamps awake balls to the cushions, reflecting their velocity, and
+ * records a cushion event for each ball that crossed one.
+ */
+static void clamp_to_cushions(Table* table) {
+    FixedState* fs = &table->fixed;
+    for (BallMask left = table->awake; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        bool hit = true;
+        if (fs->px[i] < fs->cushionX1) { fs->px[i] = fs->cushionX1; fs->vx[i] = -fs->vx[i]; }
+        else if (fs->px[i] > fs->cushionX2) { fs->px[i] = fs->cushionX2; fs->vx[i] = -fs->vx[i]; }
+        else hit = false;
+        if (fs->py[i] < fs->cushionY1) { fs->py[i] = fs->cushionY1; fs->vy[i] = -fs->vy[i]; hit = true; }
+        else if (fs->py[i] > fs->cushionY2) { fs->py[i] = fs->cushionY2; fs->vy[i] = -fs->vy[i]; hit = true; }
+        if (hit) {
+            record_shot_event(table, SHOT_EVENT_CUSHION, i, 0);
+        }
+    }
+}
+
+/**
+ * @brief Finds and resolves overlapping balls with the same sweep and prune
+ * broad phase as collide_balls() in physics.c.
+ * @return The balls that were moved apart from another ball.
+ */
+KERNEL BallMask collide_balls(Table* table, int balls, int diameter) {
+    const FixedState* fs = &table->fixed;
+    uint8_t* order = table->sweepOrder;
+    for (int k = 1; k < balls; ++k) {
+        uint8_t id = order[k];
+        int32_t x = fs->px[id];
+        int m = k - 1;
+        while (m >= 0 && fs->px[order[m]] > x) {
+            order[m + 1] = order[m];
+            m--;
+        }
+        order[m + 1] = id;
+    }
+
+    int lastMoving = balls - 1;
+    while (lastMoving >= 0 && fixed_at_rest(fs, order[lastMoving])) {
+        lastMoving--;
+    }
+
+    int tested = 0;
+    BallMask touched = 0;
+    for (int k = 0; k < balls; ++k) {
+        int i = order[k];
+        if (!ball_active(table, i)) continue;
+        if (k >= lastMoving && fixed_at_rest(fs, i)) continue;
+
+        int32_t maxX = fs->px[i] + (int32_t)(diameter * POS_ONE);
+        for (int m = k + 1; m < balls; ++m) {
+            int j = order[m];
+            if (fs->px[j] >= maxX) break;
+            if (!ball_active(table, j)) continue;
+            if (fixed_at_rest(fs, i) && fixed_at_rest(fs, j)) continue;
+
+            tested++;
+            if (resolve_ball_pair(table, i, j, diameter)) {
+                touched |= ((BallMask)1 << i) | ((BallMask)1 << j);
+                if (m > lastMoving && !fixed_at_rest(fs, j)) lastMoving = m;
+                if ((i == 0 || j == 0) && table->shot.firstContact < 0) {
+                    record_shot_event(table, SHOT_EVENT_CONTACT, 0, i + j);
+                }
+            }
+        }
+    }
+
+    int activeCount = ball_count(table->active);
+    int culled = activeCount * (activeCount - 1) / 2 - tested;
+    table->collisions.pairsTested = tested;
+    table->collisions.pairsCulled = culled;
+    table->collisions.totalTested += tested;
+    table->collisions.totalCulled += culled;
+    return touched;
+}
+
+/**
+ * @brief Separates two balls and exchanges their velocity along the contact
+ * normal if they overlap. Balls at exactly the same spot are pushed apart
+ * along x.
+ * @return true if the balls overlapped.
+ */
+KERNEL bool resolve_ball_pair(Table* table, int i, int j, int diameter) {
+    FixedState* fs = &table->fixed;
+    const int64_t contact = diameter * POS_ONE;
+    int64_t dx = (int64_t)fs->px[j] - fs->px[i];
+    int64_t dy = (int64_t)fs->py[j] - fs->py[i];
+    int64_t distSq = dx * dx + dy * dy;
+    if (distSq >= contact * contact) {
+        return false;
+    }
+
+    int64_t dist = (int64_t)isqrt64((uint64_t)distSq);
+    int64_t nx = NORMAL_ONE;
+    int64_t ny = 0;
+    if (dist > 0) {
+        nx = (dx << NORMAL_BITS) / dist;
+        ny = (dy << NORMAL_BITS) / dist;
+    }
+
+    // Static resolution (move balls apart)
+    int64_t overlap = (contact - dist) / 2;
+    int32_t sx = (int32_t)mul_round(overlap, nx, NORMAL_BITS);
+    int32_t sy = (int32_t)mul_round(overlap, ny, NORMAL_BITS);
+    fs->px[i] -= sx;
+    fs->py[i] -= sy;
+    fs->px[j] += sx;
+    fs->py[j] += sy;
+
+    // Dynamic resolution (exchange velocity along the normal)
+    int64_t p1 = mul_round(fs->vx[i], nx, NORMAL_BITS) + mul_round(fs->vy[i], ny, NORMAL_BITS);
+    int64_t p2 = mul_round(fs->vx[j], nx, NORMAL_BITS) + mul_round(fs->vy[j], ny, NORMAL_BITS);
+    int32_t ex = (int32_t)mul_round(p2 - p1, nx, NORMAL_BITS);
+    int32_t ey = (int32_t)mul_round(p2 - p1, ny, NORMAL_BITS);
+    fs->vx[i] += ex;
+    fs->vy[i] += ey;
+    fs->vx[j] -= ex;
+    fs->vy[j] -= ey;
+    return true;
+}
+
+/**
+ * @brief Pockets candidate balls within a pocket's radius. Balls near
+ * neither long rail are out of reach and skipped.
+ * @param table The table to check.
+ * @param candidates The balls that may have moved this step.
+ */
+static void pocket_balls(Table* table, BallMask candidates) {
+    FixedState* fs = &table->fixed;
+    for (BallMask left = candidates; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        if (fs->py[i] > fs->reachY1 && fs->py[i] < fs->reachY2) continue;
+
+        for (int p = 0; p < NUM_POCKETS; ++p) {
+            int64_t dx = (int64_t)fs->pocketX[p] - fs->px[i];
+            int64_t dy = (int64_t)fs->pocketY[p] - fs->py[i];
+            if (dx * dx + dy * dy < fs->pocketRadiusSq[p]) {
+                // Pocketed balls keep their last position but stop moving
+                table->active &= ~((BallMask)1 << i);
+                fs->vx[i] = 0;
+                fs->vy[i] = 0;
+                record_shot_event(table, SHOT_EVENT_POCKET, i, p);
+                break;
+            }
+        }
+    }
+}
+
+
+// --- Exact Fast-Forward ---
+
+/**
+ * @brief Jumps every moving ball straight to where it comes to rest, if
+ * nothing can interrupt it on the way. Unlike the float closed form, the
+ * resting positions come from running each ball's integer friction steps on
+ * their own, so a fast-forwarded shot ends bit for bit where stepping it
+ * would have.
+ *
+ * Rounding bends a path slightly off the straight segment between its ends,
+ * so the pocket and ball tests are widened by FixedState.drift per step
+ * (each coordinate still moves monotonically, so the segment's bounding box
+ * holds the whole path, and the cushion test is exact). A cheap test of
+ * the furthest each ball could coast runs first, so the exact steps are
+ * only followed when the table is likely quiet.
+ * @param table The table to fast-forward.
+ * @param diameter The variant's ball diameter.
+ * @return true if the table was fast-forwarded to rest.
+ */
+KERNEL bool fast_forward_to_rest(Table* table, int diameter) {
+    FixedState* fs = &table->fixed;
+    const int64_t minSpeedSq = MIN_SPEED * MIN_SPEED;
+    const int maxSteps = MAX_SHOT_SECONDS * table->physicsHz;
+
+    BallMask moving = 0;
+    for (BallMask left = table->active; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        if (!fixed_at_rest(fs, i)) moving |= (BallMask)1 << i;
+    }
+    if (moving == 0) return false; // The next step notices on its own
+
+    FixedPoint from[MAX_BALLS];
+    FixedPoint to[MAX_BALLS];
+    int64_t margin[MAX_BALLS];
+    for (BallMask left = table->active; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        from[i] = (FixedPoint){fs->px[i], fs->py[i]};
+        to[i] = from[i];
+        margin[i] = 0;
+    }
+    for (BallMask left = moving; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        to[i].x += (int32_t)mul_round(fs->vx[i], fs->travel, TRAVEL_SHIFT);
+        to[i].y += (int32_t)mul_round(fs->vy[i], fs->travel, TRAVEL_SHIFT);
+        margin[i] = POS_ONE;
+    }
+    if (!paths_clear(table, moving, from, to, margin, diameter)) {
+        return false;
+    }
+
+    int stepsToRest = 0;
+    for (BallMask left = moving; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        int64_t px = fs->px[i], py = fs->py[i];
+        int64_t vx = fs->vx[i], vy = fs->vy[i];
+        int n = 0;
+        do {
+            vx = mul_round(vx, fs->friction, RATE_BITS);
+            vy = mul_round(vy, fs->friction, RATE_BITS);
+            px += mul_round(vx, fs->scale, STEP_SHIFT);
+            py += mul_round(vy, fs->scale, STEP_SHIFT);
+            n++;
+        } while (vx * vx + vy * vy >= minSpeedSq && n <= maxSteps);
+        if (n > maxSteps) return false;
+
+        to[i] = (FixedPoint){(int32_t)px, (int32_t)py};
+        margin[i] = 3 * n * fs->drift; // Both ends and the path, ~2 sqrt(2) each
+        if (n > stepsToRest) stepsToRest = n;
+    }
+    if (!paths_clear(table, moving, from, to, margin, diameter)) {
+        return false;
+    }
+
+    for (BallMask left = moving; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        fs->px[i] = to[i].x;
+        fs->py[i] = to[i].y;
+        fs->vx[i] = 0;
+        fs->vy[i] = 0;
+    }
+    table->stepCount += stepsToRest;
+    table->fastForwardSteps += stepsToRest;
+    table->awake = 0;
+    table->state = STATE_AIMING;
+    return true;
+}
+
+/**
+ * @brief Tests whether balls moving along straight paths stay clear of the
+ * cushions, the pockets and each other.
+ * @param table The table, with the balls at the start of their paths.
+ * @param moving The balls with a path; every other active ball stays where
+ * it is.
+ * @param from Path starts, indexed by ball id.
+ * @param to Path ends.
+ * @param margin How far each path may stray from its segment.
+ * @param diameter The variant's ball diameter.
+ * @return true if no ball can touch a cushion, pocket or other ball.
+ */
+KERNEL bool paths_clear(const Table* table, BallMask moving, const FixedPoint* from,
+                        const FixedPoint* to, const int64_t* margin, int diameter) {
+    const FixedState* fs = &table->fixed;
+    for (BallMask left = moving; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        int32_t minX = from[i].x < to[i].x ? from[i].x : to[i].x;
+        int32_t maxX = from[i].x < to[i].x ? to[i].x : from[i].x;
+        int32_t minY = from[i].y < to[i].y ? from[i].y : to[i].y;
+        int32_t maxY = from[i].y < to[i].y ? to[i].y : from[i].y;
+        if (minX < fs->cushionX1 || maxX > fs->cushionX2 ||
+            minY < fs->cushionY1 || maxY > fs->cushionY2) {
+            return false;
+        }
+        if (minY - margin[i] > fs->reachY1 && maxY + margin[i] < fs->reachY2) continue;
+
+        for (int p = 0; p < NUM_POCKETS; ++p) {
+            int64_t radius = (int64_t)isqrt64((uint64_t)fs->pocketRadiusSq[p]) + 1;
+            CheckPoint pocket = to_check((FixedPoint){fs->pocketX[p], fs->pocketY[p]});
+            if (point_near_segment(to_check(from[i]), to_check(to[i]), pocket,
+                                   check_dist(radius + margin[i]))) {
+                return false;
+            }
+        }
+    }
+
+    for (BallMask left = moving; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        for (BallMask others = table->active & ~((BallMask)1 << i); others != 0; others &= others - 1) {
+            int j = lowest_ball(others);
+            if (((moving >> j) & 1u) && j < i) continue; // Moving pairs once
+            if (segments_near(to_check(from[i]), to_check(to[i]), to_check(from[j]), to_check(to[j]),
+                              check_dist(diameter * POS_ONE + margin[i] + margin[j]))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns true if point p is closer than dist to segment ab.
+ */
+static bool point_near_segment(CheckPoint a, CheckPoint b, CheckPoint p, int64_t dist) {
+    int64_t abx = b.x - a.x, aby = b.y - a.y;
+    int64_t apx = p.x - a.x, apy = p.y - a.y;
+    int64_t distSq = dist * dist;
+    int64_t t = apx * abx + apy * aby;
+    if (t <= 0) {
+        return apx * apx + apy * apy < distSq;
+    }
+    int64_t lenSq = abx * abx + aby * aby;
+    if (t >= lenSq) {
+        int64_t bpx = p.x - b.x, bpy = p.y - b.y;
+        return bpx * bpx + bpy * bpy < distSq;
+    }
+    int64_t cross = abx * apy - aby * apx;
+    return cross * cross < distSq * lenSq;
+}
+
+/**
+ * @brief Returns true if segments ab and cd cross or come closer than dist.
+ */
+static bool segments_near(CheckPoint a, CheckPoint b, CheckPoint c, CheckPoint d, int64_t dist) {
+    // Proper crossing: c and d on opposite sides of ab, and a and b of cd
+    int64_t d1 = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    int64_t d2 = (b.x - a.x) * (d.y - a.y) - (b.y - a.y) * (d.x - a.x);
+    int64_t d3 = (d.x - c.x) * (a.y - c.y) - (d.y - c.y) * (a.x - c.x);
+    int64_t d4 = (d.x - c.x) * (b.y - c.y) - (d.y - c.y) * (b.x - c.x);
+    if (((d1 < 0) != (d2 < 0)) && ((d3 < 0) != (d4 < 0))) {
+        return true;
+    }
+    return point_near_segment(a, b, c, dist) || point_near_segment(a, b, d, dist) ||
+           point_near_segment(c, d, a, dist) || point_near_segment(c, d, b, dist);
+}
+
+
+// --- Integer Math ---
+
+/**
+ * @brief Raises a factor with RATE_BITS fractional bits (below 1) to the
+ * n-th power by squaring, rounding every product to nearest.
+ */
+static uint64_t rate_pow(uint64_t x, int n) {
+    uint64_t result = RATE_ONE;
+    while (n > 0) {
+        if (n & 1) {
+            result = (result * x + RATE_ONE / 2) >> RATE_BITS;
+        }
+        x = (x * x + RATE_ONE / 2) >> RATE_BITS;
+        n >>= 1;
+    }
+    return result;
+}
+
+/**
+ * @brief Converts a float velocity component to 20 fractional bits. A
+ * value the integers cannot hold (only possible if a table was edited past
+ * MAX_CUE_SPEED) saturates instead of wrapping, and NaN loads as 0.
+ */
+static int32_t load_velocity(float v) {
+    float scaled = v * (float)VEL_ONE;
+    if (isnan(scaled)) {
+        return 0;
+    }
+    if (scaled <= -(float)MAX_VELOCITY_FIXED) return -(int32_t)MAX_VELOCITY_FIXED;
+    if (scaled >= (float)MAX_VELOCITY_FIXED) return (int32_t)MAX_VELOCITY_FIXED;
+    return (int32_t)lrintf(scaled);
+}
+
+/**
+ * @brief Returns floor(sqrt(n)), computed bit by bit.
+ */
+static uint64_t isqrt64(uint64_t n) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > n) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+#endif
@@ -0,0 +1,305 @@
+// -----------------------------------------------------------------------------
+// Headless batch shot runner for the 8-Ball Pool Game
+//
+// Simulates shots read from a file without creating a window or renderer.
+// Each shot is played from the standard rack until every ball is at rest.
+//
+// Shot file format: one shot per line, "<angle> <power>", where angle is the
+// direction of cue ball travel in degrees (screen coordinates, so 90 points
+// down) and power is the cue ball's initial speed in table units per base frame.
+// Blank lines and lines starting with '#' are ignored.
+// -----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "physics.h"
+#include "simpool.h"
+#include "trajlog.h"
+#include "shotcache.h"
+#include "rules.h"
+#include "headless.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Everything a headless run simulates with, plus per-batch scratch space
+typedef struct {
+    const Table* rack;
+    SimPool* pool;
+    TrajWriter* traj;   // Trajectory log, or NULL
+    ShotCache* cache;   // Outcome cache, or NULL
+    Shot* shots;
+    Vec2D* cues;
+    ShotResult* results;
+    ShotKey* keys;      // Cache scratch: each shot's key
+    int* misses;        // Cache scratch: indices of the shots to simulate
+    Vec2D* missCues;
+    ShotResult* missResults;
+} HeadlessRun;
+
+// --- Function Prototypes ---
+static void run_batch(HeadlessRun* run, int count, FILE* out, int firstIndex);
+static void run_cached(HeadlessRun* run, int count);
+static void free_run(HeadlessRun* run);
+static void write_result(FILE* out, int index, Shot shot, const Table* table, int steps);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Runs every shot in a shot file and writes the outcome of each.
+ * Shots are read in batches of HEADLESS_BATCH_SIZE and simulated in
+ * parallel; results are written in file order. With a trajectory log, shots
+ * are instead simulated one after another, with update() every step, and
+ * each step is logged (so fast-forward does not apply). With an outcome
+ * cache, shots that quantize to an earlier shot reuse its outcome; cache
+ * counters are printed to stderr at the end.
+ * @param shotsPath Path of the shot file to read.
+ * @param outPath Path of the results file, or NULL for stdout.
+ * @param trajPath Path of a trajectory log to write, or NULL for none.
+ * @param rack The racked table every shot is played from; its physics rate
+ * and solver apply to every shot.
+ * @param numThreads Simulation threads; 0 means one per CPU core.
+ * @param cacheBytes Memory cap of the outcome cache; 0 for no cache. Not
+ * used with a trajectory log.
+ * @return 0 on success, 1 on failure (suitable as a process exit code).
+ */
+int run_headless(const char* shotsPath, const char* outPath, const char* trajPath,
+                 const Table* rack, int numThreads, size_t cacheBytes) {
+    FILE* in = fopen(shotsPath, "r");
+    if (in == NULL) {
+        printf("Could not open shot file '%s'!\n", shotsPath);
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (outPath != NULL) {
+        out = fopen(outPath, "w");
+        if (out == NULL) {
+            printf("Could not open output file '%s'!\n", outPath);
+            fclose(in);
+            return 1;
+        }
+    }
+
+    HeadlessRun run = {0};
+    run.rack = rack;
+    run.shots = malloc(HEADLESS_BATCH_SIZE * sizeof(Shot));
+    run.cues = malloc(HEADLESS_BATCH_SIZE * sizeof(Vec2D));
+    run.results = malloc(HEADLESS_BATCH_SIZE * sizeof(ShotResult));
+    run.pool = simpool_create(numThreads);
+    bool ok = run.shots != NULL && run.cues != NULL && run.results != NULL && run.pool != NULL;
+    if (ok && trajPath == NULL && cacheBytes > 0) {
+        run.cache = shotcache_create(cacheBytes);
+        run.keys = malloc(HEADLESS_BATCH_SIZE * sizeof(ShotKey));
+        run.misses = malloc(HEADLESS_BATCH_SIZE * sizeof(int));
+        run.missCues = malloc(HEADLESS_BATCH_SIZE * sizeof(Vec2D));
+        run.missResults = malloc(HEADLESS_BATCH_SIZE * sizeof(ShotResult));
+        ok = run.cache != NULL && run.keys != NULL && run.misses != NULL &&
+             run.missCues != NULL && run.missResults != NULL;
+    }
+    if (!ok) {
+        printf("Out of memory!\n");
+    }
+    if (ok && trajPath != NULL) {
+        run.traj = trajlog_create(trajPath, rack);
+        ok = run.traj != NULL;
+    }
+    if (!ok) {
+        free_run(&run);
+        fclose(in);
+        if (out != stdout) fclose(out);
+        return 1;
+    }
+
+    int lineNumber = 0;
+    int shotCount = 0;
+    int pending = 0;
+    int status = 0;
+    int read;
+    while ((read = read_shot(in, shotsPath, &lineNumber, &run.shots[pending])) != 0) {
+        if (read < 0) {
+            status = 1;
+            break;
+        }
+        if (++pending == HEADLESS_BATCH_SIZE) {
+            run_batch(&run, pending, out, shotCount + 1);
+            shotCount += pending;
+            pending = 0;
+        }
+    }
+    run_batch(&run, pending, out, shotCount + 1);
+
+    if (run.traj != NULL && !trajlog_close(run.traj)) {
+        status = 1;
+    }
+    run.traj = NULL;
+    if (run.cache != NULL) {
+        ShotCacheStats stats = shotcache_stats(run.cache);
+        fprintf(stderr, "cache hits %llu misses %llu evictions %llu entries %d/%d\n",
+                (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+                (unsigned long long)stats.evictions, stats.entries, stats.capacity);
+    }
+    free_run(&run);
+    fclose(in);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return status;
+}
+
+/**
+ * @brief Reads the next shot from a shot file, skipping blank lines and
+ * comments.
+ * @param in The shot file.
+ * @param path The file's path, for error messages.
+ * @param lineNumber The number of the last line read; advanced past the shot.
+ * @param shot Receives the shot.
+ * @return 1 if a shot was read, 0 at the end of the file, -1 on a malformed
+ * line or a shot that is not valid_cue() (reported on stdout).
+ */
+int read_shot(FILE* in, const char* path, int* lineNumber, Shot* shot) {
+    char line[256];
+    while (fgets(line, sizeof(line), in) != NULL) {
+        (*lineNumber)++;
+
+        char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+
+        if (sscanf(p, "%f %f", &shot->angle, &shot->power) != 2) {
+            printf("%s:%d: expected '<angle> <power>'\n", path, *lineNumber);
+            return -1;
+        }
+        if (!valid_cue(shot_cue(*shot))) {
+            printf("%s:%d: power must be a number up to %.0f\n", path, *lineNumber, MAX_CUE_SPEED);
+            return -1;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns the cue ball velocity a shot plays.
+ */
+Vec2D shot_cue(Shot shot) {
+    float radians = shot.angle * (float)M_PI / 180.0f;
+    return (Vec2D){cosf(radians) * shot.power, sinf(radians) * shot.power};
+}
+
+/**
+ * @brief Simulates a batch of shots on the pool (or, when logging
+ * trajectories, on this thread) and writes their results.
+ * @param run The run, with the batch in run->shots.
+ * @param count The number of shots.
+ * @param out The stream to write results to.
+ * @param firstIndex The 1-based shot number of run->shots[0].
+ */
+static void run_batch(HeadlessRun* run, int count, FILE* out, int firstIndex) {
+    for (int i = 0; i < count; ++i) {
+        run->cues[i] = shot_cue(run->shots[i]);
+    }
+
+    if (run->traj != NULL) {
+        for (int i = 0; i < count; ++i) {
+            trajlog_record_shot(run->traj, run->rack, run->cues[i], &run->results[i].table, &run->results[i].steps);
+        }
+    } else if (run->cache != NULL) {
+        run_cached(run, count);
+    } else {
+        simpool_run(run->pool, run->rack, run->cues, run->results, count);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        write_result(out, firstIndex + i, run->shots[i], &run->results[i].table, run->results[i].steps);
+    }
+}
+
+/**
+ * @brief Fills a batch's results through the outcome cache: hits are
+ * loaded from it, the misses are simulated on the pool and then cached.
+ * @param run The run, with the batch's cue velocities in run->cues.
+ * @param count The number of shots.
+ */
+static void run_cached(HeadlessRun* run, int count) {
+    int missCount = 0;
+    for (int i = 0; i < count; ++i) {
+        ShotOutcome outcome;
+        ShotResult* result = &run->results[i];
+        shotcache_make_key(&run->keys[i], run->rack, run->cues[i]);
+        if (shotcache_lookup(run->cache, &run->keys[i], &outcome)) {
+            result->table = *run->rack;
+            result->steps = shotcache_load_outcome(&outcome, &result->table);
+        } else {
+            run->misses[missCount] = i;
+            run->missCues[missCount] = run->cues[i];
+            missCount++;
+        }
+    }
+
+    simpool_run(run->pool, run->rack, run->missCues, run->missResults, missCount);
+
+    for (int m = 0; m < missCount; ++m) {
+        int i = run->misses[m];
+        ShotOutcome outcome;
+        run->results[i] = run->missResults[m];
+        shotcache_save_outcome(&outcome, &run->results[i].table, run->results[i].steps);
+        shotcache_insert(run->cache, &run->keys[i], &outcome);
+    }
+}
+
+/**
+ * @brief Frees everything a run allocated (members may be NULL).
+ */
+static void free_run(HeadlessRun* run) {
+    if (run->traj != NULL) trajlog_close(run->traj);
+    shotcache_destroy(run->cache);
+    simpool_destroy(run->pool);
+    free(run->missResults);
+    free(run->missCues);
+    free(run->misses);
+    free(run->keys);
+    free(run->results);
+    free(run->cues);
+    free(run->shots);
+}
+
+/**
+ * @brief Writes one shot's outcome: a summary line, the steps skipped by
+ * fast-forward, the broad-phase pair counts, the rules' verdict on it as a
+ * break, the pocketed balls and the final state of every ball.
+ * @param out The stream to write to.
+ * @param index The 1-based shot number.
+ * @param shot The shot that was played.
+ * @param table The table after the shot.
+ * @param steps The number of physics steps it took.
+ */
+static void write_result(FILE* out, int index, Shot shot, const Table* table, int steps) {
+    const char* state = table->state == STATE_SIMULATING ? "timeout" : "rest";
+    Match match;
+    rules_start(&match, 0);
+    ShotVerdict verdict = rules_judge(&match, table);
+
+    fprintf(out, "shot %d angle %.3f power %.3f steps %d state %s\n", index, shot.angle, shot.power, steps, state);
+    fprintf(out, "fast_forward %llu\n", (unsigned long long)table->fastForwardSteps);
+    fprintf(out, "pairs tested %llu culled %llu\n",
+            (unsigned long long)table->collisions.totalTested, (unsigned long long)table->collisions.totalCulled);
+    fprintf(out, "rules first_contact %d cushions %d foul %s keeps_turn %d\n", table->shot.firstContact,
+            ball_count(table->shot.cushioned), foul_name(verdict.foul), verdict.keepsTurn ? 1 : 0);
+
+    fprintf(out, "pocketed");
+    for (int i = 0; i < table->ballCount; ++i) {
+        if (!ball_active(table, i)) {
+            fprintf(out, " %d", i);
+        }
+    }
+    fprintf(out, "\n");
+
+    for (int i = 0; i < table->ballCount; ++i) {
+        fprintf(out, "ball %d %d %.3f %.3f %.3f %.3f\n", i, ball_active(table, i) ? 1 : 0,
+                table->px[i], table->py[i], table->vx[i], table->vy[i]);
+    }
+}
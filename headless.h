@@ -0,0 +1,27 @@
+// -----------------------------------------------------------------------------
+// Headless batch shot runner for the 8-Ball Pool Game
+// -----------------------------------------------------------------------------
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "physics.h"
+
+// Shots read and simulated in parallel at a time
+#define HEADLESS_BATCH_SIZE 4096
+
+// A single shot, as read from a shot file
+typedef struct {
+    float angle; // Direction of cue ball travel in degrees (0 = +x, 90 = +y)
+    float power; // Initial cue ball speed in table units per base frame
+} Shot;
+
+// --- Function Prototypes ---
+int run_headless(const char* shotsPath, const char* outPath, const char* trajPath,
+                 const Table* rack, int numThreads, size_t cacheBytes);
+int read_shot(FILE* in, const char* path, int* lineNumber, Shot* shot);
+Vec2D shot_cue(Shot shot);
+
+#endif
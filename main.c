@@ -11,74 +11,246 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_ttf.h> // For drawing text later
-
-// --- Constants ---
-#define SCREEN_WIDTH 1000
-#define SCREEN_HEIGHT 500
-#define TABLE_WIDTH 900
-#define TABLE_HEIGHT 450
-#define BALL_RADIUS 15
-#define BALL_DIAMETER (BALL_RADIUS * 2)
-#define NUM_BALLS 16
-#define POCKET_RADIUS 30
-#define CUSHION_WIDTH 25
-
-// Physics constants
-#define FRICTION 0.99f   // Slightly higher friction to slow balls a bit more
-#define CUE_POWER_MULTIPLIER 0.15f
-#define MIN_VELOCITY 0.1f
-
-// --- Data Structures ---
-
-// A simple 2D vector
-typedef struct {
-    float x;
-    float y;
-} Vec2D;
-
-// Represents a single pool ball
-typedef struct {
-    int id;
-    bool isActive;
-    Vec2D pos;
-    Vec2D vel;
-    SDL_Color color;
-} Ball;
-
-// Represents the six pockets on the table
+#include <SDL2/SDL_ttf.h>
+#include "physics.h"
+#include "headless.h"
+#include "profiler.h"
+#include "replay.h"
+#include "trajlog.h"
+#include "ai.h"
+#include "preview.h"
+#include "netplay.h"
+#include "broadcast.h"
+#include "assetpack.h"
+#include "text.h"
+#include "rules.h"
+#include "arena.h"
+
+// The table is shown in a view of VIEW_WIDTH x VIEW_HEIGHT table units with
+// the felt centered in it (the original fixed window). The view is scaled
+// uniformly to fit the window and letterboxed in the rail color.
+#define VIEW_WIDTH 1000
+#define VIEW_HEIGHT 500
+#define VIEW_TABLE_X ((VIEW_WIDTH - TABLE_WIDTH) / 2) // Felt corner in the view
+#define VIEW_TABLE_Y ((VIEW_HEIGHT - TABLE_HEIGHT) / 2)
+#define MIN_WINDOW_WIDTH 320
+#define MIN_WINDOW_HEIGHT 160
+#define BALL_OUTLINE 2 // Ball outline width in table units
+
+// Define LEGACY_RENDER (e.g. `make LEGACY_RENDER=1`) to draw balls and pockets
+// pixel by pixel every frame instead of using the sprite cache.
+//
+// Define GEOMETRY_RENDER (e.g. `make GEOMETRY_RENDER=1`) to draw the balls
+// and aim lines as one batch of textured triangles per frame, with a single
+// SDL_RenderGeometry() call (needs SDL 2.0.18), instead of one sprite copy
+// or line per object.
+#if defined(LEGACY_RENDER) && defined(GEOMETRY_RENDER)
+#error "LEGACY_RENDER and GEOMETRY_RENDER are alternatives"
+#endif
+
+#ifdef GEOMETRY_RENDER
+#define DISC_SEGMENTS 24 // Triangles per tessellated ball
+#define ATLAS_BODY 0     // Atlas cells: a white ball with its outline,
+#define ATLAS_STRIPE 1   // the stripe band alone
+#define ATLAS_WHITE 2    // and solid white for untextured lines
+#define ATLAS_CELLS 3
+#define MAX_BATCH_DISCS (MAX_BALLS * 2) // Striped balls take two
+#define MAX_BATCH_LINES (3 * PREVIEW_MAX_POINTS + 1) // Aim preview paths and the cue
+#define MAX_BATCH_VERTICES (MAX_BATCH_DISCS * (DISC_SEGMENTS + 1) + MAX_BATCH_LINES * 4)
+#define MAX_BATCH_INDICES (MAX_BATCH_DISCS * DISC_SEGMENTS * 3 + MAX_BATCH_LINES * 6)
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MAX_FRAME_TIME 0.25 // Seconds of simulation caught up per frame at most
+
+// Scratch memory for drawing one frame; every loop gives it back at the top
+// of each iteration, so frames never allocate from the heap
+#define FRAME_ARENA_BYTES (64 * 1024)
+
+// While nothing moves the game loop sleeps until an event arrives, waking
+// every WORKER_POLL_MS for results from the aim preview or the computer
+// opponent, or else every IDLE_TIMEOUT_MS
+#define IDLE_TIMEOUT_MS 500
+#define WORKER_POLL_MS 5
+
+// Assets the game looks for in its asset pack
+#define ASSET_FONT "font.ttf" // Text and profiler overlay font
+
+// Text heights in table units
+#define GAME_OVER_TEXT_SIZE 40 // Game-over message
+#define HUD_TEXT_SIZE 20       // Whose turn it is
+
+#define AI_PLAYER 1 // The computer's seat in the match; the human breaks
+
+// Pool ball colors, indexed by ball id
+static const SDL_Color BALL_COLORS[16] = {
+    {255, 255, 255, 255}, // 0: Cue ball
+    {255, 215, 0, 255},   // 1: Yellow (Solid)
+    {0, 0, 255, 255},     // 2: Blue (Solid)
+    {255, 0, 0, 255},     // 3: Red (Solid)
+    {75, 0, 130, 255},    // 4: Purple (Solid)
+    {255, 165, 0, 255},   // 5: Orange (Solid)
+    {0, 128, 0, 255},     // 6: Green (Solid)
+    {128, 0, 0, 255},     // 7: Maroon (Solid)
+    {0, 0, 0, 255},       // 8: Black
+    {255, 215, 0, 255},   // 9: Yellow (Stripe)
+    {0, 0, 255, 255},     // 10: Blue (Stripe)
+    {255, 0, 0, 255},     // 11: Red (Stripe)
+    {75, 0, 130, 255},    // 12: Purple (Stripe)
+    {255, 165, 0, 255},   // 13: Orange (Stripe)
+    {0, 128, 0, 255},     // 14: Green (Stripe)
+    {128, 0, 0, 255}      // 15: Maroon (Stripe)
+};
+
+// Snooker ball colors: the reds (ids 1-15), then the colors from id 16 in
+// racking order
+static const SDL_Color SNOOKER_COLORS[7] = {
+    {200, 0, 0, 255},     // Red
+    {255, 215, 0, 255},   // 16: Yellow
+    {0, 128, 0, 255},     // 17: Green
+    {120, 70, 20, 255},   // 18: Brown
+    {0, 0, 255, 255},     // 19: Blue
+    {255, 105, 180, 255}, // 20: Pink
+    {0, 0, 0, 255}        // 21: Black
+};
+
+// How table units map to output pixels, and the sprite metrics at that
+// scale. At scale 1 the sprites have the pixels of the original drawing code.
 typedef struct {
-    Vec2D pos;
-} Pocket;
-
-// Enum for different game states
-typedef enum {
-    STATE_AIMING,
-    STATE_SIMULATING,
-    STATE_GAME_OVER
-} GameState;
+    int outputWidth;  // Renderer output in pixels (more than the window's
+    int outputHeight; // size on high-DPI displays)
+    float scale;      // Pixels per table unit
+    float originX;    // Pixel position of the felt's top-left corner
+    float originY;
+    int ballRadius;   // Ball body radius in pixels
+    int ballHalf;     // Ball sprite half size: the body plus its outline
+    int ballSize;
+    int pocketRadius;
+    int pocketSize;
+} Layout;
 
 // --- Global Variables ---
 SDL_Window* gWindow = NULL;
 SDL_Renderer* gRenderer = NULL;
-Ball gBalls[NUM_BALLS];
-Pocket gPockets[6];
-GameState gCurrentState = STATE_AIMING;
+Table gTable;
 bool gGameIsRunning = true;
+bool gRedraw = true;            // The next frame differs from the last one shown
+Vec2D gPrevPos[MAX_BALLS];      // Ball positions before the latest step
+float gRenderAlpha = 1.0f;      // Interpolation factor between gPrevPos and pos
+Arena gFrameArena;               // This frame's scratch (see FRAME_ARENA_BYTES)
+Profiler gProfiler;
+const char* gProfilePath = NULL; // --profile-out CSV log, if any
+const char* gFontPath = NULL;    // --font for the profiler overlay, if any
+AssetPack* gAssets = NULL;       // --assets pack, or the one linked in, if any
+TextAtlas gTitleText;            // Glyphs for the game-over message at the current scale
+TextAtlas gHudText;              // Glyphs for the turn label at the current scale
+bool gTextTried = false;         // The atlases were attempted at this scale
+TextLabel gGameOverLabel;        // Text laid out with gTitleText
+TextLabel gTurnLabel;            // Text laid out with gHudText
+char gHudLine[TEXT_LABEL_CHARS + 1]; // Text of the game-over message or turn label
+Replay gReplay;                  // Inputs of this game, saved if --record is given
+const char* gRecordPath = NULL;
+TrajReader* gViewer = NULL;      // Trajectory log shown instead of a game (--view)
+int gViewShot = 0;               // Shot and frame the viewer shows
+int gViewFrame = 0;
+bool gViewPlaying = true;
+AiPlayer* gAi = NULL;            // Computer opponent (--ai), if any
+double gAiBudget = AI_DEFAULT_BUDGET; // Seconds it may think per shot (--ai-time)
+bool gAiTurn = false;            // The computer takes the next shot
+NetSession* gNet = NULL;         // Online game (--host / --join), if any
+bool gRemoteTurn = false;        // The other player takes the next shot
+Match gMatch;                    // Turns, groups and ball in hand (see rules.c)
+Spectator* gWatch = NULL;        // Broadcast being watched (--watch), if any
+PreviewWorker* gPreview = NULL;  // Traces the aim in the background
+AimPreview gAimPreview;          // Latest traced aim
+bool gHasAimPreview = false;
+Layout gLayout;                  // Current table-to-output transform
+bool gLayoutDirty = true;        // Recompute gLayout before the next frame
+#ifdef GEOMETRY_RENDER
+SDL_Texture* gAtlas = NULL;         // Ball body, stripe and white cells
+Vec2D gDiscRim[DISC_SEGMENTS];      // Tessellated ball outline, relative to its center
+SDL_Vertex gBatchVertices[MAX_BATCH_VERTICES]; // This frame's batch
+int gBatchIndices[MAX_BATCH_INDICES];
+int gBatchVertexCount = 0;
+int gBatchIndexCount = 0;
+#elif !defined(LEGACY_RENDER)
+SDL_Texture* gBallTextures[MAX_BALLS];
+#endif
+#ifndef LEGACY_RENDER
+SDL_Texture* gPocketTexture = NULL;
+SDL_Texture* gTableTexture = NULL;  // Baked felt, rails and pockets
+bool gTableLayerDirty = true;       // Rebuild gTableTexture before next use
+#endif
 
 // --- Function Prototypes ---
 bool initialize();
-void setup_table();
 void reset_game();
+void save_previous_positions();
+Vec2D interpolated_pos(int index);
 void game_loop();
+bool waiting_on_workers();
+void view_loop();
+void watch_loop();
 void handle_input(SDL_Event* e);
-void update();
+Vec2D mouse_cue();
+void take_shot(Vec2D cue);
+bool place_cue_ball(Vec2D pos);
+void update_aim_preview();
+void play_ai_turn();
+void play_remote_turn();
+bool local_turn();
+int local_player();
+void sync_turn();
+void show_net_status();
+void end_shot();
+const char* player_name(int player);
+void handle_view_key(SDL_Keycode key);
+void show_view_frame();
+bool update_layout();
+int scaled_length(float units, float scale, int minimum);
+Vec2D to_screen(Vec2D pos);
+Vec2D mouse_pos();
 void render();
+void draw_game_over();
+void draw_hud();
+void create_text();
+bool create_text_atlas(TextAtlas* atlas, int pixelSize);
+void release_text();
+SDL_RWops* open_asset(const char* name);
 void cleanup();
-void draw_ball(Ball* ball);
+void draw_table();
+void draw_aim_preview();
+void draw_path(const PreviewPath* path, SDL_Color color);
+void draw_line(Vec2D from, Vec2D to, SDL_Color color);
+void draw_ball(int id, Vec2D pos);
+SDL_Color ball_color(int id);
+bool ball_striped(int id);
+void draw_pocket(Pocket* pocket);
+#ifdef LEGACY_RENDER
 void draw_circle(int centerX, int centerY, int radius, SDL_Color color);
+#else
+bool create_sprites();
+void destroy_sprites();
+#ifdef GEOMETRY_RENDER
+SDL_Texture* create_atlas();
+void tessellate_disc();
+void batch_disc(int cell, Vec2D center, SDL_Color color);
+void batch_line(Vec2D from, Vec2D to, SDL_Color color);
+void flush_batch();
+#else
+SDL_Texture* create_ball_texture(int id);
+#endif
+SDL_Texture* create_pocket_texture();
+void rasterize_circle(SDL_Surface* surface, int centerX, int centerY, int radius, SDL_Color color);
+void build_table_layer();
+#endif
+bool split_address(const char* address, char* host, size_t size, int* port);
 
 
 // --- Function Implementations ---
@@ -88,18 +260,26 @@ void draw_circle(int centerX, int centerY, int radius, SDL_Color color);
  * @return true on success, false on failure.
  */
 bool initialize() {
+    replay_init(&gReplay, &gTable);
+    if (!arena_init(&gFrameArena, FRAME_ARENA_BYTES)) {
+        printf("Out of memory!\n");
+        return false;
+    }
+
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
         return false;
     }
 
-    gWindow = SDL_CreateWindow("8-Ball Pool Simulation", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+    gWindow = SDL_CreateWindow("8-Ball Pool Simulation", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, VIEW_WIDTH, VIEW_HEIGHT,
+                               SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
     if (gWindow == NULL) {
         printf("Window could not be created! SDL_Error: %s\n", SDL_GetError());
         return false;
     }
+    SDL_SetWindowMinimumSize(gWindow, MIN_WINDOW_WIDTH, MIN_WINDOW_HEIGHT);
 
-    gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
     if (gRenderer == NULL) {
         printf("Renderer could not be created! SDL_Error: %s\n", SDL_GetError());
         return false;
@@ -111,91 +291,307 @@ bool initialize() {
         // This is not a critical error for this version, so we don't return false
     }
 
+    if (!profiler_init(&gProfiler, gProfilePath, gFontPath, gFontPath == NULL ? open_asset(ASSET_FONT) : NULL)) {
+        return false;
+    }
+    gTable.profileClock = profiler_ticks;
+
+    // The game is playable without a preview, so this is not fatal
+    gPreview = preview_create();
+    if (gPreview == NULL) {
+        printf("Aim preview could not be started!\n");
+    }
 
     reset_game();
-    return true;
+
+    // Builds the sprites for the initial scale
+    return update_layout();
 }
 
 /**
- * @brief Sets the initial positions of the balls in a standard 8-ball rack.
- * Also defines pocket locations.
- */
-void setup_table() {
-    // Ball colors
-    SDL_Color colors[NUM_BALLS] = {
-        {255, 255, 255, 255}, // 0: Cue ball
-        {255, 215, 0, 255},   // 1: Yellow (Solid)
-        {0, 0, 255, 255},     // 2: Blue (Solid)
-        {255, 0, 0, 255},     // 3: Red (Solid)
-        {75, 0, 130, 255},    // 4: Purple (Solid)
-        {255, 165, 0, 255},   // 5: Orange (Solid)
-        {0, 128, 0, 255},     // 6: Green (Solid)
-        {128, 0, 0, 255},     // 7: Maroon (Solid)
-        {0, 0, 0, 255},       // 8: Black
-        {255, 215, 0, 255},   // 9: Yellow (Stripe)
-        {0, 0, 255, 255},     // 10: Blue (Stripe)
-        {255, 0, 0, 255},     // 11: Red (Stripe)
-        {75, 0, 130, 255},    // 12: Purple (Stripe)
-        {255, 165, 0, 255},   // 13: Orange (Stripe)
-        {0, 128, 0, 255},     // 14: Green (Stripe)
-        {128, 0, 0, 255}      // 15: Maroon (Stripe)
-    };
+ * @brief Resets the table and game state to their initial values.
+ */
+void reset_game() {
+    if (gAi != NULL) {
+        ai_cancel(gAi);
+    }
+    rules_start(&gMatch, 0); // The human breaks, and the host online
+    sync_turn();
+    setup_table(&gTable);
+    save_previous_positions();
+#ifndef LEGACY_RENDER
+    gTableLayerDirty = true;
+#endif
+}
 
-    // Initialize all balls
-    for (int i = 0; i < NUM_BALLS; ++i) {
-        gBalls[i].id = i;
-        gBalls[i].isActive = true;
-        gBalls[i].vel = (Vec2D){0, 0};
-        gBalls[i].color = colors[i];
+/**
+ * @brief Remembers the current ball positions as the start of the next step.
+ */
+void save_previous_positions() {
+    for (int i = 0; i < gTable.ballCount; ++i) {
+        gPrevPos[i] = ball_pos(&gTable, i);
     }
+}
 
-    // --- Position the balls in the rack ---
-    float startX = SCREEN_WIDTH * 0.75f;
-    float startY = SCREEN_HEIGHT / 2.0f;
-    float ball_offset = BALL_DIAMETER * 0.88f; // Vertical distance between rows
+/**
+ * @brief Returns a ball's position blended between the last two physics
+ * steps by gRenderAlpha, so motion looks smooth at any display rate.
+ * @param index The ball index.
+ */
+Vec2D interpolated_pos(int index) {
+    Vec2D prev = gPrevPos[index];
+    Vec2D cur = ball_pos(&gTable, index);
+    return (Vec2D){
+        prev.x + (cur.x - prev.x) * gRenderAlpha,
+        prev.y + (cur.y - prev.y) * gRenderAlpha
+    };
+}
 
-    int rackOrder[] = {1, 9, 15, 2, 8, 14, 3, 10, 7, 13, 4, 11, 6, 12, 5};
-    int ballIndex = 0;
+/**
+ * @brief The main game loop. Runs until the user quits.
+ *
+ * Physics runs at a fixed gTable.physicsHz independent of the display refresh
+ * rate: elapsed time is accumulated and consumed in whole steps, and
+ * rendering interpolates between the last two steps. After a stall at most
+ * MAX_FRAME_TIME is caught up; the rest is dropped. Every frame's stages are
+ * timed by gProfiler. The computer opponent thinks on its own threads, so
+ * frames keep coming while it does.
+ *
+ * Frames are only drawn while a shot is running or after something changed
+ * (an input event, a new aim preview). Otherwise the loop blocks in
+ * SDL_WaitEventTimeout() and the time is recorded as idle.
+ */
+void game_loop() {
+    SDL_Event e;
+    const double stepTime = 1.0 / gTable.physicsHz;
+    const int maxSteps = (int)(MAX_FRAME_TIME * gTable.physicsHz);
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 previous = SDL_GetPerformanceCounter();
+    double accumulator = 0.0;
 
-    for (int row = 0; row < 5; ++row) {
-        for (int col = 0; col <= row; ++col) {
-            gBalls[rackOrder[ballIndex]].pos.x = startX + row * ball_offset;
-            gBalls[rackOrder[ballIndex]].pos.y = startY + (col * BALL_DIAMETER) - (row * BALL_RADIUS);
-            ballIndex++;
+    while (gGameIsRunning) {
+        arena_reset(&gFrameArena);
+        if (!gRedraw && gTable.state != STATE_SIMULATING) {
+            int timeout = waiting_on_workers() ? WORKER_POLL_MS : IDLE_TIMEOUT_MS;
+            Uint64 idleStart = SDL_GetPerformanceCounter();
+            if (SDL_WaitEventTimeout(NULL, timeout) == 0 && timeout == IDLE_TIMEOUT_MS) {
+                gRedraw = gProfiler.overlayVisible; // Keep its rates current
+            }
+            // Nothing was moving, so there is no simulation time to catch up
+            previous = SDL_GetPerformanceCounter();
+            profiler_add_idle(&gProfiler, previous - idleStart);
         }
-    }
 
-    // Position cue ball
-    gBalls[0].pos = (Vec2D){SCREEN_WIDTH * 0.25f, SCREEN_HEIGHT / 2.0f};
+        Uint64 now = SDL_GetPerformanceCounter();
+        accumulator += (double)(now - previous) / frequency;
+        previous = now;
+
+        handle_input(&e);
+        play_ai_turn();
+        play_remote_turn();
+        update_aim_preview();
+        profiler_lap(&gProfiler, PROF_INPUT, now);
+
+        GameState before = gTable.state;
+        int steps = 0;
+        while (accumulator >= stepTime && steps < maxSteps) {
+            save_previous_positions();
+            update(&gTable);
+            if (gNet != NULL) {
+                netplay_check(gNet, &gTable);
+            }
+            accumulator -= stepTime;
+            steps++;
+        }
+        if (steps == maxSteps) {
+            accumulator = 0.0;
+        }
+        if (before == STATE_SIMULATING && gTable.state == STATE_AIMING) {
+            end_shot();
+        }
+
+        profiler_add_physics(&gProfiler, &gTable);
 
-    // --- Define pocket locations ---
-    float tableX = (SCREEN_WIDTH - TABLE_WIDTH) / 2.0f;
-    float tableY = (SCREEN_HEIGHT - TABLE_HEIGHT) / 2.0f;
-    gPockets[0] = (Pocket){{tableX, tableY}};
-    gPockets[1] = (Pocket){{tableX + TABLE_WIDTH / 2.0f, tableY}};
-    gPockets[2] = (Pocket){{tableX + TABLE_WIDTH, tableY}};
-    gPockets[3] = (Pocket){{tableX, tableY + TABLE_HEIGHT}};
-    gPockets[4] = (Pocket){{tableX + TABLE_WIDTH / 2.0f, tableY + TABLE_HEIGHT}};
-    gPockets[5] = (Pocket){{tableX + TABLE_WIDTH, tableY + TABLE_HEIGHT}};
+        if (gRedraw || before == STATE_SIMULATING || gTable.state == STATE_SIMULATING) {
+            gRedraw = false;
+            gRenderAlpha = (float)(accumulator / stepTime);
+            render();
+            profiler_lap(&gProfiler, PROF_FRAME, now);
+            profiler_end_frame(&gProfiler, steps);
+        }
+    }
 }
 
 /**
- * @brief Resets the table and game state to their initial values.
+ * @brief Returns true if a background worker may have a result for the
+ * game loop soon: the computer is taking its turn, the other player is
+ * about to shoot or an aim preview is being traced.
  */
-void reset_game() {
-    setup_table();
-    gCurrentState = STATE_AIMING;
+bool waiting_on_workers() {
+    bool aiTurn = gAi != NULL && gAiTurn && gTable.state == STATE_AIMING && ball_active(&gTable, 0);
+    bool remoteTurn = gNet != NULL && gRemoteTurn;
+    return aiTurn || remoteTurn || (gPreview != NULL && preview_busy(gPreview));
 }
 
 /**
- * @brief The main game loop. Runs until the user quits.
+ * @brief The trajectory viewer's main loop. Shows one logged shot at a
+ * time in render(), playing it at its recorded physics rate or stepping
+ * through it frame by frame.
  */
-void game_loop() {
+void view_loop() {
+    SDL_Event e;
+    const double stepTime = 1.0 / trajlog_header(gViewer)->physicsHz;
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 previous = SDL_GetPerformanceCounter();
+    double accumulator = 0.0;
+
+    while (gGameIsRunning) {
+        arena_reset(&gFrameArena);
+        Uint64 now = SDL_GetPerformanceCounter();
+        accumulator += (double)(now - previous) / frequency;
+        previous = now;
+
+        handle_input(&e);
+        profiler_lap(&gProfiler, PROF_INPUT, now);
+
+        int steps = 0;
+        if (gViewPlaying) {
+            steps = (int)(accumulator / stepTime);
+            accumulator -= steps * stepTime;
+            gViewFrame += steps;
+        } else {
+            accumulator = 0.0;
+        }
+        show_view_frame();
+
+        render();
+        profiler_lap(&gProfiler, PROF_FRAME, now);
+        profiler_end_frame(&gProfiler, steps);
+    }
+}
+
+/**
+ * @brief Main loop of a spectator: shows a broadcast BROADCAST_DELAY_FRAMES
+ * behind the latest frame received, interpolating between frames like the
+ * game does between steps.
+ */
+void watch_loop() {
     SDL_Event e;
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 previous = SDL_GetPerformanceCounter();
+    double playTick = 0.0; // Broadcast tick being shown
+    uint32_t shownTick = 0; // Tick of the latest frame applied
+    bool started = false;
+    bool connected = true;
+    SDL_SetWindowTitle(gWindow, "8-Ball Pool Simulation - Spectating");
+
     while (gGameIsRunning) {
+        arena_reset(&gFrameArena);
+        Uint64 now = SDL_GetPerformanceCounter();
+        playTick += (double)(now - previous) / frequency * BROADCAST_HZ;
+        previous = now;
+
         handle_input(&e);
-        update();
+        if (connected && !spectator_receive(gWatch)) {
+            connected = false;
+            SDL_SetWindowTitle(gWindow, "8-Ball Pool Simulation - Broadcast ended");
+        }
+        profiler_lap(&gProfiler, PROF_INPUT, now);
+
+        // Start, or catch up after a stall, a little behind the latest frame
+        uint32_t latest;
+        if (spectator_latest_tick(gWatch, &latest) &&
+            (!started || latest - playTick > 4 * BROADCAST_DELAY_FRAMES)) {
+            playTick = (double)latest - BROADCAST_DELAY_FRAMES;
+            started = true;
+        }
+
+        int frames = 0;
+        uint32_t tick;
+        while (spectator_next_tick(gWatch, &tick) && tick <= playTick) {
+            save_previous_positions();
+            if (spectator_apply(gWatch, &gTable) & BROADCAST_CUT) {
+                save_previous_positions();
+            }
+            shownTick = tick;
+            frames++;
+        }
+        double alpha = playTick - shownTick;
+        gRenderAlpha = alpha < 1.0 ? (float)alpha : 1.0f;
+
         render();
+        profiler_lap(&gProfiler, PROF_FRAME, now);
+        profiler_end_frame(&gProfiler, frames);
+    }
+}
+
+/**
+ * @brief Loads the viewer's current frame into gTable, clamping the shot
+ * and frame to the log, and names them in the window title.
+ */
+void show_view_frame() {
+    int shots = (int)trajlog_header(gViewer)->shotCount;
+    if (gViewShot >= shots) gViewShot = shots - 1;
+    if (gViewShot < 0) gViewShot = 0;
+    int frames = trajlog_shot_frames(gViewer, gViewShot);
+    if (gViewFrame >= frames - 1) {
+        gViewFrame = frames - 1;
+        gViewPlaying = false;
+    }
+    if (gViewFrame < 0) gViewFrame = 0;
+
+    trajlog_seek(gViewer, gViewShot, gViewFrame, &gTable);
+    save_previous_positions();
+    gRenderAlpha = 1.0f;
+
+    static char shown[96];
+    char title[96];
+    snprintf(title, sizeof(title), "8-Ball Pool Simulation - shot %d/%d, step %d/%d%s",
+             gViewShot + 1, shots, gViewFrame, frames - 1, gViewPlaying ? "" : " (paused)");
+    if (strcmp(title, shown) != 0) {
+        SDL_SetWindowTitle(gWindow, title);
+        strcpy(shown, title);
+    }
+}
+
+/**
+ * @brief Handles a key press in the trajectory viewer.
+ * @param key The key that was pressed.
+ */
+void handle_view_key(SDL_Keycode key) {
+    switch (key) {
+        case SDLK_SPACE:
+            gViewPlaying = !gViewPlaying;
+            if (gViewPlaying && gViewFrame >= trajlog_shot_frames(gViewer, gViewShot) - 1) {
+                gViewFrame = 0;
+            }
+            break;
+        case SDLK_RIGHT:
+            gViewPlaying = false;
+            gViewFrame++;
+            break;
+        case SDLK_LEFT:
+            gViewPlaying = false;
+            gViewFrame--;
+            break;
+        case SDLK_HOME:
+            gViewFrame = 0;
+            break;
+        case SDLK_END:
+            gViewFrame = trajlog_shot_frames(gViewer, gViewShot) - 1;
+            break;
+        case SDLK_DOWN:
+        case SDLK_PAGEDOWN:
+            gViewShot++;
+            gViewFrame = 0;
+            gViewPlaying = true;
+            break;
+        case SDLK_UP:
+        case SDLK_PAGEUP:
+            gViewShot--;
+            gViewFrame = 0;
+            gViewPlaying = true;
+            break;
     }
 }
 
@@ -205,195 +601,625 @@ void game_loop() {
  */
 void handle_input(SDL_Event* e) {
     while (SDL_PollEvent(e) != 0) {
+        gRedraw = true; // Any event may change what is shown
+
         if (e->type == SDL_QUIT) {
             gGameIsRunning = false;
         }
 
+        if (e->type == SDL_WINDOWEVENT && e->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+            gLayoutDirty = true;
+        }
+#ifndef LEGACY_RENDER
+        // Target textures lose their contents on device loss
+        if (e->type == SDL_RENDER_TARGETS_RESET) {
+            gTableLayerDirty = true;
+        }
+        if (e->type == SDL_RENDER_DEVICE_RESET) {
+            profiler_release_overlay(&gProfiler);
+            release_text();
+            destroy_sprites();
+            if (!create_sprites()) {
+                gGameIsRunning = false;
+            }
+            gTableLayerDirty = true;
+        }
+#endif
+
+        // The trajectory viewer has its own keys; neither it nor a
+        // spectator takes shots
+        if (gViewer != NULL || gWatch != NULL) {
+            if (e->type == SDL_KEYDOWN && e->key.keysym.sym == SDLK_ESCAPE) {
+                gGameIsRunning = false;
+            } else if (e->type == SDL_KEYDOWN && e->key.keysym.sym == SDLK_F3) {
+                profiler_toggle_overlay(&gProfiler);
+            } else if (e->type == SDL_KEYDOWN && gViewer != NULL) {
+                handle_view_key(e->key.keysym.sym);
+            }
+            continue;
+        }
+
         if (e->type == SDL_KEYDOWN) {
             switch (e->key.keysym.sym) {
                 case SDLK_ESCAPE:
                     gGameIsRunning = false;
                     break;
                 case SDLK_r:
+                    if (gNet != NULL) {
+                        netplay_send_reset(gNet);
+                    }
+                    replay_record(&gReplay, REPLAY_RESET, (Vec2D){0.0f, 0.0f}, &gTable);
                     reset_game();
                     break;
+                case SDLK_F3:
+                    profiler_toggle_overlay(&gProfiler);
+                    break;
+            }
+        }
+
+        // Right click moves the cue ball with ball in hand
+        if (e->type == SDL_MOUSEBUTTONDOWN && e->button.button == SDL_BUTTON_RIGHT) {
+            Vec2D pos = mouse_pos();
+            if (local_turn() && rules_can_place_cue_ball(&gMatch, &gTable, pos)) {
+                if (gNet != NULL) {
+                    netplay_send_place(gNet, &gTable, pos);
+                }
+                place_cue_ball(pos);
             }
+            continue;
         }
 
         // Handle aiming and shooting
-        if (gCurrentState == STATE_AIMING && gBalls[0].isActive) {
+        if (gTable.state == STATE_AIMING && ball_active(&gTable, 0) && local_turn()) {
             if (e->type == SDL_MOUSEBUTTONDOWN) {
-                int mouseX, mouseY;
-                SDL_GetMouseState(&mouseX, &mouseY);
+                Vec2D cue = mouse_cue();
+                if (gNet != NULL) {
+                    netplay_send_shot(gNet, &gTable, cue);
+                }
+                take_shot(cue);
+            }
+        }
+    }
+}
 
-                // Calculate vector from cue ball to mouse
-                float dx = mouseX - gBalls[0].pos.x;
-                float dy = mouseY - gBalls[0].pos.y;
+/**
+ * @brief Returns the cue ball velocity the mouse is aiming: away from the
+ * mouse, proportional to its distance from the cue ball, up to
+ * MAX_CUE_SPEED.
+ */
+Vec2D mouse_cue() {
+    Vec2D mouse = mouse_pos();
+
+    // Calculate vector from cue ball to mouse
+    float dx = mouse.x - gTable.px[0];
+    float dy = mouse.y - gTable.py[0];
+
+    // Set velocity proportional to distance (power)
+    Vec2D cue = {-dx * CUE_POWER_MULTIPLIER, -dy * CUE_POWER_MULTIPLIER};
+    const float limit = MAX_CUE_SPEED * 0.9999f; // Rounding stays inside valid_cue()
+    float speed = sqrtf(cue.x * cue.x + cue.y * cue.y);
+    if (speed > limit) {
+        cue.x *= limit / speed;
+        cue.y *= limit / speed;
+    }
+    return cue;
+}
 
-                // Set velocity proportional to distance (power)
-                gBalls[0].vel.x = -dx * CUE_POWER_MULTIPLIER;
-                gBalls[0].vel.y = -dy * CUE_POWER_MULTIPLIER;
+/**
+ * @brief Records a shot in the replay and strikes the cue ball.
+ * @param cue The cue ball's velocity.
+ */
+void take_shot(Vec2D cue) {
+    replay_record(&gReplay, REPLAY_SHOT, cue, &gTable);
+    strike_cue_ball(&gTable, cue);
+}
 
-                gCurrentState = STATE_SIMULATING;
+/**
+ * @brief Records a ball-in-hand placement in the replay and moves the cue
+ * ball, if the rules allow it.
+ * @param pos The cue ball's new position.
+ * @return false if the placement was not allowed.
+ */
+bool place_cue_ball(Vec2D pos) {
+    if (!rules_can_place_cue_ball(&gMatch, &gTable, pos)) {
+        return false;
+    }
+    replay_record(&gReplay, REPLAY_PLACE, pos, &gTable);
+    rules_place_cue_ball(&gMatch, &gTable, pos);
+    save_previous_positions();
+    return true;
+}
+
+/**
+ * @brief Runs the computer's turn: starts a search when the table is ready
+ * for its shot and plays the shot once the search has finished.
+ */
+void play_ai_turn() {
+    if (gAi == NULL || !gAiTurn || gTable.state != STATE_AIMING || !ball_active(&gTable, 0)) {
+        return;
+    }
+
+    AiMove move;
+    if (ai_poll(gAi, &move)) {
+        take_shot(move.cue);
+    } else if (!ai_busy(gAi)) {
+        ai_start(gAi, &gTable, &gMatch, gAiBudget);
+    }
+}
+
+/**
+ * @brief Applies the other player's shots, placements and resets as soon as
+ * the table is ready for them. Once the session ends (the other player left
+ * or the tables went out of sync) the game carries on offline with both
+ * players at this computer.
+ */
+void play_remote_turn() {
+    if (gNet == NULL) {
+        return;
+    }
+
+    NetMessage input;
+    while (netplay_next_input(gNet, &gTable, &input)) {
+        gRedraw = true;
+        if (input.type == NET_RESET) {
+            replay_record(&gReplay, REPLAY_RESET, (Vec2D){0.0f, 0.0f}, &gTable);
+            reset_game();
+        } else if (!gRemoteTurn) {
+            // The hash checkpoints report the desync this leads to
+            printf("The other player played out of turn!\n");
+        } else if (input.type == NET_PLACE) {
+            if (!place_cue_ball(input.cue)) {
+                printf("The other player placed the cue ball where it does not fit!\n");
             }
+        } else {
+            take_shot(input.cue);
         }
     }
+
+    show_net_status();
+    if (netplay_status(gNet) != NETPLAY_CONNECTED) {
+        netplay_close(gNet);
+        gNet = NULL;
+        gRemoteTurn = false;
+    }
+}
+
+/**
+ * @brief Returns true if the next shot is taken at this computer's mouse.
+ */
+bool local_turn() {
+    return !gAiTurn && !gRemoteTurn;
+}
+
+/**
+ * @brief Returns this computer's seat in an online match: the host is
+ * player 0 and breaks. Offline both seats are local.
+ */
+int local_player() {
+    return gNet != NULL && !netplay_is_host(gNet) ? 1 : 0;
+}
+
+/**
+ * @brief Derives who takes the next shot from the match: the computer on
+ * its seat's turn, the other player on theirs online, else the mouse.
+ */
+void sync_turn() {
+    gAiTurn = gAi != NULL && gMatch.turn == AI_PLAYER;
+    gRemoteTurn = gNet != NULL && gMatch.turn != local_player();
 }
 
 /**
- * @brief Updates the game state, including physics simulation.
+ * @brief Shows whose turn it is in an online game, or why it ended, in the
+ * window title.
  */
-void update() {
-    if (gCurrentState != STATE_SIMULATING) {
+void show_net_status() {
+    static const char* shown = NULL;
+    const char* title = "8-Ball Pool Simulation";
+    if (gNet != NULL) {
+        switch (netplay_status(gNet)) {
+            case NETPLAY_CONNECTED:
+                title = gRemoteTurn ? "8-Ball Pool Simulation - Their turn" : "8-Ball Pool Simulation - Your turn";
+                break;
+            case NETPLAY_CLOSED:
+                title = "8-Ball Pool Simulation - The other player left";
+                break;
+            case NETPLAY_DESYNC:
+                title = "8-Ball Pool Simulation - Out of sync, playing offline";
+                break;
+        }
+    }
+    if (title != shown && gWindow != NULL) {
+        SDL_SetWindowTitle(gWindow, title);
+        shown = title;
+    }
+}
+
+/**
+ * @brief Asks the preview worker to trace the human's current aim and picks
+ * up any finished trace. The worker skips aims within PREVIEW_REUSE_DELTA
+ * of the last one, so a resting mouse costs nothing.
+ */
+void update_aim_preview() {
+    if (gPreview == NULL) {
         return;
     }
+    if (gTable.state == STATE_AIMING && ball_active(&gTable, 0) && local_turn()) {
+        preview_request(gPreview, &gTable, mouse_cue());
+    }
+    if (preview_poll(gPreview, &gAimPreview)) {
+        gHasAimPreview = true;
+        gRedraw = true;
+    }
+}
 
-    bool ballsAreMoving = false;
+/**
+ * @brief Applies the rules once a shot comes to rest: the turn passes
+ * unless the shooter pocketed a ball of their group legally, a foul gives
+ * the opponent ball in hand and the 8-ball ends the game.
+ */
+void end_shot() {
+    ShotVerdict verdict = rules_end_shot(&gMatch, &gTable);
+    if (verdict.foul != FOUL_NONE) {
+        printf("Foul: %s\n", foul_name(verdict.foul));
+    }
+    sync_turn();
+    save_previous_positions(); // Spotted balls jump there
+}
 
-    // --- Physics Simulation Step ---
-    for (int i = 0; i < NUM_BALLS; ++i) {
-        if (!gBalls[i].isActive) continue;
+/**
+ * @brief Returns how the HUD names a player.
+ */
+const char* player_name(int player) {
+    if (gAi != NULL) {
+        return player == AI_PLAYER ? "Computer" : "You";
+    }
+    if (gNet != NULL) {
+        return player == local_player() ? "You" : "Opponent";
+    }
+    return player == 0 ? "Player 1" : "Player 2";
+}
 
-        // 1. Apply friction
-        gBalls[i].vel.x *= FRICTION;
-        gBalls[i].vel.y *= FRICTION;
 
-        // 2. Update position
-        gBalls[i].pos.x += gBalls[i].vel.x;
-        gBalls[i].pos.y += gBalls[i].vel.y;
+/**
+ * @brief Fits the view to the renderer's output and, if that changes the
+ * sprite metrics, rebuilds the sprites at the new scale. Everything cached
+ * per scale is rebuilt here and only here, so frames at any scale cost the
+ * same sprite copies.
+ * @return false if the sprites could not be rebuilt.
+ */
+bool update_layout() {
+    gLayoutDirty = false;
+    int width, height;
+    if (SDL_GetRendererOutputSize(gRenderer, &width, &height) < 0 || width <= 0 || height <= 0) {
+        width = VIEW_WIDTH;
+        height = VIEW_HEIGHT;
+    }
 
-        // 3. Stop balls with very low velocity
-        float speed = sqrt(gBalls[i].vel.x * gBalls[i].vel.x + gBalls[i].vel.y * gBalls[i].vel.y);
-        if (speed < MIN_VELOCITY) {
-            gBalls[i].vel = (Vec2D){0, 0};
-        } else {
-            ballsAreMoving = true;
-        }
-
-        // 4. Handle collision with cushions
-        float tableX1 = (SCREEN_WIDTH - TABLE_WIDTH) / 2.0f + BALL_RADIUS;
-        float tableY1 = (SCREEN_HEIGHT - TABLE_HEIGHT) / 2.0f + BALL_RADIUS;
-        float tableX2 = tableX1 + TABLE_WIDTH - BALL_DIAMETER;
-        float tableY2 = tableY1 + TABLE_HEIGHT - BALL_DIAMETER;
-
-        if (gBalls[i].pos.x < tableX1) { gBalls[i].pos.x = tableX1; gBalls[i].vel.x *= -1; }
-        if (gBalls[i].pos.x > tableX2) { gBalls[i].pos.x = tableX2; gBalls[i].vel.x *= -1; }
-        if (gBalls[i].pos.y < tableY1) { gBalls[i].pos.y = tableY1; gBalls[i].vel.y *= -1; }
-        if (gBalls[i].pos.y > tableY2) { gBalls[i].pos.y = tableY2; gBalls[i].vel.y *= -1; }
-
-        // 5. Handle ball-ball collisions
-        for (int j = i + 1; j < NUM_BALLS; ++j) {
-            if (!gBalls[j].isActive) continue;
-
-            float dx = gBalls[j].pos.x - gBalls[i].pos.x;
-            float dy = gBalls[j].pos.y - gBalls[i].pos.y;
-            float distSq = dx * dx + dy * dy;
-
-            if (distSq < BALL_DIAMETER * BALL_DIAMETER) {
-                float dist = sqrt(distSq);
-                float overlap = (BALL_DIAMETER - dist) / 2.0f;
-
-                // Static resolution (move balls apart)
-                gBalls[i].pos.x -= overlap * (dx / dist);
-                gBalls[i].pos.y -= overlap * (dy / dist);
-                gBalls[j].pos.x += overlap * (dx / dist);
-                gBalls[j].pos.y += overlap * (dy / dist);
-
-                // Dynamic resolution (exchange velocity)
-                float nx = dx / dist; // Normal vector x
-                float ny = dy / dist; // Normal vector y
-
-                // Dot products
-                float p1 = gBalls[i].vel.x * nx + gBalls[i].vel.y * ny;
-                float p2 = gBalls[j].vel.x * nx + gBalls[j].vel.y * ny;
-
-                // New velocities along the normal
-                gBalls[i].vel.x += (p2 - p1) * nx;
-                gBalls[i].vel.y += (p2 - p1) * ny;
-                gBalls[j].vel.x += (p1 - p2) * nx;
-                gBalls[j].vel.y += (p1 - p2) * ny;
-            }
-        }
-        
-        // 6. Handle pocketing
-        for (int p = 0; p < 6; ++p) {
-            float dx = gPockets[p].pos.x - gBalls[i].pos.x;
-            float dy = gPockets[p].pos.y - gBalls[i].pos.y;
-            float dist = sqrt(dx * dx + dy * dy);
-            if (dist < POCKET_RADIUS) {
-                gBalls[i].isActive = false;
-                // Simple game over logic
-                if (gBalls[i].id == 8) {
-                    gCurrentState = STATE_GAME_OVER;
-                }
-            }
-        }
+    Layout layout;
+    layout.outputWidth = width;
+    layout.outputHeight = height;
+    layout.scale = fminf((float)width / VIEW_WIDTH, (float)height / VIEW_HEIGHT);
+    layout.originX = floorf((width - VIEW_WIDTH * layout.scale) / 2.0f + VIEW_TABLE_X * layout.scale);
+    layout.originY = floorf((height - VIEW_HEIGHT * layout.scale) / 2.0f + VIEW_TABLE_Y * layout.scale);
+    const TableGeometry* geo = &gTable.geometry;
+    layout.ballRadius = scaled_length(geo->ballRadius, layout.scale, 1);
+    layout.ballHalf = scaled_length(geo->ballRadius + BALL_OUTLINE, layout.scale, layout.ballRadius + 1);
+    layout.ballSize = layout.ballHalf * 2 + 1;
+    layout.pocketRadius = scaled_length(geo->pocketRadius, layout.scale, 1);
+    layout.pocketSize = layout.pocketRadius * 2 + 1;
+
+    bool rescaled = layout.ballRadius != gLayout.ballRadius || layout.ballHalf != gLayout.ballHalf ||
+                    layout.pocketRadius != gLayout.pocketRadius;
+    bool resized = layout.outputWidth != gLayout.outputWidth || layout.outputHeight != gLayout.outputHeight;
+    if (layout.scale != gLayout.scale) {
+        release_text();
     }
+    gLayout = layout;
 
-    // If no balls are moving, switch back to aiming state
-    if (!ballsAreMoving) {
-        gCurrentState = STATE_AIMING;
+#ifndef LEGACY_RENDER
+    if (rescaled) {
+        destroy_sprites();
+        if (!create_sprites()) {
+            return false;
+        }
+    }
+    if (resized && gTableTexture != NULL) {
+        SDL_DestroyTexture(gTableTexture);
+        gTableTexture = NULL;
     }
+    gTableLayerDirty = true;
+#else
+    (void)rescaled;
+    (void)resized;
+#endif
+    return true;
 }
 
+/**
+ * @brief Rounds a length in table units to whole pixels at a scale.
+ * @param units The length in table units.
+ * @param scale Pixels per table unit.
+ * @param minimum The fewest pixels returned.
+ */
+int scaled_length(float units, float scale, int minimum) {
+    int pixels = (int)lrintf(units * scale);
+    return pixels > minimum ? pixels : minimum;
+}
 
 /**
- * @brief Renders all game objects to the screen.
+ * @brief Converts a position in table units to output pixels.
  */
-void render() {
-    // --- Clear screen (brown background) ---
-    SDL_SetRenderDrawColor(gRenderer, 50, 25, 0, 255);
-    SDL_RenderClear(gRenderer);
+Vec2D to_screen(Vec2D pos) {
+    return (Vec2D){gLayout.originX + pos.x * gLayout.scale, gLayout.originY + pos.y * gLayout.scale};
+}
 
-    // --- Draw table ---
-    // Felt
-    SDL_Rect tableRect = {
-        (SCREEN_WIDTH - TABLE_WIDTH) / 2,
-        (SCREEN_HEIGHT - TABLE_HEIGHT) / 2,
-        TABLE_WIDTH,
-        TABLE_HEIGHT
-    };
-    SDL_SetRenderDrawColor(gRenderer, 0, 85, 0, 255);
-    SDL_RenderFillRect(gRenderer, &tableRect);
+/**
+ * @brief Returns the mouse position in table units. SDL reports it in
+ * window coordinates, which are smaller than output pixels on high-DPI
+ * displays.
+ */
+Vec2D mouse_pos() {
+    int mouseX, mouseY, windowWidth, windowHeight;
+    SDL_GetMouseState(&mouseX, &mouseY);
+    SDL_GetWindowSize(gWindow, &windowWidth, &windowHeight);
+    float pixelX = windowWidth > 0 ? mouseX * (float)gLayout.outputWidth / windowWidth : mouseX;
+    float pixelY = windowHeight > 0 ? mouseY * (float)gLayout.outputHeight / windowHeight : mouseY;
+    return (Vec2D){(pixelX - gLayout.originX) / gLayout.scale, (pixelY - gLayout.originY) / gLayout.scale};
+}
 
-    // --- Draw pockets ---
-    for (int i = 0; i < 6; ++i) {
-        draw_circle(gPockets[i].pos.x, gPockets[i].pos.y, POCKET_RADIUS, (SDL_Color){0, 0, 0, 255});
+/**
+ * @brief Renders all game objects to the screen.
+ */
+void render() {
+    if (gLayoutDirty && !update_layout()) {
+        gGameIsRunning = false;
+        return;
     }
+    Uint64 start = profiler_ticks();
+
+    // --- Draw static table layer ---
+#ifdef LEGACY_RENDER
+    draw_table();
+#else
+    if (gTableLayerDirty) {
+        build_table_layer();
+    }
+    if (gTableTexture != NULL) {
+        SDL_RenderCopy(gRenderer, gTableTexture, NULL, NULL);
+    } else {
+        draw_table();
+    }
+#endif
+    start = profiler_lap(&gProfiler, PROF_TABLE, start);
 
     // --- Draw balls ---
-    for (int i = 0; i < NUM_BALLS; ++i) {
-        if (gBalls[i].isActive) {
-            draw_ball(&gBalls[i]);
+    for (int i = 0; i < gTable.ballCount; ++i) {
+        if (ball_active(&gTable, i)) {
+            draw_ball(i, interpolated_pos(i));
         }
     }
+    start = profiler_lap(&gProfiler, PROF_DRAW_BALLS, start);
+
+    // --- Draw aim preview and cue stick when the human is aiming ---
+    if (gTable.state == STATE_AIMING && ball_active(&gTable, 0) && local_turn()) {
+        draw_aim_preview();
 
-    // --- Draw cue stick when aiming ---
-    if (gCurrentState == STATE_AIMING && gBalls[0].isActive) {
-        int mouseX, mouseY;
-        SDL_GetMouseState(&mouseX, &mouseY);
-        SDL_SetRenderDrawColor(gRenderer, 200, 150, 100, 255);
-        SDL_RenderDrawLine(gRenderer, gBalls[0].pos.x, gBalls[0].pos.y, mouseX, mouseY);
+        draw_line(ball_pos(&gTable, 0), mouse_pos(), (SDL_Color){200, 150, 100, 255});
     }
-    
+#ifdef GEOMETRY_RENDER
+    flush_batch();
+#endif
+
     // --- Draw Game Over text ---
-    if (gCurrentState == STATE_GAME_OVER) {
-        // This part requires a font, which we haven't loaded,
-        // so we'll just change the background color to indicate game over.
-        SDL_SetRenderDrawColor(gRenderer, 128, 0, 0, 255);
-        SDL_RenderClear(gRenderer);
-        // In a full game, you'd render "Game Over" text here.
+    if (gTable.state == STATE_GAME_OVER) {
+        draw_game_over();
+    } else {
+        draw_hud();
     }
+    start = profiler_lap(&gProfiler, PROF_CUE, start);
 
+    // --- Draw profiler overlay (F3) ---
+    profiler_draw_overlay(&gProfiler, gRenderer);
+    start = profiler_lap(&gProfiler, PROF_OVERLAY, start);
 
     // --- Update screen ---
     SDL_RenderPresent(gRenderer);
+    profiler_lap(&gProfiler, PROF_PRESENT, start);
+}
+
+/**
+ * @brief Turns the screen red and, if there is a font, shows the game-over
+ * message over it.
+ */
+void draw_game_over() {
+    SDL_SetRenderDrawColor(gRenderer, 128, 0, 0, 255);
+    SDL_RenderClear(gRenderer);
+
+    if (gAi != NULL || gNet != NULL) {
+        snprintf(gHudLine, sizeof(gHudLine), "%s - press R to play again",
+                 gMatch.winner == local_player() ? "You win" : "You lose");
+    } else {
+        snprintf(gHudLine, sizeof(gHudLine), "%s wins - press R to play again", player_name(gMatch.winner));
+    }
+
+    create_text();
+    text_layout(&gTitleText, gHudLine, &gGameOverLabel);
+    const SDL_Color white = {255, 255, 255, 255};
+    text_draw_label(&gTitleText, gRenderer, &gGameOverLabel, (gLayout.outputWidth - gGameOverLabel.width) / 2,
+                    (gLayout.outputHeight - gGameOverLabel.height) / 2, white);
+}
+
+/**
+ * @brief Shows who is to shoot, their group (the variant, if not 8-ball)
+ * and ball in hand in the top right corner. The line is only laid out
+ * again when it changes.
+ */
+void draw_hud() {
+    if (gViewer != NULL || gWatch != NULL) {
+        return;
+    }
+    int turn = gMatch.turn;
+    const char* detail = gTable.variant != VARIANT_EIGHT_BALL ? variant_name(gTable.variant)
+                         : gMatch.group[turn] == GROUP_OPEN ? "open table"
+                                                             : group_name(gMatch.group[turn]);
+    snprintf(gHudLine, sizeof(gHudLine), "Turn: %s (%s%s)", player_name(turn), detail,
+             gMatch.ballInHand ? ", ball in hand" : "");
+
+    create_text();
+    text_layout(&gHudText, gHudLine, &gTurnLabel);
+    const SDL_Color white = {255, 255, 255, 255};
+    int margin = scaled_length(HUD_TEXT_SIZE / 2, gLayout.scale, 2);
+    text_draw_label(&gHudText, gRenderer, &gTurnLabel, gLayout.outputWidth - gTurnLabel.width - margin, margin,
+                    white);
+}
+
+/**
+ * @brief Makes the text atlases for the current scale, if they were not
+ * attempted at it yet. Without a font they stay empty and no text is shown.
+ */
+void create_text() {
+    if (gTextTried) {
+        return;
+    }
+    gTextTried = true;
+    create_text_atlas(&gTitleText, scaled_length(GAME_OVER_TEXT_SIZE, gLayout.scale, 8));
+    create_text_atlas(&gHudText, scaled_length(HUD_TEXT_SIZE, gLayout.scale, 8));
+}
+
+/**
+ * @brief Makes a text atlas with the --font file or, without one, the asset
+ * pack's font.
+ * @param atlas The atlas to fill.
+ * @param pixelSize The font size in output pixels.
+ * @return true on success.
+ */
+bool create_text_atlas(TextAtlas* atlas, int pixelSize) {
+    TTF_Font* font = NULL;
+    SDL_RWops* data;
+    if (gFontPath != NULL) {
+        font = TTF_OpenFont(gFontPath, pixelSize);
+    } else if ((data = open_asset(ASSET_FONT)) != NULL) {
+        font = TTF_OpenFontRW(data, 1, pixelSize);
+    }
+    if (font == NULL) {
+        return false;
+    }
+    bool ok = text_create_atlas(atlas, gRenderer, font);
+    TTF_CloseFont(font);
+    return ok;
+}
+
+/**
+ * @brief Frees the text atlases, so they are made again when text is next
+ * shown.
+ */
+void release_text() {
+    text_destroy_atlas(&gTitleText);
+    text_destroy_atlas(&gHudText);
+    gTextTried = false;
+    gGameOverLabel.height = -1; // Lay the labels out again with the new glyphs
+    gTurnLabel.height = -1;
+}
+
+/**
+ * @brief Opens an asset of the asset pack in place, without copying it.
+ * @param name The asset's name.
+ * @return A read-only stream over the asset, or NULL if there is no pack
+ * or no such asset.
+ */
+SDL_RWops* open_asset(const char* name) {
+    const void* data;
+    size_t size;
+    if (!assetpack_find(gAssets, name, &data, &size)) {
+        return NULL;
+    }
+    return SDL_RWFromConstMem(data, (int)size);
 }
 
 /**
- * @brief Cleans up SDL resources.
+ * @brief Draws the latest aim preview, if it was traced on the table as it
+ * is: the cue ball's path to its first contact, then the hit ball's path
+ * in a lighter line and the cue ball's deflection in a dimmer one.
+ */
+void draw_aim_preview() {
+    if (!gHasAimPreview || gAimPreview.tableHash != table_hash(&gTable, TABLE_HASH_SEED)) {
+        return;
+    }
+    SDL_Color cueColor = gAimPreview.scratch ? (SDL_Color){220, 60, 60, 255} : (SDL_Color){230, 230, 230, 255};
+    draw_path(&gAimPreview.cuePath, cueColor);
+    if (gAimPreview.hitBall >= 0) {
+        draw_path(&gAimPreview.hitPath, (SDL_Color){255, 255, 160, 255});
+        draw_path(&gAimPreview.cueAfter, (SDL_Color){150, 150, 150, 255});
+    }
+}
+
+/**
+ * @brief Draws a preview path as connected lines: into the frame's batch
+ * with GEOMETRY_RENDER, else as one polyline converted to screen
+ * coordinates in the frame arena.
+ */
+void draw_path(const PreviewPath* path, SDL_Color color) {
+#ifndef GEOMETRY_RENDER
+    SDL_FPoint* points = arena_alloc(&gFrameArena, path->count * sizeof(SDL_FPoint));
+    if (points != NULL && path->count >= 2) {
+        for (int i = 0; i < path->count; ++i) {
+            Vec2D screen = to_screen(path->points[i]);
+            points[i] = (SDL_FPoint){screen.x, screen.y};
+        }
+        SDL_SetRenderDrawColor(gRenderer, color.r, color.g, color.b, color.a);
+        SDL_RenderDrawLinesF(gRenderer, points, path->count);
+        return;
+    }
+#endif
+    for (int i = 1; i < path->count; ++i) {
+        draw_line(path->points[i - 1], path->points[i], color);
+    }
+}
+
+/**
+ * @brief Draws a one pixel wide line between two table positions (into the
+ * frame's batch with GEOMETRY_RENDER).
+ */
+void draw_line(Vec2D from, Vec2D to, SDL_Color color) {
+    from = to_screen(from);
+    to = to_screen(to);
+#ifdef GEOMETRY_RENDER
+    batch_line(from, to, color);
+#else
+    SDL_SetRenderDrawColor(gRenderer, color.r, color.g, color.b, color.a);
+    SDL_RenderDrawLineF(gRenderer, from.x, from.y, to.x, to.y);
+#endif
+}
+
+/**
+ * @brief Saves the replay (if recording) and cleans up SDL resources.
  */
 void cleanup() {
+    if (gRecordPath != NULL) {
+        replay_record(&gReplay, REPLAY_END, (Vec2D){0.0f, 0.0f}, &gTable);
+        replay_save(&gReplay, gRecordPath);
+    }
+    replay_free(&gReplay);
+    ai_destroy(gAi);
+    gAi = NULL;
+    netplay_close(gNet);
+    gNet = NULL;
+    spectator_close(gWatch);
+    gWatch = NULL;
+    preview_destroy(gPreview);
+    gPreview = NULL;
+    trajlog_free(gViewer);
+    gViewer = NULL;
+
+#ifndef LEGACY_RENDER
+    destroy_sprites();
+    if (gTableTexture != NULL) {
+        SDL_DestroyTexture(gTableTexture);
+        gTableTexture = NULL;
+    }
+#endif
+    profiler_destroy(&gProfiler);
+    release_text();
     SDL_DestroyRenderer(gRenderer);
     SDL_DestroyWindow(gWindow);
     gWindow = NULL;
@@ -401,24 +1227,95 @@ void cleanup() {
 
     TTF_Quit();
     SDL_Quit();
+
+    // Fonts read the pack in place, so it goes last
+    assetpack_free(gAssets);
+    gAssets = NULL;
+    arena_free(&gFrameArena);
+}
+
+/**
+ * @brief Draws everything that does not change during play: the rails
+ * (background), the felt and the pockets.
+ */
+void draw_table() {
+    // --- Clear screen (brown background) ---
+    SDL_SetRenderDrawColor(gRenderer, 50, 25, 0, 255);
+    SDL_RenderClear(gRenderer);
+
+    // --- Draw table ---
+    // Felt
+    SDL_Rect tableRect = {
+        (int)gLayout.originX,
+        (int)gLayout.originY,
+        (int)lrintf(TABLE_WIDTH * gLayout.scale),
+        (int)lrintf(TABLE_HEIGHT * gLayout.scale)
+    };
+    SDL_SetRenderDrawColor(gRenderer, 0, 85, 0, 255);
+    SDL_RenderFillRect(gRenderer, &tableRect);
+
+    // --- Draw pockets ---
+    for (int i = 0; i < NUM_POCKETS; ++i) {
+        draw_pocket(&gTable.geometry.pockets[i]);
+    }
+}
+
+/**
+ * @brief Returns a ball's color on the current variant's table. Practice
+ * balls past 15 reuse the pool colors in order.
+ * @param id The ball id.
+ */
+SDL_Color ball_color(int id) {
+    if (id == 0) {
+        return BALL_COLORS[0];
+    }
+    switch (gTable.variant) {
+    case VARIANT_SNOOKER:
+        return SNOOKER_COLORS[id <= 15 ? 0 : id - 15];
+    case VARIANT_PRACTICE:
+        return BALL_COLORS[(id - 1) % 15 + 1];
+    default:
+        return BALL_COLORS[id];
+    }
 }
 
+/**
+ * @brief Returns whether a ball is drawn with a stripe: pool balls 9-15
+ * (and their practice repeats), never a snooker ball.
+ * @param id The ball id.
+ */
+bool ball_striped(int id) {
+    switch (gTable.variant) {
+    case VARIANT_SNOOKER:
+        return false;
+    case VARIANT_PRACTICE:
+        return id > 0 && (id - 1) % 15 + 1 > 8;
+    default:
+        return id > 8;
+    }
+}
+
+#ifdef LEGACY_RENDER
+
 /**
  * @brief Draws a pool ball with an outline and optional stripe.
- * @param ball Pointer to the ball to render.
+ * @param id The id of the ball to render.
+ * @param pos The (interpolated) position to draw it at.
  */
-void draw_ball(Ball* ball) {
-    int cx = (int)ball->pos.x;
-    int cy = (int)ball->pos.y;
+void draw_ball(int id, Vec2D pos) {
+    Vec2D screen = to_screen(pos);
+    int cx = (int)screen.x;
+    int cy = (int)screen.y;
+    const int radius = gLayout.ballRadius;
 
     // Outline for better visibility
-    draw_circle(cx, cy, BALL_RADIUS + 2, (SDL_Color){0, 0, 0, 255});
+    draw_circle(cx, cy, gLayout.ballHalf, (SDL_Color){0, 0, 0, 255});
 
-    for (int w = -BALL_RADIUS; w <= BALL_RADIUS; ++w) {
-        for (int h = -BALL_RADIUS; h <= BALL_RADIUS; ++h) {
-            if (w * w + h * h <= BALL_RADIUS * BALL_RADIUS) {
-                SDL_Color color = ball->color;
-                if (ball->id > 8 && abs(h) < BALL_RADIUS * 0.3f) {
+    for (int w = -radius; w <= radius; ++w) {
+        for (int h = -radius; h <= radius; ++h) {
+            if (w * w + h * h <= radius * radius) {
+                SDL_Color color = ball_color(id);
+                if (ball_striped(id) && abs(h) < radius * 0.3f) {
                     color = (SDL_Color){255, 255, 255, 255};
                 }
 
@@ -429,6 +1326,15 @@ void draw_ball(Ball* ball) {
     }
 }
 
+/**
+ * @brief Draws a pocket as a filled black circle.
+ * @param pocket Pointer to the pocket to render.
+ */
+void draw_pocket(Pocket* pocket) {
+    Vec2D screen = to_screen(pocket->pos);
+    draw_circle((int)screen.x, (int)screen.y, gLayout.pocketRadius, (SDL_Color){0, 0, 0, 255});
+}
+
 
 /**
  * @brief A helper function to draw a filled circle.
@@ -450,11 +1356,542 @@ void draw_circle(int centerX, int centerY, int radius, SDL_Color color) {
     }
 }
 
+#elif defined(GEOMETRY_RENDER)
+
+/**
+ * @brief Adds a pool ball to the frame's batch: the body cell tinted with
+ * the ball's color, and the stripe cell over it for striped balls. Snapped
+ * to whole pixels like the sprites, so both paths draw the same pixels.
+ * @param id The id of the ball to render.
+ * @param pos The (interpolated) position to draw it at.
+ */
+void draw_ball(int id, Vec2D pos) {
+    Vec2D screen = to_screen(pos);
+    Vec2D center = {(int)screen.x + 0.5f, (int)screen.y + 0.5f};
+    batch_disc(ATLAS_BODY, center, ball_color(id));
+    if (ball_striped(id)) {
+        batch_disc(ATLAS_STRIPE, center, (SDL_Color){255, 255, 255, 255});
+    }
+}
+
+#else
+
+/**
+ * @brief Draws a pool ball by copying its cached sprite.
+ * @param id The id of the ball to render.
+ * @param pos The (interpolated) position to draw it at.
+ */
+void draw_ball(int id, Vec2D pos) {
+    Vec2D screen = to_screen(pos);
+    SDL_Rect dst = {
+        (int)screen.x - gLayout.ballHalf,
+        (int)screen.y - gLayout.ballHalf,
+        gLayout.ballSize,
+        gLayout.ballSize
+    };
+    SDL_RenderCopy(gRenderer, gBallTextures[id], NULL, &dst);
+}
+
+#endif
+
+#ifndef LEGACY_RENDER
+
+/**
+ * @brief Draws a pocket by copying the cached pocket sprite.
+ * @param pocket Pointer to the pocket to render.
+ */
+void draw_pocket(Pocket* pocket) {
+    Vec2D screen = to_screen(pocket->pos);
+    SDL_Rect dst = {
+        (int)screen.x - gLayout.pocketRadius,
+        (int)screen.y - gLayout.pocketRadius,
+        gLayout.pocketSize,
+        gLayout.pocketSize
+    };
+    SDL_RenderCopy(gRenderer, gPocketTexture, NULL, &dst);
+}
+
+/**
+ * @brief Builds the ball and pocket sprites at the layout's scale (with
+ * GEOMETRY_RENDER, the ball atlas and tessellated disc instead of the ball
+ * sprites).
+ * @return true on success, false on failure.
+ */
+bool create_sprites() {
+#ifdef GEOMETRY_RENDER
+    tessellate_disc();
+    gAtlas = create_atlas();
+    if (gAtlas == NULL) {
+        printf("Ball atlas could not be created! SDL_Error: %s\n", SDL_GetError());
+        return false;
+    }
+#else
+    for (int i = 0; i < gTable.ballCount; ++i) {
+        gBallTextures[i] = create_ball_texture(i);
+        if (gBallTextures[i] == NULL) {
+            printf("Ball sprite could not be created! SDL_Error: %s\n", SDL_GetError());
+            return false;
+        }
+    }
+#endif
+
+    gPocketTexture = create_pocket_texture();
+    if (gPocketTexture == NULL) {
+        printf("Pocket sprite could not be created! SDL_Error: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Frees all cached sprites.
+ */
+void destroy_sprites() {
+#ifdef GEOMETRY_RENDER
+    if (gAtlas != NULL) {
+        SDL_DestroyTexture(gAtlas);
+        gAtlas = NULL;
+    }
+#else
+    for (int i = 0; i < MAX_BALLS; ++i) {
+        if (gBallTextures[i] != NULL) {
+            SDL_DestroyTexture(gBallTextures[i]);
+            gBallTextures[i] = NULL;
+        }
+    }
+#endif
+    if (gPocketTexture != NULL) {
+        SDL_DestroyTexture(gPocketTexture);
+        gPocketTexture = NULL;
+    }
+}
+
+#ifdef GEOMETRY_RENDER
+
+/**
+ * @brief Rasterizes the ball atlas: a white ball with its black outline
+ * (tinted per ball by vertex color), the stripe band on its own and a
+ * solid white cell. Each ball cell has the same pixels as a ball sprite.
+ * @return The new texture, or NULL on failure.
+ */
+SDL_Texture* create_atlas() {
+    const int size = gLayout.ballSize;
+    const int half = gLayout.ballHalf;
+    const int radius = gLayout.ballRadius;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_CELLS * size, size, 32, SDL_PIXELFORMAT_RGBA32);
+    if (surface == NULL) {
+        return NULL;
+    }
+
+    const int bodyX = ATLAS_BODY * size + half;
+    const int stripeX = ATLAS_STRIPE * size + half;
+    rasterize_circle(surface, bodyX, half, half, (SDL_Color){0, 0, 0, 255});
+
+    Uint32* pixels = (Uint32*)surface->pixels;
+    int stride = surface->pitch / 4;
+    Uint32 white = SDL_MapRGBA(surface->format, 255, 255, 255, 255);
+    for (int w = -radius; w <= radius; ++w) {
+        for (int h = -radius; h <= radius; ++h) {
+            if (w * w + h * h <= radius * radius) {
+                pixels[(half + h) * stride + bodyX + w] = white;
+                if (abs(h) < radius * 0.3f) {
+                    pixels[(half + h) * stride + stripeX + w] = white;
+                }
+            }
+        }
+    }
+    for (int y = 0; y < size; ++y) {
+        for (int x = ATLAS_WHITE * size; x < ATLAS_CELLS * size; ++x) {
+            pixels[y * stride + x] = white;
+        }
+    }
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(gRenderer, surface);
+    SDL_FreeSurface(surface);
+    return texture;
+}
+
+/**
+ * @brief Computes the ball outline polygon for the layout's scale. Its
+ * corners lie far enough out that the polygon covers every pixel of the
+ * ball's outline.
+ */
+void tessellate_disc() {
+    float radius = (gLayout.ballHalf + 0.5f) / cosf((float)M_PI / DISC_SEGMENTS);
+    for (int i = 0; i < DISC_SEGMENTS; ++i) {
+        float angle = 2.0f * (float)M_PI * i / DISC_SEGMENTS;
+        gDiscRim[i] = (Vec2D){radius * cosf(angle), radius * sinf(angle)};
+    }
+}
+
+/**
+ * @brief Adds a triangle fan of the tessellated ball to the batch, textured
+ * with one atlas cell and tinted with a color.
+ * @param cell The atlas cell (ATLAS_BODY or ATLAS_STRIPE).
+ * @param center The ball's center on screen.
+ * @param color The tint.
+ */
+void batch_disc(int cell, Vec2D center, SDL_Color color) {
+    if (gBatchVertexCount + DISC_SEGMENTS + 1 > MAX_BATCH_VERTICES ||
+        gBatchIndexCount + DISC_SEGMENTS * 3 > MAX_BATCH_INDICES) {
+        return;
+    }
+
+    const float size = (float)gLayout.ballSize;
+    const float atlasWidth = ATLAS_CELLS * size;
+    const float uCenter = cell * size + gLayout.ballHalf + 0.5f;
+    const float vCenter = gLayout.ballHalf + 0.5f;
+    const int first = gBatchVertexCount;
+    gBatchVertices[gBatchVertexCount++] = (SDL_Vertex){
+        {center.x, center.y}, color, {uCenter / atlasWidth, vCenter / size}
+    };
+    for (int i = 0; i < DISC_SEGMENTS; ++i) {
+        Vec2D rim = gDiscRim[i];
+        gBatchVertices[gBatchVertexCount++] = (SDL_Vertex){
+            {center.x + rim.x, center.y + rim.y}, color,
+            {(uCenter + rim.x) / atlasWidth, (vCenter + rim.y) / size}
+        };
+        gBatchIndices[gBatchIndexCount++] = first;
+        gBatchIndices[gBatchIndexCount++] = first + 1 + i;
+        gBatchIndices[gBatchIndexCount++] = first + 1 + (i + 1) % DISC_SEGMENTS;
+    }
+}
+
+/**
+ * @brief Adds a one pixel wide line to the batch as a quad over the atlas's
+ * white cell.
+ */
+void batch_line(Vec2D from, Vec2D to, SDL_Color color) {
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length == 0.0f || gBatchVertexCount + 4 > MAX_BATCH_VERTICES || gBatchIndexCount + 6 > MAX_BATCH_INDICES) {
+        return;
+    }
+
+    // Half a pixel either side of the line
+    float nx = -dy / length * 0.5f;
+    float ny = dx / length * 0.5f;
+    const float size = (float)gLayout.ballSize;
+    const SDL_FPoint white = {(ATLAS_WHITE * size + 1.5f) / (ATLAS_CELLS * size), 1.5f / size};
+    const int first = gBatchVertexCount;
+    gBatchVertices[gBatchVertexCount++] = (SDL_Vertex){{from.x + nx, from.y + ny}, color, white};
+    gBatchVertices[gBatchVertexCount++] = (SDL_Vertex){{from.x - nx, from.y - ny}, color, white};
+    gBatchVertices[gBatchVertexCount++] = (SDL_Vertex){{to.x - nx, to.y - ny}, color, white};
+    gBatchVertices[gBatchVertexCount++] = (SDL_Vertex){{to.x + nx, to.y + ny}, color, white};
+    static const int QUAD[6] = {0, 1, 2, 0, 2, 3};
+    for (int i = 0; i < 6; ++i) {
+        gBatchIndices[gBatchIndexCount++] = first + QUAD[i];
+    }
+}
+
+/**
+ * @brief Draws everything batched this frame with one SDL_RenderGeometry()
+ * call and empties the batch.
+ */
+void flush_batch() {
+    if (gBatchIndexCount > 0) {
+        SDL_RenderGeometry(gRenderer, gAtlas, gBatchVertices, gBatchVertexCount, gBatchIndices, gBatchIndexCount);
+    }
+    gBatchVertexCount = 0;
+    gBatchIndexCount = 0;
+}
+
+#else
+
+/**
+ * @brief Rasterizes a ball (outline, body and optional stripe) into a texture.
+ * @param id The ball id, which defines its color and stripe.
+ * @return The new texture, or NULL on failure.
+ */
+SDL_Texture* create_ball_texture(int id) {
+    const int half = gLayout.ballHalf;
+    const int radius = gLayout.ballRadius;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, gLayout.ballSize, gLayout.ballSize, 32, SDL_PIXELFORMAT_RGBA32);
+    if (surface == NULL) {
+        return NULL;
+    }
+
+    // Outline for better visibility
+    rasterize_circle(surface, half, half, half, (SDL_Color){0, 0, 0, 255});
+
+    Uint32* pixels = (Uint32*)surface->pixels;
+    int stride = surface->pitch / 4;
+    for (int w = -radius; w <= radius; ++w) {
+        for (int h = -radius; h <= radius; ++h) {
+            if (w * w + h * h <= radius * radius) {
+                SDL_Color color = ball_color(id);
+                if (ball_striped(id) && abs(h) < radius * 0.3f) {
+                    color = (SDL_Color){255, 255, 255, 255};
+                }
+                pixels[(half + h) * stride + half + w] =
+                    SDL_MapRGBA(surface->format, color.r, color.g, color.b, color.a);
+            }
+        }
+    }
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(gRenderer, surface);
+    SDL_FreeSurface(surface);
+    return texture;
+}
+
+#endif
+
+/**
+ * @brief Rasterizes the pocket circle into a texture.
+ * @return The new texture, or NULL on failure.
+ */
+SDL_Texture* create_pocket_texture() {
+    const int radius = gLayout.pocketRadius;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, gLayout.pocketSize, gLayout.pocketSize, 32, SDL_PIXELFORMAT_RGBA32);
+    if (surface == NULL) {
+        return NULL;
+    }
+
+    rasterize_circle(surface, radius, radius, radius, (SDL_Color){0, 0, 0, 255});
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(gRenderer, surface);
+    SDL_FreeSurface(surface);
+    return texture;
+}
+
+/**
+ * @brief Renders the static table into gTableTexture so each frame can start
+ * with a single copy. Called lazily from render() whenever the layer is dirty
+ * (on reset, layout change or render target loss). If render targets are not
+ * available, gTableTexture stays NULL and render() draws the table directly.
+ */
+void build_table_layer() {
+    gTableLayerDirty = false;
+
+    if (gTableTexture == NULL) {
+        gTableTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+                                          gLayout.outputWidth, gLayout.outputHeight);
+        if (gTableTexture == NULL) {
+            printf("Table layer could not be created! SDL_Error: %s\n", SDL_GetError());
+            return;
+        }
+    }
+
+    if (SDL_SetRenderTarget(gRenderer, gTableTexture) < 0) {
+        printf("Table layer could not be drawn! SDL_Error: %s\n", SDL_GetError());
+        SDL_DestroyTexture(gTableTexture);
+        gTableTexture = NULL;
+        return;
+    }
+    draw_table();
+    SDL_SetRenderTarget(gRenderer, NULL);
+}
+
+/**
+ * @brief Fills a circle into an RGBA32 surface. Covers exactly the pixels the
+ * legacy draw_circle() would plot; pixels outside it stay transparent.
+ * @param surface The destination surface (fresh surfaces are zeroed).
+ * @param centerX The x-coordinate of the circle's center.
+ * @param centerY The y-coordinate of the circle's center.
+ * @param radius The radius of the circle.
+ * @param color The color of the circle.
+ */
+void rasterize_circle(SDL_Surface* surface, int centerX, int centerY, int radius, SDL_Color color) {
+    Uint32* pixels = (Uint32*)surface->pixels;
+    int stride = surface->pitch / 4;
+    Uint32 value = SDL_MapRGBA(surface->format, color.r, color.g, color.b, color.a);
+    for (int w = 0; w < radius * 2; w++) {
+        for (int h = 0; h < radius * 2; h++) {
+            int dx = radius - w; // horizontal offset
+            int dy = radius - h; // vertical offset
+            int x = centerX + dx;
+            int y = centerY + dy;
+            if ((dx * dx + dy * dy) <= (radius * radius) &&
+                x >= 0 && x < surface->w && y >= 0 && y < surface->h) {
+                pixels[y * stride + x] = value;
+            }
+        }
+    }
+}
+
+#endif
+
+/**
+ * @brief Splits a "HOST:PORT" argument.
+ * @param address The argument.
+ * @param host Receives the host.
+ * @param size The size of host.
+ * @param port Receives the port.
+ * @return false if the argument is not of that form.
+ */
+bool split_address(const char* address, char* host, size_t size, int* port) {
+    const char* colon = strrchr(address, ':');
+    if (colon == NULL || colon == address || (size_t)(colon - address) >= size || atoi(colon + 1) <= 0) {
+        return false;
+    }
+    memcpy(host, address, (size_t)(colon - address));
+    host[colon - address] = '\0';
+    *port = atoi(colon + 1);
+    return true;
+}
+
 
 // --- Main Entry Point ---
 int main(int argc, char* args[]) {
+    int physicsHz = DEFAULT_PHYSICS_HZ;
+    const char* shotsPath = NULL;
+    const char* outPath = NULL;
+    const char* replayPath = NULL;
+    const char* trajPath = NULL;
+    const char* viewPath = NULL;
+    const char* assetsPath = NULL;
+    uint32_t rackSeed = 0;
+    int numThreads = 0;
+    int cacheMegabytes = 0;
+    Solver solver = SOLVER_FIXED_STEP;
+    bool fastForward = true;
+    bool computerOpponent = false;
+    int hostPort = 0;
+    const char* joinAddress = NULL;
+    int broadcastPort = 0;
+    const char* watchAddress = NULL;
+    TableVariant variant = VARIANT_EIGHT_BALL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(args[i], "--physics-hz") == 0 && i + 1 < argc) {
+            physicsHz = atoi(args[++i]);
+        } else if (strcmp(args[i], "--headless") == 0 && i + 1 < argc) {
+            shotsPath = args[++i];
+        } else if (strcmp(args[i], "--out") == 0 && i + 1 < argc) {
+            outPath = args[++i];
+        } else if (strcmp(args[i], "--threads") == 0 && i + 1 < argc) {
+            numThreads = atoi(args[++i]);
+        } else if (strcmp(args[i], "--solver") == 0 && i + 1 < argc && strcmp(args[i + 1], "step") == 0) {
+            solver = SOLVER_FIXED_STEP;
+            i++;
+        } else if (strcmp(args[i], "--solver") == 0 && i + 1 < argc && strcmp(args[i + 1], "events") == 0) {
+            solver = SOLVER_EVENTS;
+            i++;
+        } else if (strcmp(args[i], "--no-fast-forward") == 0) {
+            fastForward = false;
+        } else if (strcmp(args[i], "--profile-out") == 0 && i + 1 < argc) {
+            gProfilePath = args[++i];
+        } else if (strcmp(args[i], "--font") == 0 && i + 1 < argc) {
+            gFontPath = args[++i];
+        } else if (strcmp(args[i], "--assets") == 0 && i + 1 < argc) {
+            assetsPath = args[++i];
+        } else if (strcmp(args[i], "--variant") == 0 && i + 1 < argc && variant_from_name(args[i + 1], &variant)) {
+            i++;
+        } else if (strcmp(args[i], "--rack-seed") == 0 && i + 1 < argc) {
+            rackSeed = (uint32_t)strtoul(args[++i], NULL, 10);
+        } else if (strcmp(args[i], "--record") == 0 && i + 1 < argc) {
+            gRecordPath = args[++i];
+        } else if (strcmp(args[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = args[++i];
+        } else if (strcmp(args[i], "--cache-mb") == 0 && i + 1 < argc) {
+            cacheMegabytes = atoi(args[++i]);
+        } else if (strcmp(args[i], "--trajectory") == 0 && i + 1 < argc) {
+            trajPath = args[++i];
+        } else if (strcmp(args[i], "--view") == 0 && i + 1 < argc) {
+            viewPath = args[++i];
+        } else if (strcmp(args[i], "--view-shot") == 0 && i + 1 < argc) {
+            gViewShot = atoi(args[++i]) - 1;
+        } else if (strcmp(args[i], "--ai") == 0) {
+            computerOpponent = true;
+        } else if (strcmp(args[i], "--ai-time") == 0 && i + 1 < argc) {
+            gAiBudget = atof(args[++i]);
+        } else if (strcmp(args[i], "--host") == 0 && i + 1 < argc) {
+            hostPort = atoi(args[++i]);
+        } else if (strcmp(args[i], "--join") == 0 && i + 1 < argc) {
+            joinAddress = args[++i];
+        } else if (strcmp(args[i], "--broadcast") == 0 && i + 1 < argc) {
+            broadcastPort = atoi(args[++i]);
+        } else if (strcmp(args[i], "--watch") == 0 && i + 1 < argc) {
+            watchAddress = args[++i];
+        } else {
+            printf("Usage: %s [--physics-hz N] [--solver step|events] [--variant 8ball|9ball|snooker|practice] [--rack-seed N] [--record FILE] [--replay FILE] [--profile-out CSV] [--font TTF] [--assets PACK] [--ai [--ai-time SECONDS]] [--host PORT | --join HOST:PORT] [--watch HOST:PORT] [--view TRAJ [--view-shot N]] [--headless SHOTS [--out FILE] [--threads N] [--no-fast-forward] [--cache-mb N] [--trajectory TRAJ] [--broadcast PORT]]\n", args[0]);
+            return 1;
+        }
+    }
+    init_table(&gTable, physicsHz);
+    gTable.solver = solver;
+    gTable.variant = variant;
+    gTable.rackSeed = rackSeed;
+    setup_table(&gTable);
+
+    // Replays carry their own settings and are verified without a window
+    if (replayPath != NULL) {
+        return run_replay(replayPath);
+    }
+
+    // Headless mode never touches SDL. It fast-forwards quiet tables to rest
+    // by default; the game shows every step.
+    if (shotsPath != NULL && broadcastPort > 0) {
+        return run_broadcast(broadcastPort, shotsPath, &gTable);
+    }
+    if (shotsPath != NULL) {
+        gTable.fastForward = fastForward;
+        size_t cacheBytes = cacheMegabytes > 0 ? (size_t)cacheMegabytes << 20 : 0;
+        return run_headless(shotsPath, outPath, trajPath, &gTable, numThreads, cacheBytes);
+    }
+
+    // An asset pack on disk replaces the one linked in
+    gAssets = assetsPath != NULL ? assetpack_open(assetsPath) : assetpack_embedded();
+    if (assetsPath != NULL && gAssets == NULL) {
+        return 1;
+    }
+
+    // The viewer shows a log on a table racked like the logged one
+    if (viewPath != NULL) {
+        gViewer = trajlog_open(viewPath);
+        if (gViewer == NULL || trajlog_header(gViewer)->shotCount == 0) {
+            printf("No shots to view in '%s'!\n", viewPath);
+            trajlog_free(gViewer);
+            return 1;
+        }
+        set_physics_rate(&gTable, (int)trajlog_header(gViewer)->physicsHz);
+        gTable.rackSeed = trajlog_header(gViewer)->rackSeed;
+        gTable.variant = (TableVariant)trajlog_header(gViewer)->variant;
+    } else if ((hostPort > 0 || joinAddress != NULL) && computerOpponent) {
+        printf("Online play and --ai cannot be combined!\n");
+        return 1;
+    } else if (hostPort > 0) {
+        // The host's settings and rack are the session's; a guest adopts them
+        gNet = netplay_host(hostPort, &gTable);
+        if (gNet == NULL) {
+            return 1;
+        }
+    } else if (joinAddress != NULL) {
+        char host[256];
+        int port;
+        if (!split_address(joinAddress, host, sizeof(host), &port)) {
+            printf("Expected --join HOST:PORT, not '%s'!\n", joinAddress);
+            return 1;
+        }
+        gNet = netplay_join(host, port, &gTable);
+        if (gNet == NULL) {
+            return 1;
+        }
+    } else if (watchAddress != NULL) {
+        char host[256];
+        int port;
+        if (!split_address(watchAddress, host, sizeof(host), &port)) {
+            printf("Expected --watch HOST:PORT, not '%s'!\n", watchAddress);
+            return 1;
+        }
+        gWatch = spectator_connect(host, port, &gTable);
+        if (gWatch == NULL) {
+            return 1;
+        }
+    } else if (computerOpponent) {
+        gAi = ai_create(numThreads);
+        if (gAi == NULL) {
+            printf("Failed to start the computer opponent!\n");
+            return 1;
+        }
+    }
+
     if (!initialize()) {
         printf("Failed to initialize!\n");
+    } else if (gViewer != NULL) {
+        view_loop();
+    } else if (gWatch != NULL) {
+        watch_loop();
     } else {
         game_loop();
     }
@@ -0,0 +1,57 @@
+// -----------------------------------------------------------------------------
+// Asset pack builder for the 8-Ball Pool Game
+//
+// Packs files into an asset pack (see assetpack.c) for --assets or for
+// linking into the game with `make ASSETS=FILE`. Each argument is
+// NAME=FILE, or just FILE to name the asset after the file itself.
+//
+// To build: `make mkpack`
+// -----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "assetpack.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printf("Usage: %s PACK NAME=FILE|FILE...\n", argv[0]);
+        return 1;
+    }
+
+    int count = argc - 2;
+    const char** names = malloc(count * sizeof(const char*));
+    const char** files = malloc(count * sizeof(const char*));
+    if (names == NULL || files == NULL) {
+        printf("Out of memory!\n");
+        return 1;
+    }
+    for (int i = 0; i < count; ++i) {
+        char* arg = argv[i + 2];
+        char* equals = strchr(arg, '=');
+        if (equals != NULL) {
+            *equals = '\0';
+            names[i] = arg;
+            files[i] = equals + 1;
+        } else {
+            const char* slash = strrchr(arg, '/');
+            const char* backslash = strrchr(arg, '\\');
+            if (backslash != NULL && (slash == NULL || backslash > slash)) slash = backslash;
+            names[i] = slash != NULL ? slash + 1 : arg;
+            files[i] = arg;
+        }
+    }
+
+    bool ok = assetpack_write(argv[1], names, files, count);
+    if (ok) {
+        AssetPack* pack = assetpack_open(argv[1]);
+        ok = pack != NULL && assetpack_count(pack) == count;
+        if (ok) {
+            printf("Packed %d assets into %s\n", count, argv[1]);
+        }
+        assetpack_free(pack);
+    }
+    free(names);
+    free(files);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,264 @@
+// -----------------------------------------------------------------------------
+// Minimal TCP sockets for the 8-Ball Pool Game
+//
+// Connections are plain TCP with Nagle's algorithm disabled, since the game
+// sends small messages that should go out at once. Errors are reported on
+// stdout by the function that hits them and returned as NET_INVALID_SOCKET,
+// false or -1, except that send and receive failures are left to the caller.
+// -----------------------------------------------------------------------------
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+#include "net.h"
+
+// A peer that has gone away makes send() fail rather than raise SIGPIPE
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+// --- Function Prototypes ---
+static void set_no_delay(NetSocket sock);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Initializes the socket library (Winsock on Windows); call once
+ * before any other net_ function.
+ * @return true on success.
+ */
+bool net_startup() {
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        printf("Could not initialize Winsock!\n");
+        return false;
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Releases the socket library.
+ */
+void net_shutdown() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+/**
+ * @brief Opens a TCP socket listening on a port on every interface.
+ * @param port The port to listen on.
+ * @return The listening socket, or NET_INVALID_SOCKET on failure.
+ */
+NetSocket net_listen(int port) {
+    NetSocket sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock == NET_INVALID_SOCKET) {
+        printf("Could not create a socket!\n");
+        return NET_INVALID_SOCKET;
+    }
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(sock, 16) != 0) {
+        printf("Could not listen on port %d!\n", port);
+        net_close(sock);
+        return NET_INVALID_SOCKET;
+    }
+    return sock;
+}
+
+/**
+ * @brief Waits for and accepts a connection on a listening socket.
+ * @param listener The listening socket.
+ * @return The connected socket, or NET_INVALID_SOCKET on failure.
+ */
+NetSocket net_accept(NetSocket listener) {
+    NetSocket sock = accept(listener, NULL, NULL);
+    if (sock == NET_INVALID_SOCKET) {
+        printf("Could not accept a connection!\n");
+        return NET_INVALID_SOCKET;
+    }
+    set_no_delay(sock);
+    return sock;
+}
+
+/**
+ * @brief Connects to a host by name or address.
+ * @param host The host name or numeric address.
+ * @param port The port to connect to.
+ * @return The connected socket, or NET_INVALID_SOCKET on failure.
+ */
+NetSocket net_connect(const char* host, int port) {
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* found = NULL;
+    if (getaddrinfo(host, service, &hints, &found) != 0) {
+        printf("Could not resolve '%s'!\n", host);
+        return NET_INVALID_SOCKET;
+    }
+
+    NetSocket sock = NET_INVALID_SOCKET;
+    for (struct addrinfo* ai = found; ai != NULL && sock == NET_INVALID_SOCKET; ai = ai->ai_next) {
+        sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (sock != NET_INVALID_SOCKET && connect(sock, ai->ai_addr, (int)ai->ai_addrlen) != 0) {
+            net_close(sock);
+            sock = NET_INVALID_SOCKET;
+        }
+    }
+    freeaddrinfo(found);
+    if (sock == NET_INVALID_SOCKET) {
+        printf("Could not connect to %s:%d!\n", host, port);
+        return NET_INVALID_SOCKET;
+    }
+    set_no_delay(sock);
+    return sock;
+}
+
+/**
+ * @brief Sends a whole buffer, blocking until it is queued.
+ * @return false if the connection failed.
+ */
+bool net_send_all(NetSocket sock, const void* data, int size) {
+    const char* bytes = data;
+    while (size > 0) {
+        int sent = (int)send(sock, bytes, size, SEND_FLAGS);
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+/**
+ * @brief Sends as much of a buffer as the socket takes without blocking
+ * (see net_set_blocking()).
+ * @return The number of bytes sent, 0 if the socket's send buffer is full
+ * or -1 if the connection failed.
+ */
+int net_send(NetSocket sock, const void* data, int size) {
+    int sent = (int)send(sock, data, size, SEND_FLAGS);
+    if (sent >= 0) {
+        return sent;
+    }
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : -1;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+#endif
+}
+
+/**
+ * @brief Receives whatever is available, up to size bytes, blocking until
+ * something is.
+ * @return The number of bytes received, 0 if the peer closed the
+ * connection or -1 on error.
+ */
+int net_recv(NetSocket sock, void* buffer, int size) {
+    int received = (int)recv(sock, buffer, size, 0);
+    return received < 0 ? -1 : received;
+}
+
+/**
+ * @brief Receives exactly size bytes, blocking until they arrive.
+ * @return false if the connection closed or failed first.
+ */
+bool net_recv_all(NetSocket sock, void* buffer, int size) {
+    char* bytes = buffer;
+    while (size > 0) {
+        int received = net_recv(sock, bytes, size);
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= received;
+    }
+    return true;
+}
+
+/**
+ * @brief Waits until a socket can be read without blocking (data, a
+ * connection to accept or the peer closing).
+ * @param sock The socket.
+ * @param timeoutMs How long to wait at most.
+ * @return 1 if it is readable, 0 on timeout, -1 on error.
+ */
+int net_wait(NetSocket sock, int timeoutMs) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(sock, &readable);
+    struct timeval timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+    int ready = select((int)sock + 1, &readable, NULL, NULL, &timeout);
+    return ready < 0 ? -1 : ready > 0;
+}
+
+/**
+ * @brief Makes a socket's sends and receives block or return at once.
+ * @return false on failure.
+ */
+bool net_set_blocking(NetSocket sock, bool blocking) {
+#ifdef _WIN32
+    u_long nonBlocking = blocking ? 0 : 1;
+    return ioctlsocket(sock, FIONBIO, &nonBlocking) == 0;
+#else
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0) {
+        return false;
+    }
+    flags = blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK;
+    return fcntl(sock, F_SETFL, flags) == 0;
+#endif
+}
+
+/**
+ * @brief Closes a socket; NET_INVALID_SOCKET is ignored.
+ */
+void net_close(NetSocket sock) {
+    if (sock == NET_INVALID_SOCKET) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(sock);
+#endif
+}
+
+/**
+ * @brief Disables Nagle's algorithm, so small messages are sent at once.
+ */
+static void set_no_delay(NetSocket sock) {
+    int on = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+}
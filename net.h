@@ -0,0 +1,39 @@
+// -----------------------------------------------------------------------------
+// Minimal TCP sockets for the 8-Ball Pool Game
+//
+// A thin layer over BSD sockets and Winsock, so the networked modules build
+// unchanged on Linux and Windows. Sockets start out blocking; net_wait()
+// tells when one can be read without blocking, and net_set_blocking() and
+// net_send() serve many peers from one thread.
+// -----------------------------------------------------------------------------
+
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET NetSocket;
+#define NET_INVALID_SOCKET INVALID_SOCKET
+#else
+typedef int NetSocket;
+#define NET_INVALID_SOCKET (-1)
+#endif
+
+// --- Function Prototypes ---
+bool net_startup();
+void net_shutdown();
+NetSocket net_listen(int port);
+NetSocket net_accept(NetSocket listener);
+NetSocket net_connect(const char* host, int port);
+bool net_send_all(NetSocket sock, const void* data, int size);
+int net_send(NetSocket sock, const void* data, int size);
+int net_recv(NetSocket sock, void* buffer, int size);
+bool net_recv_all(NetSocket sock, void* buffer, int size);
+int net_wait(NetSocket sock, int timeoutMs);
+bool net_set_blocking(NetSocket sock, bool blocking);
+void net_close(NetSocket sock);
+
+#endif
@@ -0,0 +1,580 @@
+// -----------------------------------------------------------------------------
+// Lockstep online play for the 8-Ball Pool Game
+//
+// Wire format (all integers little-endian):
+//   handshake: "PNET", u32 version, u32 physicsHz, u32 solver, u32 rackSeed,
+//              u32 flags, u32 variant. The host sends its settings and the
+//              guest adopts them, then answers with the same record, its
+//              own flags.
+//   message:   u8 type, 3 bytes zero, u32 epoch, u64 tick, u32 cue x bits,
+//              u32 cue y bits, u64 table hash
+//
+// A shot (or placement) is applied by the receiver once its own table has
+// come to rest at the shot's tick, so a peer that is still animating the
+// previous shot simply applies it a little later. Resets carry a new epoch;
+// shots from an epoch the receiver has already reset past were taken on a
+// table both sides are about to throw away, and are dropped.
+//
+// The network thread sends queued messages and receives into the inbox;
+// everything else runs on the game thread.
+// -----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "net.h"
+#include "netplay.h"
+
+#define HANDSHAKE_SIZE 28
+#define MESSAGE_SIZE 32
+
+// Handshake flags; both sides must agree on them
+#define FLAG_FIXED_POINT 1u // Built with POOL_FIXED_POINT
+
+// A fixed-size message queue
+typedef struct {
+    NetMessage messages[NETPLAY_QUEUE_SIZE];
+    int head;
+    int count;
+} MessageQueue;
+
+struct NetSession {
+    NetSocket sock;
+    bool host;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    bool shuttingDown;
+    bool closed;        // The connection ended
+    MessageQueue inbox;  // Received, not yet handled
+    MessageQueue outbox; // Queued for the network thread
+
+    // Owned by the game thread
+    uint32_t epoch;     // Table resets so far
+    bool desync;
+    bool hasPending;    // pending is a received message that must wait
+    NetMessage pending;
+    NetMessage local[NETPLAY_HISTORY];  // Recent checkpoints of each side
+    NetMessage remote[NETPLAY_HISTORY];
+    int localNext;
+    int remoteNext;
+    bool checked;       // lastCheck holds the latest local checkpoint
+    NetMessage lastCheck;
+};
+
+// --- Function Prototypes ---
+static NetSocket accept_guest(int port, const Table* table);
+static NetSocket join_host(const char* host, int port, Table* table);
+static NetSession* start_session(NetSocket sock, bool host);
+static void* net_main(void* arg);
+static bool push(NetSession* session, MessageQueue* queue, const NetMessage* message);
+static bool pop(NetSession* session, MessageQueue* queue, NetMessage* message);
+static void record_check(NetSession* session, const NetMessage* check, bool mine);
+static uint64_t table_tick(const Table* table);
+static uint32_t build_flags();
+static void encode_handshake(unsigned char* p, const Table* table);
+static void encode_message(unsigned char* p, const NetMessage* message);
+static void decode_message(const unsigned char* p, NetMessage* message);
+static void put_u32(unsigned char* p, uint32_t v);
+static void put_u64(unsigned char* p, uint64_t v);
+static uint32_t get_u32(const unsigned char* p);
+static uint64_t get_u64(const unsigned char* p);
+static uint32_t float_bits(float f);
+static float bits_float(uint32_t bits);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Waits for a player to connect and starts a session with the
+ * host's physics rate, solver, table variant and rack seed. The host breaks.
+ * @param port The port to listen on.
+ * @param table The host's table; its settings are sent to the guest.
+ * @return The session, or NULL if no player could connect.
+ */
+NetSession* netplay_host(int port, const Table* table) {
+    if (!net_startup()) {
+        return NULL;
+    }
+    NetSocket sock = accept_guest(port, table);
+    NetSession* session = sock != NET_INVALID_SOCKET ? start_session(sock, true) : NULL;
+    if (session == NULL) {
+        net_shutdown();
+    }
+    return session;
+}
+
+/**
+ * @brief Connects to a host and sets the table up with the host's physics
+ * rate, solver, table variant and rack seed.
+ * @param host The host name or address.
+ * @param port The host's port.
+ * @param table The guest's table; reconfigured and racked.
+ * @return The session, or NULL on failure.
+ */
+NetSession* netplay_join(const char* host, int port, Table* table) {
+    if (!net_startup()) {
+        return NULL;
+    }
+    NetSocket sock = join_host(host, port, table);
+    NetSession* session = sock != NET_INVALID_SOCKET ? start_session(sock, false) : NULL;
+    if (session == NULL) {
+        net_shutdown();
+    }
+    return session;
+}
+
+/**
+ * @brief Returns true on the side that hosted the session.
+ */
+bool netplay_is_host(const NetSession* session) {
+    return session->host;
+}
+
+/**
+ * @brief Sends a shot. Call it just before the shot is struck locally.
+ * @param session The session.
+ * @param before The table the shot is played on (at rest).
+ * @param cue The cue ball's velocity.
+ */
+void netplay_send_shot(NetSession* session, const Table* before, Vec2D cue) {
+    NetMessage shot = {NET_SHOT, session->epoch, table_tick(before), cue,
+                       table_hash(before, TABLE_HASH_SEED)};
+    push(session, &session->outbox, &shot);
+}
+
+/**
+ * @brief Sends a cue ball placement. Call it just before the cue ball is
+ * placed locally.
+ * @param session The session.
+ * @param before The table before the placement (at rest).
+ * @param pos The cue ball's new position.
+ */
+void netplay_send_place(NetSession* session, const Table* before, Vec2D pos) {
+    NetMessage place = {NET_PLACE, session->epoch, table_tick(before), pos,
+                        table_hash(before, TABLE_HASH_SEED)};
+    push(session, &session->outbox, &place);
+}
+
+/**
+ * @brief Starts a new epoch and tells the peer to reset its table too.
+ * @param session The session.
+ */
+void netplay_send_reset(NetSession* session) {
+    session->epoch++;
+    session->checked = false;
+    NetMessage reset = {NET_RESET, session->epoch, 0, {0.0f, 0.0f}, 0};
+    push(session, &session->outbox, &reset);
+}
+
+/**
+ * @brief Records and sends a checkpoint of the local table if it is at a
+ * checkpoint: every NETPLAY_CHECK_INTERVAL fixed steps during a shot and
+ * once each time it comes to rest. Call it after every update().
+ * @param session The session.
+ * @param table The local table.
+ */
+void netplay_check(NetSession* session, const Table* table) {
+    uint64_t tick = table_tick(table);
+    if (table->state == STATE_SIMULATING &&
+        (table->solver == SOLVER_EVENTS || tick % NETPLAY_CHECK_INTERVAL != 0)) {
+        return;
+    }
+    if (session->checked && session->lastCheck.epoch == session->epoch && session->lastCheck.tick == tick) {
+        return; // Still at rest where the last checkpoint was taken
+    }
+
+    NetMessage check = {NET_CHECK, session->epoch, tick, {0.0f, 0.0f}, table_hash(table, TABLE_HASH_SEED)};
+    session->checked = true;
+    session->lastCheck = check;
+    record_check(session, &check, true);
+    push(session, &session->outbox, &check);
+}
+
+/**
+ * @brief Returns the peer's next input once it can be applied to the local
+ * table: a reset at once, a shot or placement when the table has come to
+ * rest at its tick. Checkpoints received on the way are compared. A shot
+ * that is not valid_cue() or a non-finite position puts the session out of
+ * sync instead of being applied.
+ * @param session The session.
+ * @param table The local table.
+ * @param input Receives a NET_SHOT, NET_PLACE or NET_RESET. A reset has
+ * already started the new epoch; the caller sets the table up.
+ * @return true if there is an input to apply now.
+ */
+bool netplay_next_input(NetSession* session, const Table* table, NetMessage* input) {
+    while (!session->desync) {
+        if (!session->hasPending && !pop(session, &session->inbox, &session->pending)) {
+            return false;
+        }
+        session->hasPending = true;
+        const NetMessage* message = &session->pending;
+
+        if (message->type == NET_CHECK) {
+            record_check(session, message, false);
+        } else if (message->type == NET_BYE) {
+            pthread_mutex_lock(&session->lock);
+            session->closed = true;
+            pthread_mutex_unlock(&session->lock);
+        } else if (message->type == NET_RESET) {
+            if (message->epoch > session->epoch) {
+                session->epoch = message->epoch;
+                session->checked = false;
+                session->hasPending = false;
+                *input = *message;
+                return true;
+            }
+            // Both sides reset at once; this one is already done
+        } else if ((message->type == NET_SHOT || message->type == NET_PLACE) && message->epoch >= session->epoch) {
+            if (message->epoch == session->epoch &&
+                (table->state == STATE_SIMULATING || table_tick(table) < message->tick)) {
+                return false; // Still playing the shot before it
+            }
+            session->hasPending = false;
+            if (message->epoch != session->epoch || table_tick(table) != message->tick ||
+                table_hash(table, TABLE_HASH_SEED) != message->hash) {
+                printf("Out of sync with the other player at step %llu!\n",
+                       (unsigned long long)message->tick);
+                session->desync = true;
+                return false;
+            }
+            // Only play what this side's own input could have been
+            bool valid = message->type == NET_SHOT ? valid_cue(message->cue)
+                                                   : isfinite(message->cue.x) && isfinite(message->cue.y);
+            if (!valid) {
+                printf("The other player sent an impossible %s at step %llu!\n",
+                       message->type == NET_SHOT ? "shot" : "cue ball position", (unsigned long long)message->tick);
+                session->desync = true;
+                return false;
+            }
+            *input = *message;
+            return true;
+        }
+        session->hasPending = false;
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the state of a session.
+ */
+NetplayStatus netplay_status(NetSession* session) {
+    if (session->desync) {
+        return NETPLAY_DESYNC;
+    }
+    pthread_mutex_lock(&session->lock);
+    bool closed = session->closed;
+    pthread_mutex_unlock(&session->lock);
+    return closed ? NETPLAY_CLOSED : NETPLAY_CONNECTED;
+}
+
+/**
+ * @brief Says goodbye to the peer, stops the network thread and frees the
+ * session. NULL is ignored.
+ */
+void netplay_close(NetSession* session) {
+    if (session == NULL) {
+        return;
+    }
+
+    NetMessage bye = {NET_BYE, session->epoch, 0, {0.0f, 0.0f}, 0};
+    push(session, &session->outbox, &bye);
+    pthread_mutex_lock(&session->lock);
+    session->shuttingDown = true;
+    pthread_mutex_unlock(&session->lock);
+    pthread_join(session->thread, NULL);
+
+    net_close(session->sock);
+    pthread_mutex_destroy(&session->lock);
+    free(session);
+    net_shutdown();
+}
+
+/**
+ * @brief Waits for a guest on a port and exchanges the handshake.
+ * @return The guest's socket, or NET_INVALID_SOCKET on failure.
+ */
+static NetSocket accept_guest(int port, const Table* table) {
+    NetSocket listener = net_listen(port);
+    if (listener == NET_INVALID_SOCKET) {
+        return NET_INVALID_SOCKET;
+    }
+    printf("Waiting for a player on port %d...\n", port);
+    NetSocket sock = net_accept(listener);
+    net_close(listener);
+    if (sock == NET_INVALID_SOCKET) {
+        return NET_INVALID_SOCKET;
+    }
+
+    unsigned char hello[HANDSHAKE_SIZE];
+    unsigned char answer[HANDSHAKE_SIZE];
+    encode_handshake(hello, table);
+    if (!net_send_all(sock, hello, sizeof(hello)) || !net_recv_all(sock, answer, sizeof(answer)) ||
+        memcmp(answer, NETPLAY_MAGIC, 4) != 0 || get_u32(answer + 4) != NETPLAY_VERSION) {
+        printf("The other player is not running a compatible version!\n");
+        net_close(sock);
+        return NET_INVALID_SOCKET;
+    }
+    if (get_u32(answer + 20) != build_flags()) {
+        printf("The other player's physics build differs (fixed-point vs float)!\n");
+        net_close(sock);
+        return NET_INVALID_SOCKET;
+    }
+    return sock;
+}
+
+/**
+ * @brief Connects to a host, exchanges the handshake and adopts the host's
+ * settings.
+ * @return The host's socket, or NET_INVALID_SOCKET on failure.
+ */
+static NetSocket join_host(const char* host, int port, Table* table) {
+    NetSocket sock = net_connect(host, port);
+    if (sock == NET_INVALID_SOCKET) {
+        return NET_INVALID_SOCKET;
+    }
+
+    unsigned char hello[HANDSHAKE_SIZE];
+    if (!net_recv_all(sock, hello, sizeof(hello)) || memcmp(hello, NETPLAY_MAGIC, 4) != 0 ||
+        get_u32(hello + 4) != NETPLAY_VERSION || get_u32(hello + 12) > SOLVER_EVENTS ||
+        get_u32(hello + 24) >= VARIANT_COUNT) {
+        printf("%s is not running a compatible version!\n", host);
+        net_close(sock);
+        return NET_INVALID_SOCKET;
+    }
+    set_physics_rate(table, (int)get_u32(hello + 8));
+    table->solver = (Solver)get_u32(hello + 12);
+    table->rackSeed = get_u32(hello + 16);
+    table->variant = (TableVariant)get_u32(hello + 24);
+    setup_table(table);
+
+    unsigned char answer[HANDSHAKE_SIZE];
+    encode_handshake(answer, table);
+    if (!net_send_all(sock, answer, sizeof(answer))) {
+        printf("Lost the connection to %s!\n", host);
+        net_close(sock);
+        return NET_INVALID_SOCKET;
+    }
+    if (get_u32(hello + 20) != build_flags()) {
+        printf("%s's physics build differs (fixed-point vs float)!\n", host);
+        net_close(sock);
+        return NET_INVALID_SOCKET;
+    }
+    return sock;
+}
+
+/**
+ * @brief Creates a session on a connected socket and starts its network
+ * thread.
+ * @return The session, or NULL on failure (the socket is closed).
+ */
+static NetSession* start_session(NetSocket sock, bool host) {
+    NetSession* session = calloc(1, sizeof(NetSession));
+    if (session == NULL) {
+        net_close(sock);
+        return NULL;
+    }
+    session->sock = sock;
+    session->host = host;
+    pthread_mutex_init(&session->lock, NULL);
+    if (pthread_create(&session->thread, NULL, net_main, session) != 0) {
+        pthread_mutex_destroy(&session->lock);
+        net_close(sock);
+        free(session);
+        return NULL;
+    }
+    return session;
+}
+
+/**
+ * @brief Network thread body: sends queued messages and receives messages
+ * into the inbox until shut down or disconnected. Waits at most
+ * NETPLAY_POLL_MS for incoming data between sends.
+ */
+static void* net_main(void* arg) {
+    NetSession* session = arg;
+    unsigned char received[MESSAGE_SIZE * 16];
+    int buffered = 0;
+    bool ok = true;
+
+    while (ok) {
+        // Encode under the lock, send outside it
+        unsigned char sending[MESSAGE_SIZE * NETPLAY_QUEUE_SIZE];
+        pthread_mutex_lock(&session->lock);
+        MessageQueue* outbox = &session->outbox;
+        int count = outbox->count;
+        for (int i = 0; i < count; ++i) {
+            encode_message(sending + i * MESSAGE_SIZE, &outbox->messages[(outbox->head + i) % NETPLAY_QUEUE_SIZE]);
+        }
+        outbox->head = (outbox->head + count) % NETPLAY_QUEUE_SIZE;
+        outbox->count = 0;
+        bool shuttingDown = session->shuttingDown;
+        pthread_mutex_unlock(&session->lock);
+
+        if (count > 0) {
+            ok = net_send_all(session->sock, sending, count * MESSAGE_SIZE);
+        }
+        if (shuttingDown) {
+            break;
+        }
+
+        int ready = ok ? net_wait(session->sock, NETPLAY_POLL_MS) : -1;
+        if (ready > 0) {
+            int got = net_recv(session->sock, received + buffered, (int)sizeof(received) - buffered);
+            ok = got > 0;
+            buffered += ok ? got : 0;
+            int used = 0;
+            for (; ok && buffered - used >= MESSAGE_SIZE; used += MESSAGE_SIZE) {
+                NetMessage message;
+                decode_message(received + used, &message);
+                ok = push(session, &session->inbox, &message);
+            }
+            memmove(received, received + used, buffered - used);
+            buffered -= used;
+        } else if (ready < 0) {
+            ok = false;
+        }
+    }
+
+    pthread_mutex_lock(&session->lock);
+    session->closed = session->closed || !ok;
+    pthread_mutex_unlock(&session->lock);
+    return NULL;
+}
+
+/**
+ * @brief Appends a message to one of the session's queues.
+ * @return false if the queue is full.
+ */
+static bool push(NetSession* session, MessageQueue* queue, const NetMessage* message) {
+    pthread_mutex_lock(&session->lock);
+    bool room = queue->count < NETPLAY_QUEUE_SIZE;
+    if (room) {
+        queue->messages[(queue->head + queue->count) % NETPLAY_QUEUE_SIZE] = *message;
+        queue->count++;
+    } else {
+        session->closed = true; // The game can no longer stay in step
+    }
+    pthread_mutex_unlock(&session->lock);
+    return room;
+}
+
+/**
+ * @brief Takes the oldest message off one of the session's queues.
+ * @return false if the queue is empty.
+ */
+static bool pop(NetSession* session, MessageQueue* queue, NetMessage* message) {
+    pthread_mutex_lock(&session->lock);
+    bool found = queue->count > 0;
+    if (found) {
+        *message = queue->messages[queue->head];
+        queue->head = (queue->head + 1) % NETPLAY_QUEUE_SIZE;
+        queue->count--;
+    }
+    pthread_mutex_unlock(&session->lock);
+    return found;
+}
+
+/**
+ * @brief Remembers a checkpoint and compares it with the other side's
+ * checkpoint at the same epoch and tick, if that is still remembered.
+ * @param session The session.
+ * @param check The checkpoint.
+ * @param mine true for a local checkpoint, false for the peer's.
+ */
+static void record_check(NetSession* session, const NetMessage* check, bool mine) {
+    NetMessage* own = mine ? session->local : session->remote;
+    int* next = mine ? &session->localNext : &session->remoteNext;
+    const NetMessage* other = mine ? session->remote : session->local;
+    own[*next] = *check;
+    *next = (*next + 1) % NETPLAY_HISTORY;
+
+    for (int i = 0; i < NETPLAY_HISTORY; ++i) {
+        if (other[i].type == NET_CHECK && other[i].epoch == check->epoch && other[i].tick == check->tick &&
+            other[i].hash != check->hash) {
+            printf("Out of sync with the other player at step %llu!\n", (unsigned long long)check->tick);
+            session->desync = true;
+        }
+    }
+}
+
+/**
+ * @brief Returns how far a table has advanced since it was set up: fixed
+ * steps, or events with SOLVER_EVENTS.
+ */
+static uint64_t table_tick(const Table* table) {
+    return table->solver == SOLVER_EVENTS ? table->eventCount : table->stepCount;
+}
+
+/**
+ * @brief Returns the handshake flags of this build.
+ */
+static uint32_t build_flags() {
+#ifdef POOL_FIXED_POINT
+    return FLAG_FIXED_POINT;
+#else
+    return 0;
+#endif
+}
+
+static void encode_handshake(unsigned char* p, const Table* table) {
+    memcpy(p, NETPLAY_MAGIC, 4);
+    put_u32(p + 4, NETPLAY_VERSION);
+    put_u32(p + 8, (uint32_t)table->physicsHz);
+    put_u32(p + 12, (uint32_t)table->solver);
+    put_u32(p + 16, table->rackSeed);
+    put_u32(p + 20, build_flags());
+    put_u32(p + 24, (uint32_t)table->variant);
+}
+
+static void encode_message(unsigned char* p, const NetMessage* message) {
+    memset(p, 0, MESSAGE_SIZE);
+    p[0] = message->type;
+    put_u32(p + 4, message->epoch);
+    put_u64(p + 8, message->tick);
+    put_u32(p + 16, float_bits(message->cue.x));
+    put_u32(p + 20, float_bits(message->cue.y));
+    put_u64(p + 24, message->hash);
+}
+
+static void decode_message(const unsigned char* p, NetMessage* message) {
+    message->type = p[0];
+    message->epoch = get_u32(p + 4);
+    message->tick = get_u64(p + 8);
+    message->cue = (Vec2D){bits_float(get_u32(p + 16)), bits_float(get_u32(p + 20))};
+    message->hash = get_u64(p + 24);
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void put_u64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t get_u64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint32_t float_bits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
@@ -0,0 +1,68 @@
+// -----------------------------------------------------------------------------
+// Lockstep online play for the 8-Ball Pool Game
+//
+// Two players each run the whole game locally. Only inputs cross the
+// network: a shot's cue velocity and the step it was taken at, cue ball
+// placements with ball in hand and table resets. The physics is
+// deterministic, so both tables play every shot identically. Both sides
+// also exchange table hashes at checkpoints while a shot runs and whenever
+// the table comes to rest, so a desync is noticed at once. Messages go
+// through a network thread, so the game loop never waits on the network.
+// -----------------------------------------------------------------------------
+
+#ifndef NETPLAY_H
+#define NETPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "physics.h"
+
+#define NETPLAY_MAGIC "PNET"
+#define NETPLAY_VERSION 3
+
+#define NETPLAY_CHECK_INTERVAL 240 // Fixed steps between checkpoints during a shot
+#define NETPLAY_HISTORY 64         // Checkpoints remembered per side
+#define NETPLAY_QUEUE_SIZE 256     // Messages queued each way
+#define NETPLAY_POLL_MS 10         // Longest a queued message waits to be sent
+
+// Kinds of message
+typedef enum {
+    NET_SHOT = 1,  // The sender struck the cue ball
+    NET_RESET = 2, // The sender set the table up again
+    NET_CHECK = 3, // The sender's table hash at a checkpoint
+    NET_BYE = 4,   // The sender is quitting
+    NET_PLACE = 5  // The sender placed the cue ball with ball in hand
+} NetMessageType;
+
+// One message, 32 bytes on the wire
+typedef struct {
+    uint8_t type;    // NetMessageType
+    uint32_t epoch;  // Table resets so far in the session
+    uint64_t tick;   // Fixed steps (events with SOLVER_EVENTS) of the table at the message
+    Vec2D cue;       // Cue velocity of a NET_SHOT, position of a NET_PLACE
+    uint64_t hash;   // table_hash() of the table at the message
+} NetMessage;
+
+// State of a session
+typedef enum {
+    NETPLAY_CONNECTED,
+    NETPLAY_CLOSED, // The peer quit or the connection failed
+    NETPLAY_DESYNC  // The two tables no longer match
+} NetplayStatus;
+
+// Opaque session with its network thread
+typedef struct NetSession NetSession;
+
+// --- Function Prototypes ---
+NetSession* netplay_host(int port, const Table* table);
+NetSession* netplay_join(const char* host, int port, Table* table);
+bool netplay_is_host(const NetSession* session);
+void netplay_send_shot(NetSession* session, const Table* before, Vec2D cue);
+void netplay_send_place(NetSession* session, const Table* before, Vec2D pos);
+void netplay_send_reset(NetSession* session);
+void netplay_check(NetSession* session, const Table* table);
+bool netplay_next_input(NetSession* session, const Table* table, NetMessage* input);
+NetplayStatus netplay_status(NetSession* session);
+void netplay_close(NetSession* session);
+
+#endif
@@ -0,0 +1,1141 @@
+// -----------------------------------------------------------------------------
+// Table state and physics simulation for the 8-Ball Pool Game
+// -----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include "physics.h"
+
+// --- SIMD Selection ---
+// The integration kernels use the widest instruction set the compiler is
+// targeting (e.g. `make SIMD=avx2`), falling back to plain C. All variants
+// perform the same IEEE operations in the same order, so they give
+// identical results.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_WIDTH 8
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_WIDTH 4
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SIMD_WIDTH 4
+#else
+#define SIMD_WIDTH 1
+#endif
+
+// Forces a kernel into its caller, so the caller's constant arguments fold
+// into it (see the variant kernels below)
+#define KERNEL static inline __attribute__((always_inline))
+
+// Snooker spots on the long axis, scaled from a full-size table
+#define SNOOKER_BAULK_X 185.0f // The baulk line; brown sits on it
+#define SNOOKER_D_RADIUS 74.0f // Yellow and green sit where the D meets it
+#define SNOOKER_CUE_X 160.0f   // Cue ball in the D
+#define SNOOKER_BLUE_X (TABLE_WIDTH / 2.0f)
+#define SNOOKER_PINK_X 675.0f
+#define SNOOKER_BLACK_X 818.0f
+
+// A variant's entry in TABLE_VARIANTS
+typedef struct {
+    const char* name;
+    int balls;
+    float ballRadius;
+    float pocketRadius;
+} VariantLayout;
+
+#define VARIANT_LAYOUT(id, name, balls, ballRadius, pocketRadius) [id] = {name, balls, ballRadius, pocketRadius},
+static const VariantLayout VARIANT_LAYOUTS[VARIANT_COUNT] = {TABLE_VARIANTS(VARIANT_LAYOUT)};
+#undef VARIANT_LAYOUT
+
+// --- Function Prototypes ---
+#ifndef POOL_FIXED_POINT
+KERNEL void step_balls(Table* table, uint64_t start, int balls, int diameter);
+KERNEL BallMask integrate_balls(Table* table, int balls);
+KERNEL BallMask clamp_to_cushions(Table* table, int balls);
+KERNEL BallMask collide_balls(Table* table, int balls, int diameter);
+KERNEL bool resolve_ball_pair(Table* table, int i, int j, int diameter);
+KERNEL bool fast_forward_to_rest(Table* table, int balls, int diameter);
+static float segment_point_dist_sq(Vec2D a, Vec2D b, Vec2D p);
+static float segment_dist_sq(Vec2D a, Vec2D b, Vec2D c, Vec2D d);
+#endif
+static uint64_t end_stage(Table* table, PhysicsStage stage, uint64_t start);
+static void rack_pool(Table* table);
+static void rack_nine_ball(Table* table);
+static void rack_snooker(Table* table);
+static void rack_practice(Table* table);
+static void rack_rows(Table* table, const int* order, const int* rowSizes, int rows, float x);
+static void shuffle_rack(int rackOrder[15], uint32_t seed);
+static void shuffle_ids(int* ids, int count, uint32_t seed);
+static void build_geometry(TableGeometry* geo, TableVariant variant);
+static uint64_t hash_bytes(uint64_t hash, const void* data, int size);
+
+#ifndef POOL_FIXED_POINT
+// --- Variant Kernels ---
+// One fixed-step function per variant, with the variant's ball count and
+// diameter as constants: step_balls() and the kernels it calls are inlined
+// into each, so every loop over the balls or their SIMD lanes has a
+// constant trip count and unrolls as if the table had only that variant.
+#define DEFINE_STEP_KERNEL(id, name, balls, ballRadius, pocketRadius) \
+    static void step_##id(Table* table, uint64_t start) { step_balls(table, start, balls, 2 * (ballRadius)); }
+TABLE_VARIANTS(DEFINE_STEP_KERNEL)
+#undef DEFINE_STEP_KERNEL
+
+#define STEP_KERNEL_ENTRY(id, name, balls, ballRadius, pocketRadius) [id] = step_##id,
+static void (*const STEP_KERNELS[VARIANT_COUNT])(Table* table, uint64_t start) = {TABLE_VARIANTS(STEP_KERNEL_ENTRY)};
+#undef STEP_KERNEL_ENTRY
+#endif
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Returns a variant's name, e.g. "8ball".
+ */
+const char* variant_name(TableVariant variant) {
+    return variant >= 0 && variant < VARIANT_COUNT ? VARIANT_LAYOUTS[variant].name : "unknown";
+}
+
+/**
+ * @brief Returns the number of balls a variant racks, the cue ball
+ * included, or 0 for an unknown variant.
+ */
+int variant_balls(TableVariant variant) {
+    return variant >= 0 && variant < VARIANT_COUNT ? VARIANT_LAYOUTS[variant].balls : 0;
+}
+
+/**
+ * @brief Looks a variant up by name.
+ * @param name The name, as variant_name() returns it.
+ * @param variant Receives the variant.
+ * @return false if no variant has the name.
+ */
+bool variant_from_name(const char* name, TableVariant* variant) {
+    for (int v = 0; v < VARIANT_COUNT; ++v) {
+        if (strcmp(name, VARIANT_LAYOUTS[v].name) == 0) {
+            *variant = (TableVariant)v;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Prepares a new table: sets its physics rate, selects the fixed-step
+ * solver without fast-forward or profiling and racks the standard 8-ball
+ * table.
+ * @param table The table to initialize.
+ * @param physicsHz Steps per second (see set_physics_rate()).
+ */
+void init_table(Table* table, int physicsHz) {
+    set_physics_rate(table, physicsHz);
+    table->solver = SOLVER_FIXED_STEP;
+    table->variant = VARIANT_EIGHT_BALL;
+    table->rackSeed = 0;
+    table->fastForward = false;
+    table->profileClock = NULL;
+    setup_table(table);
+}
+
+/**
+ * @brief Racks the balls of table->variant, in the order given by
+ * table->rackSeed. Also defines the variant's geometry and waits for the
+ * first shot. The physics rate is left unchanged.
+ * @param table The table to rack.
+ */
+void setup_table(Table* table) {
+    if (table->variant < 0 || table->variant >= VARIANT_COUNT) {
+        table->variant = VARIANT_EIGHT_BALL;
+    }
+    table->ballCount = VARIANT_LAYOUTS[table->variant].balls;
+
+    // Initialize all balls (and clear the unused and padding lanes)
+    for (int i = 0; i < BALL_LANES; ++i) {
+        table->px[i] = 0.0f;
+        table->py[i] = 0.0f;
+        table->vx[i] = 0.0f;
+        table->vy[i] = 0.0f;
+    }
+    table->active = all_balls(table);
+    table->awake = 0;
+    table->collisions = (CollisionStats){0, 0, 0, 0};
+    table->stepCount = 0;
+    table->fastForwardSteps = 0;
+    table->eventCount = 0;
+    clear_shot_events(&table->shot);
+    for (int i = 0; i < PHYS_STAGE_COUNT; ++i) {
+        table->stageTicks[i] = 0;
+    }
+
+    build_geometry(&table->geometry, table->variant);
+
+    // --- Position the balls ---
+    switch (table->variant) {
+        case VARIANT_NINE_BALL:
+            rack_nine_ball(table);
+            break;
+        case VARIANT_SNOOKER:
+            rack_snooker(table);
+            break;
+        case VARIANT_PRACTICE:
+            rack_practice(table);
+            break;
+        default:
+            rack_pool(table);
+            break;
+    }
+    table->px[0] = table->geometry.headSpotX;
+    table->py[0] = TABLE_HEIGHT / 2.0f;
+
+    // Seed the broad-phase order; collide_balls() keeps it sorted
+    for (int i = 0; i < MAX_BALLS; ++i) {
+        table->sweepOrder[i] = (uint8_t)i;
+    }
+
+#ifdef POOL_FIXED_POINT
+    fixed_load(table);
+#endif
+
+    table->state = STATE_AIMING;
+}
+
+/**
+ * @brief Derives the cushion lines, pockets, pocket reach and spots of a
+ * variant's table.
+ * @param geo Receives the geometry.
+ * @param variant The variant.
+ */
+static void build_geometry(TableGeometry* geo, TableVariant variant) {
+    const VariantLayout* layout = &VARIANT_LAYOUTS[variant];
+    geo->ballRadius = layout->ballRadius;
+    geo->pocketRadius = layout->pocketRadius;
+    geo->cushionX1 = geo->ballRadius;
+    geo->cushionY1 = geo->ballRadius;
+    geo->cushionX2 = TABLE_WIDTH - geo->ballRadius;
+    geo->cushionY2 = TABLE_HEIGHT - geo->ballRadius;
+    geo->headSpotX = variant == VARIANT_SNOOKER ? SNOOKER_CUE_X : CUE_START_X;
+    geo->footSpotX = variant == VARIANT_SNOOKER ? SNOOKER_BLACK_X : RACK_APEX_X;
+
+    // The felt's corners and long-side centers
+    geo->pockets[0] = (Pocket){{0.0f, 0.0f}};
+    geo->pockets[1] = (Pocket){{TABLE_WIDTH / 2.0f, 0.0f}};
+    geo->pockets[2] = (Pocket){{TABLE_WIDTH, 0.0f}};
+    geo->pockets[3] = (Pocket){{0.0f, TABLE_HEIGHT}};
+    geo->pockets[4] = (Pocket){{TABLE_WIDTH / 2.0f, TABLE_HEIGHT}};
+    geo->pockets[5] = (Pocket){{TABLE_WIDTH, TABLE_HEIGHT}};
+
+    // Every pocket sits on a long rail, so a band along the table's middle
+    // is out of reach of all of them
+    geo->reachY1 = 0.0f;
+    geo->reachY2 = TABLE_HEIGHT;
+    for (int p = 0; p < NUM_POCKETS; ++p) {
+        geo->pocketRadiusSq[p] = geo->pocketRadius * geo->pocketRadius;
+        Vec2D pos = geo->pockets[p].pos;
+        if (pos.y < TABLE_HEIGHT / 2.0f) {
+            geo->reachY1 = fmaxf(geo->reachY1, pos.y + geo->pocketRadius);
+        } else {
+            geo->reachY2 = fminf(geo->reachY2, pos.y - geo->pocketRadius);
+        }
+    }
+}
+
+/**
+ * @brief Racks 8-ball: a triangle of the 15 object balls with its apex on
+ * the foot spot.
+ */
+static void rack_pool(Table* table) {
+    static const int rowSizes[] = {1, 2, 3, 4, 5};
+    int rackOrder[] = {1, 9, 15, 2, 8, 14, 3, 10, 7, 13, 4, 11, 6, 12, 5};
+    if (table->rackSeed != 0) {
+        shuffle_rack(rackOrder, table->rackSeed);
+    }
+    rack_rows(table, rackOrder, rowSizes, 5, RACK_APEX_X);
+}
+
+/**
+ * @brief Racks 9-ball: a diamond of balls 1-9 with the 1 at its apex on the
+ * foot spot and the 9 in its middle.
+ */
+static void rack_nine_ball(Table* table) {
+    static const int rowSizes[] = {1, 2, 3, 2, 1};
+    int others[] = {2, 3, 4, 5, 6, 7, 8};
+    if (table->rackSeed != 0) {
+        shuffle_ids(others, 7, table->rackSeed);
+    }
+    const int order[] = {1, others[0], others[1], others[2], 9, others[3], others[4], others[5], others[6]};
+    rack_rows(table, order, rowSizes, 5, RACK_APEX_X);
+}
+
+/**
+ * @brief Racks snooker: a triangle of the 15 reds (balls 1-15) behind the
+ * pink, and the colours on their spots: yellow (16), green (17) and brown
+ * (18) on the baulk line, then blue (19), pink (20) and black (21).
+ */
+static void rack_snooker(Table* table) {
+    static const int rowSizes[] = {1, 2, 3, 4, 5};
+    int reds[15];
+    for (int i = 0; i < 15; ++i) {
+        reds[i] = 1 + i;
+    }
+    float diameter = 2.0f * table->geometry.ballRadius;
+    rack_rows(table, reds, rowSizes, 5, SNOOKER_PINK_X + diameter + 1.0f);
+
+    const float centerY = TABLE_HEIGHT / 2.0f;
+    const Vec2D spots[6] = {
+        {SNOOKER_BAULK_X, centerY + SNOOKER_D_RADIUS},
+        {SNOOKER_BAULK_X, centerY - SNOOKER_D_RADIUS},
+        {SNOOKER_BAULK_X, centerY},
+        {SNOOKER_BLUE_X, centerY},
+        {SNOOKER_PINK_X, centerY},
+        {SNOOKER_BLACK_X, centerY}
+    };
+    for (int i = 0; i < 6; ++i) {
+        table->px[16 + i] = spots[i].x;
+        table->py[16 + i] = spots[i].y;
+    }
+}
+
+/**
+ * @brief Racks the practice table: a triangle of seven rows holding every
+ * object ball, apex on the foot spot.
+ */
+static void rack_practice(Table* table) {
+    static const int rowSizes[] = {1, 2, 3, 4, 5, 6, 7};
+    int order[MAX_BALLS];
+    int count = table->ballCount - 1;
+    for (int i = 0; i < count; ++i) {
+        order[i] = 1 + i;
+    }
+    if (table->rackSeed != 0) {
+        shuffle_ids(order, count, table->rackSeed);
+    }
+    rack_rows(table, order, rowSizes, 7, RACK_APEX_X);
+}
+
+/**
+ * @brief Puts balls in rows across the table, the first row at x and each
+ * further row closer together than a diameter so neighbours touch. Every
+ * row is centered on the long axis.
+ * @param table The table.
+ * @param order Ball ids, row after row.
+ * @param rowSizes Balls in each row.
+ * @param rows Number of rows.
+ * @param x Position of the first row.
+ */
+static void rack_rows(Table* table, const int* order, const int* rowSizes, int rows, float x) {
+    const float startY = TABLE_HEIGHT / 2.0f;
+    const float radius = table->geometry.ballRadius;
+    const float diameter = 2.0f * radius;
+    const float ball_offset = diameter * 0.88f; // Distance between rows
+
+    int ballIndex = 0;
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < rowSizes[row]; ++col) {
+            table->px[order[ballIndex]] = x + row * ball_offset;
+            table->py[order[ballIndex]] = startY + (col * diameter) - ((rowSizes[row] - 1) * radius);
+            ballIndex++;
+        }
+    }
+}
+
+/**
+ * @brief Shuffles a rack with a seeded xorshift generator, so the same seed
+ * always gives the same rack. The 8-ball stays in the middle of the third
+ * row and the back corners get one solid and one stripe.
+ * @param rackOrder The 15 ball ids in rack order (apex first).
+ * @param seed The rack seed (non-zero).
+ */
+static void shuffle_rack(int rackOrder[15], uint32_t seed) {
+    const int eightSlot = 4;
+    const int cornerA = 10;
+    const int cornerB = 14;
+
+    shuffle_ids(rackOrder, 15, seed);
+
+    // Put the 8-ball back in the middle
+    for (int i = 0; i < 15; ++i) {
+        if (rackOrder[i] == 8) {
+            rackOrder[i] = rackOrder[eightSlot];
+            rackOrder[eightSlot] = 8;
+            break;
+        }
+    }
+
+    // Swap a ball of the other group into corner B if both corners match
+    bool solidA = rackOrder[cornerA] < 8;
+    if ((rackOrder[cornerB] < 8) == solidA) {
+        for (int i = 0; i < 15; ++i) {
+            if (i != eightSlot && i != cornerA && (rackOrder[i] < 8) != solidA) {
+                int tmp = rackOrder[i];
+                rackOrder[i] = rackOrder[cornerB];
+                rackOrder[cornerB] = tmp;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Shuffles ball ids with a seeded xorshift generator, so the same
+ * seed always gives the same order.
+ * @param ids The ids to shuffle.
+ * @param count Number of ids.
+ * @param seed The seed (non-zero).
+ */
+static void shuffle_ids(int* ids, int count, uint32_t seed) {
+    uint32_t state = seed;
+    for (int i = count - 1; i > 0; --i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        int j = (int)(state % (uint32_t)(i + 1));
+        int tmp = ids[i];
+        ids[i] = ids[j];
+        ids[j] = tmp;
+    }
+}
+
+/**
+ * @brief Sets the fixed physics step rate and derives the per-step constants.
+ * @param table The table to configure.
+ * @param hz Steps per second, clamped to [MIN_PHYSICS_HZ, MAX_PHYSICS_HZ].
+ */
+void set_physics_rate(Table* table, int hz) {
+    if (hz < MIN_PHYSICS_HZ) hz = MIN_PHYSICS_HZ;
+    if (hz > MAX_PHYSICS_HZ) hz = MAX_PHYSICS_HZ;
+    table->physicsHz = hz;
+    table->stepScale = (float)BASE_PHYSICS_HZ / hz;
+    table->stepFriction = powf(FRICTION, table->stepScale);
+#ifdef POOL_FIXED_POINT
+    fixed_set_rate(table);
+#endif
+}
+
+/**
+ * @brief Returns whether a cue velocity is a shot that can be played: finite
+ * and no faster than MAX_CUE_SPEED. Faster shots would overflow the
+ * fixed-point velocities (see fixed.c).
+ */
+bool valid_cue(Vec2D vel) {
+    return isfinite(vel.x) && isfinite(vel.y) && vel.x * vel.x + vel.y * vel.y <= MAX_CUE_SPEED * MAX_CUE_SPEED;
+}
+
+/**
+ * @brief Shoots the cue ball if the table is waiting for a shot.
+ * @param table The table to play on.
+ * @param vel The cue ball's new velocity (table units per base frame).
+ * @return true if the shot was taken, false if it was not allowed or the
+ * velocity is not valid_cue().
+ */
+bool strike_cue_ball(Table* table, Vec2D vel) {
+    if (table->state != STATE_AIMING || !ball_active(table, 0) || !valid_cue(vel)) {
+        return false;
+    }
+    table->vx[0] = vel.x;
+    table->vy[0] = vel.y;
+    table->state = STATE_SIMULATING;
+    clear_shot_events(&table->shot);
+    // The first step looks at every ball, so tables edited between shots
+    // need no sleep bookkeeping
+    table->awake = table->active;
+#ifdef POOL_FIXED_POINT
+    fixed_load(table);
+#endif
+    return true;
+}
+
+/**
+ * @brief Advances the physics simulation by one fixed step of 1/physicsHz.
+ * Touches nothing but the given table, so independent tables can be
+ * simulated concurrently. With SOLVER_EVENTS the step is covered exactly by
+ * advance_events() instead.
+ *
+ * Balls outside table->awake are asleep: they have no velocity, sit inside
+ * the cushions and were last tested against the pockets where they are, so
+ * the step skips them (a pair of sleeping balls is never tested either). A
+ * ball falls asleep once it stops and nothing moved it during the step, and
+ * wakes when a collision moves it. POOL_FIXED_POINT builds run the same
+ * stages on integers with fixed_update() instead.
+ * @param table The table to step.
+ */
+void update(Table* table) {
+    if (table->state != STATE_SIMULATING) {
+        return;
+    }
+
+    uint64_t start = table->profileClock != NULL ? table->profileClock() : 0;
+
+    if (table->solver == SOLVER_EVENTS) {
+        advance_events(table, table->stepScale);
+        end_stage(table, PHYS_STAGE_EVENTS, start);
+        return;
+    }
+
+#ifdef POOL_FIXED_POINT
+    fixed_update(table, start);
+#else
+    STEP_KERNELS[table->variant](table, start);
+#endif
+}
+
+/**
+ * @brief Adds the ticks since start to a stage's total, if the table is
+ * being profiled.
+ * @param table The table being stepped.
+ * @param stage The stage that just finished.
+ * @param start The tick count when the stage began.
+ * @return The current tick count, i.e. the start of the next stage.
+ */
+static uint64_t end_stage(Table* table, PhysicsStage stage, uint64_t start) {
+    if (table->profileClock == NULL) {
+        return 0;
+    }
+    uint64_t now = table->profileClock();
+    table->stageTicks[stage] += now - start;
+    return now;
+}
+
+/**
+ * @brief Steps a table until it is no longer simulating (all balls at
+ * rest), as fast as possible. Gives up after
+ * MAX_SHOT_SECONDS of simulated time, leaving the state at STATE_SIMULATING.
+ * With SOLVER_EVENTS the whole shot is resolved event to event in one go.
+ * @param table The table to step.
+ * @return The number of physics steps (or events) simulated, counting steps
+ * skipped by fast-forward.
+ */
+int simulate_to_rest(Table* table) {
+    if (table->solver == SOLVER_EVENTS) {
+        uint64_t before = table->eventCount;
+        advance_events(table, MAX_SHOT_SECONDS * (double)BASE_PHYSICS_HZ);
+        return (int)(table->eventCount - before);
+    }
+
+    const int maxSteps = MAX_SHOT_SECONDS * table->physicsHz;
+    const uint64_t before = table->stepCount;
+    int steps = 0;
+    while (table->state == STATE_SIMULATING && steps < maxSteps) {
+        update(table);
+        steps++;
+    }
+    return (int)(table->stepCount - before);
+}
+
+/**
+ * @brief Folds a table's outcome (ball positions and velocities, pocketed
+ * balls, game state and step count) into an FNV-1a hash. Equal hashes mean,
+ * in practice, bit-identical simulations.
+ * @param table The table to hash.
+ * @param hash The hash so far; TABLE_HASH_SEED to start a new one.
+ * @return The updated hash.
+ */
+uint64_t table_hash(const Table* table, uint64_t hash) {
+    hash = hash_bytes(hash, table->px, table->ballCount * sizeof(float));
+    hash = hash_bytes(hash, table->py, table->ballCount * sizeof(float));
+    hash = hash_bytes(hash, table->vx, table->ballCount * sizeof(float));
+    hash = hash_bytes(hash, table->vy, table->ballCount * sizeof(float));
+    hash = hash_bytes(hash, &table->active, sizeof(table->active));
+    hash = hash_bytes(hash, &table->state, sizeof(table->state));
+    hash = hash_bytes(hash, &table->stepCount, sizeof(table->stepCount));
+    return hash;
+}
+
+/**
+ * @brief Empties a shot's event record.
+ * @param shot The record to clear.
+ */
+void clear_shot_events(ShotEvents* shot) {
+    shot->count = 0;
+    shot->firstContact = -1;
+    shot->firstPocketed = -1;
+    shot->cushioned = 0;
+    shot->pocketed = 0;
+}
+
+/**
+ * @brief Appends an event to the shot in progress and updates the shot's
+ * summary. Called by each physics backend as events happen.
+ * @param table The table the event happened on.
+ * @param type What happened.
+ * @param ball The ball it happened to.
+ * @param other The ball touched (SHOT_EVENT_CONTACT) or the pocket
+ * (SHOT_EVENT_POCKET).
+ */
+void record_shot_event(Table* table, ShotEventType type, int ball, int other) {
+    ShotEvents* shot = &table->shot;
+    if (shot->count < MAX_SHOT_EVENTS) {
+        shot->list[shot->count] = (ShotEvent){(uint8_t)type, (uint8_t)ball, (uint8_t)other};
+    }
+    shot->count++;
+
+    switch (type) {
+        case SHOT_EVENT_CONTACT:
+            shot->firstContact = (int8_t)other;
+            break;
+        case SHOT_EVENT_CUSHION:
+            if (shot->firstContact >= 0) {
+                shot->cushioned |= (BallMask)1 << ball;
+            }
+            break;
+        case SHOT_EVENT_POCKET:
+            shot->pocketed |= (BallMask)1 << ball;
+            if (ball != 0 && shot->firstPocketed < 0) {
+                shot->firstPocketed = (int8_t)ball;
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Folds raw bytes into an FNV-1a hash.
+ */
+static uint64_t hash_bytes(uint64_t hash, const void* data, int size) {
+    const unsigned char* bytes = data;
+    for (int i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#ifndef POOL_FIXED_POINT
+// The float kernels below are replaced by the integer ones in fixed.c in
+// POOL_FIXED_POINT builds.
+
+// --- Fixed Step ---
+
+/**
+ * @brief Advances a simulating table by one fixed step with the float
+ * kernels. Inlined into one step function per variant (see
+ * STEP_KERNELS), where balls and diameter are that variant's constants.
+ * @param table The table to step.
+ * @param start The tick count when the step began (0 if not profiled).
+ * @param balls The variant's ball count.
+ * @param diameter The variant's ball diameter.
+ */
+KERNEL void step_balls(Table* table, uint64_t start, int balls, int diameter) {
+    // 1-3. Apply friction, update positions and stop slow balls
+    BallMask moving = integrate_balls(table, balls);
+    start = end_stage(table, PHYS_STAGE_INTEGRATE, start);
+
+    // 4. Handle collision with cushions
+    BallMask clamped = clamp_to_cushions(table, balls);
+    for (BallMask left = clamped; left != 0; left &= left - 1) {
+        record_shot_event(table, SHOT_EVENT_CUSHION, lowest_ball(left), 0);
+    }
+    start = end_stage(table, PHYS_STAGE_CUSHIONS, start);
+
+    // 5. Handle ball-ball collisions
+    BallMask touched = collide_balls(table, balls, diameter);
+    start = end_stage(table, PHYS_STAGE_BALLS, start);
+
+    // 6. Handle pocketing (only balls near a long rail can reach a pocket)
+    const TableGeometry* geo = &table->geometry;
+    for (BallMask left = (table->awake | touched) & table->active; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        if (table->py[i] > geo->reachY1 && table->py[i] < geo->reachY2) continue;
+
+        for (int p = 0; p < NUM_POCKETS; ++p) {
+            float dx = geo->pockets[p].pos.x - table->px[i];
+            float dy = geo->pockets[p].pos.y - table->py[i];
+            if (dx * dx + dy * dy < geo->pocketRadiusSq[p]) {
+                // Pocketed balls keep their last position but stop moving
+                table->active &= ~((BallMask)1 << i);
+                table->vx[i] = 0.0f;
+                table->vy[i] = 0.0f;
+                record_shot_event(table, SHOT_EVENT_POCKET, i, p);
+                break;
+            }
+        }
+    }
+
+    table->stepCount++;
+
+    // Balls moved by a collision stay awake for at least one more step, so
+    // the next one clamps them to the cushions, and so do balls reflected
+    // off one, so a zero velocity reflected to -0 is integrated back to +0
+    table->awake = (moving | touched | clamped) & table->active;
+
+    // If no balls are moving, switch back to aiming state
+    if (moving == 0) {
+        table->state = STATE_AIMING;
+    } else if (table->fastForward && table->state == STATE_SIMULATING &&
+               table->stepCount % FAST_FORWARD_INTERVAL == 0) {
+        fast_forward_to_rest(table, balls, diameter);
+    }
+    end_stage(table, PHYS_STAGE_POCKETS, start);
+}
+
+
+// --- Ball-Ball Collisions ---
+
+/**
+ * @brief Finds and resolves overlapping balls using sweep and prune on x.
+ *
+ * table->sweepOrder is re-sorted by x every step; balls move little per
+ * step, so the insertion sort is close to linear. Scanning forward from each
+ * ball stops at the first ball a full diameter further right, and pairs
+ * where both balls are at rest are skipped, since neither can have moved
+ * into the other. A resting ball with no moving ball after it in the order
+ * has nothing to test, so its scan is skipped outright. Tested and culled
+ * pair counts go to table->collisions.
+ * @param table The table to resolve.
+ * @param balls The variant's ball count.
+ * @param diameter The variant's ball diameter.
+ * @return The balls that were moved apart from another ball.
+ */
+KERNEL BallMask collide_balls(Table* table, int balls, int diameter) {
+    uint8_t* order = table->sweepOrder;
+    for (int k = 1; k < balls; ++k) {
+        uint8_t id = order[k];
+        float x = table->px[id];
+        int m = k - 1;
+        while (m >= 0 && table->px[order[m]] > x) {
+            order[m + 1] = order[m];
+            m--;
+        }
+        order[m + 1] = id;
+    }
+
+    // Sweep position of the last moving ball; collisions only ever set
+    // balls after the current one moving
+    int lastMoving = balls - 1;
+    while (lastMoving >= 0 && ball_at_rest(table, order[lastMoving])) {
+        lastMoving--;
+    }
+
+    int tested = 0;
+    BallMask touched = 0;
+    for (int k = 0; k < balls; ++k) {
+        int i = order[k];
+        if (!ball_active(table, i)) continue;
+        if (k >= lastMoving && ball_at_rest(table, i)) continue;
+
+        float maxX = table->px[i] + diameter;
+        for (int m = k + 1; m < balls; ++m) {
+            int j = order[m];
+            if (table->px[j] >= maxX) break;
+            if (!ball_active(table, j)) continue;
+            if (ball_at_rest(table, i) && ball_at_rest(table, j)) continue;
+
+            tested++;
+            if (resolve_ball_pair(table, i, j, diameter)) {
+                touched |= ((BallMask)1 << i) | ((BallMask)1 << j);
+                if (m > lastMoving && !ball_at_rest(table, j)) lastMoving = m;
+                if ((i == 0 || j == 0) && table->shot.firstContact < 0) {
+                    record_shot_event(table, SHOT_EVENT_CONTACT, 0, i + j);
+                }
+            }
+        }
+    }
+
+    int activeCount = ball_count(table->active);
+    int culled = activeCount * (activeCount - 1) / 2 - tested;
+    table->collisions.pairsTested = tested;
+    table->collisions.pairsCulled = culled;
+    table->collisions.totalTested += tested;
+    table->collisions.totalCulled += culled;
+    return touched;
+}
+
+/**
+ * @brief Separates two balls and exchanges their velocity along the contact
+ * normal if they overlap.
+ * @param table The table the balls are on.
+ * @param i The first ball id.
+ * @param j The second ball id.
+ * @param diameter The variant's ball diameter.
+ * @return true if the balls overlapped.
+ */
+KERNEL bool resolve_ball_pair(Table* table, int i, int j, int diameter) {
+    float dx = table->px[j] - table->px[i];
+    float dy = table->py[j] - table->py[i];
+    float distSq = dx * dx + dy * dy;
+
+    if (distSq < diameter * diameter) {
+        float dist = sqrt(distSq);
+        float overlap = (diameter - dist) / 2.0f;
+
+        // Static resolution (move balls apart)
+        table->px[i] -= overlap * (dx / dist);
+        table->py[i] -= overlap * (dy / dist);
+        table->px[j] += overlap * (dx / dist);
+        table->py[j] += overlap * (dy / dist);
+
+        // Dynamic resolution (exchange velocity)
+        float nx = dx / dist; // Normal vector x
+        float ny = dy / dist; // Normal vector y
+
+        // Dot products
+        float p1 = table->vx[i] * nx + table->vy[i] * ny;
+        float p2 = table->vx[j] * nx + table->vy[j] * ny;
+
+        // New velocities along the normal
+        table->vx[i] += (p2 - p1) * nx;
+        table->vy[i] += (p2 - p1) * ny;
+        table->vx[j] += (p1 - p2) * nx;
+        table->vy[j] += (p1 - p2) * ny;
+        return true;
+    }
+    return false;
+}
+
+
+// --- Analytic Fast-Forward ---
+
+/**
+ * @brief Jumps every moving ball straight to where it would come to rest, if
+ * nothing can interrupt it on the way.
+ *
+ * FRICTION is a constant per-step multiplier F, so a ball left alone moves
+ * stepScale * v * (F + F^2 + ... + F^n) before its speed |v| F^n drops below
+ * MIN_VELOCITY: a geometric series with a closed form. Each ball's remaining
+ * path is then a straight segment. If no segment leaves the cushions, passes
+ * within a pocket's radius or comes within a diameter of another
+ * ball's segment (or resting position), the remaining steps cannot change
+ * anything but positions, and they are skipped.
+ * @param table The table to fast-forward.
+ * @param balls The variant's ball count.
+ * @param diameter The variant's ball diameter.
+ * @return true if the table was fast-forwarded to rest.
+ */
+KERNEL bool fast_forward_to_rest(Table* table, int balls, int diameter) {
+    const TableGeometry* geo = &table->geometry;
+    const double logF = log((double)table->stepFriction);
+
+    // Each ball's path from its current to its resting position
+    Vec2D from[MAX_BALLS];
+    Vec2D to[MAX_BALLS];
+    int stepsToRest = 0;
+
+    // Velocities after this step's collisions, not the integrated ones
+    BallMask moving = 0;
+    for (int i = 0; i < balls; ++i) {
+        if (ball_active(table, i) && !ball_at_rest(table, i)) moving |= (BallMask)1 << i;
+    }
+    if (moving == 0) return false; // The next step notices on its own
+
+    for (int i = 0; i < balls; ++i) {
+        if (!ball_active(table, i)) continue;
+        from[i] = ball_pos(table, i);
+        to[i] = from[i];
+        if (!((moving >> i) & 1u)) continue;
+
+        // Smallest n with |v| F^n < MIN_VELOCITY
+        double speed = sqrt((double)table->vx[i] * table->vx[i] + (double)table->vy[i] * table->vy[i]);
+        int n = (int)floor(log(MIN_VELOCITY / speed) / logF) + 1;
+        if (n < 1) n = 1;
+        double F = table->stepFriction;
+        double travel = table->stepScale * F * (1.0 - pow(F, n)) / (1.0 - F);
+        to[i].x = (float)(from[i].x + table->vx[i] * travel);
+        to[i].y = (float)(from[i].y + table->vy[i] * travel);
+        if (n > stepsToRest) stepsToRest = n;
+
+        // The table and the unreachable band are convex, so both ends inside
+        // means the whole path is
+        if (to[i].x < geo->cushionX1 || to[i].x > geo->cushionX2 ||
+            to[i].y < geo->cushionY1 || to[i].y > geo->cushionY2) {
+            return false;
+        }
+        if (fminf(from[i].y, to[i].y) > geo->reachY1 && fmaxf(from[i].y, to[i].y) < geo->reachY2) {
+            continue;
+        }
+        for (int p = 0; p < NUM_POCKETS; ++p) {
+            if (segment_point_dist_sq(from[i], to[i], geo->pockets[p].pos) < geo->pocketRadiusSq[p]) {
+                return false;
+            }
+        }
+    }
+
+    for (int i = 0; i < balls; ++i) {
+        if (!((moving >> i) & 1u)) continue;
+        for (int j = 0; j < balls; ++j) {
+            if (j == i || !ball_active(table, j)) continue;
+            if (((moving >> j) & 1u) && j < i) continue; // Moving pairs once
+            if (segment_dist_sq(from[i], to[i], from[j], to[j]) < diameter * diameter) {
+                return false;
+            }
+        }
+    }
+
+    for (int i = 0; i < balls; ++i) {
+        if (!((moving >> i) & 1u)) continue;
+        table->px[i] = to[i].x;
+        table->py[i] = to[i].y;
+        table->vx[i] = 0.0f;
+        table->vy[i] = 0.0f;
+    }
+    table->stepCount += stepsToRest;
+    table->fastForwardSteps += stepsToRest;
+    table->awake = 0;
+    table->state = STATE_AIMING;
+    return true;
+}
+
+/**
+ * @brief Returns the squared distance from point p to segment ab.
+ */
+static float segment_point_dist_sq(Vec2D a, Vec2D b, Vec2D p) {
+    float abx = b.x - a.x, aby = b.y - a.y;
+    float apx = p.x - a.x, apy = p.y - a.y;
+    float lenSq = abx * abx + aby * aby;
+    float t = lenSq > 0.0f ? (apx * abx + apy * aby) / lenSq : 0.0f;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    float dx = apx - abx * t, dy = apy - aby * t;
+    return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Returns the squared distance between segments ab and cd (0 if they
+ * cross).
+ */
+static float segment_dist_sq(Vec2D a, Vec2D b, Vec2D c, Vec2D d) {
+    // Proper crossing: c and d on opposite sides of ab, and a and b of cd
+    float d1 = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    float d2 = (b.x - a.x) * (d.y - a.y) - (b.y - a.y) * (d.x - a.x);
+    float d3 = (d.x - c.x) * (a.y - c.y) - (d.y - c.y) * (a.x - c.x);
+    float d4 = (d.x - c.x) * (b.y - c.y) - (d.y - c.y) * (b.x - c.x);
+    if (((d1 < 0) != (d2 < 0)) && ((d3 < 0) != (d4 < 0))) {
+        return 0.0f;
+    }
+
+    float best = segment_point_dist_sq(a, b, c);
+    float dist = segment_point_dist_sq(a, b, d);
+    if (dist < best) best = dist;
+    dist = segment_point_dist_sq(c, d, a);
+    if (dist < best) best = dist;
+    dist = segment_point_dist_sq(c, d, b);
+    if (dist < best) best = dist;
+    return best;
+}
+
+
+// --- Integration Kernels ---
+// The SIMD kernels run over every block of the variant's lanes holding an
+// awake ball and skip the rest; the scalar ones visit the awake balls only.
+// Sleeping and pocketed balls have zero velocity, so integration leaves
+// them unchanged, and cushion clamping is masked by the awake bits so it
+// never moves them.
+
+/**
+ * @brief Applies one step of friction, moves every awake ball by its
+ * velocity and stops balls whose speed dropped below MIN_VELOCITY. Speeds
+ * are compared squared, so no square root is needed.
+ * @param table The table to integrate.
+ * @param balls The variant's ball count.
+ * @return The balls that are still moving after this step.
+ */
+KERNEL BallMask integrate_balls(Table* table, int balls) {
+    const float minSpeedSq = MIN_VELOCITY * MIN_VELOCITY;
+    BallMask moving = 0;
+
+#if SIMD_WIDTH == 8
+    const int lanes = (balls + 15) & ~15;
+    const __m256 friction = _mm256_set1_ps(table->stepFriction);
+    const __m256 scale = _mm256_set1_ps(table->stepScale);
+    const __m256 minSq = _mm256_set1_ps(minSpeedSq);
+    for (int i = 0; i < lanes; i += 8) {
+        if (((table->awake >> i) & 0xffu) == 0) continue;
+        __m256 vx = _mm256_mul_ps(_mm256_loadu_ps(&table->vx[i]), friction);
+        __m256 vy = _mm256_mul_ps(_mm256_loadu_ps(&table->vy[i]), friction);
+        _mm256_storeu_ps(&table->px[i], _mm256_add_ps(_mm256_loadu_ps(&table->px[i]), _mm256_mul_ps(vx, scale)));
+        _mm256_storeu_ps(&table->py[i], _mm256_add_ps(_mm256_loadu_ps(&table->py[i]), _mm256_mul_ps(vy, scale)));
+        __m256 speedSq = _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy));
+        __m256 fast = _mm256_cmp_ps(speedSq, minSq, _CMP_GE_OQ);
+        _mm256_storeu_ps(&table->vx[i], _mm256_and_ps(vx, fast));
+        _mm256_storeu_ps(&table->vy[i], _mm256_and_ps(vy, fast));
+        moving |= (BallMask)_mm256_movemask_ps(fast) << i;
+    }
+#elif SIMD_WIDTH == 4 && defined(__SSE2__)
+    const int lanes = (balls + 15) & ~15;
+    const __m128 friction = _mm_set1_ps(table->stepFriction);
+    const __m128 scale = _mm_set1_ps(table->stepScale);
+    const __m128 minSq = _mm_set1_ps(minSpeedSq);
+    for (int i = 0; i < lanes; i += 4) {
+        if (((table->awake >> i) & 0xfu) == 0) continue;
+        __m128 vx = _mm_mul_ps(_mm_load_ps(&table->vx[i]), friction);
+        __m128 vy = _mm_mul_ps(_mm_load_ps(&table->vy[i]), friction);
+        _mm_store_ps(&table->px[i], _mm_add_ps(_mm_load_ps(&table->px[i]), _mm_mul_ps(vx, scale)));
+        _mm_store_ps(&table->py[i], _mm_add_ps(_mm_load_ps(&table->py[i]), _mm_mul_ps(vy, scale)));
+        __m128 speedSq = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+        __m128 fast = _mm_cmpge_ps(speedSq, minSq);
+        _mm_store_ps(&table->vx[i], _mm_and_ps(vx, fast));
+        _mm_store_ps(&table->vy[i], _mm_and_ps(vy, fast));
+        moving |= (BallMask)_mm_movemask_ps(fast) << i;
+    }
+#elif SIMD_WIDTH == 4
+    const int lanes = (balls + 15) & ~15;
+    const float32x4_t friction = vdupq_n_f32(table->stepFriction);
+    const float32x4_t scale = vdupq_n_f32(table->stepScale);
+    const float32x4_t minSq = vdupq_n_f32(minSpeedSq);
+    const uint32x4_t laneBits = {1, 2, 4, 8};
+    for (int i = 0; i < lanes; i += 4) {
+        if (((table->awake >> i) & 0xfu) == 0) continue;
+        float32x4_t vx = vmulq_f32(vld1q_f32(&table->vx[i]), friction);
+        float32x4_t vy = vmulq_f32(vld1q_f32(&table->vy[i]), friction);
+        vst1q_f32(&table->px[i], vaddq_f32(vld1q_f32(&table->px[i]), vmulq_f32(vx, scale)));
+        vst1q_f32(&table->py[i], vaddq_f32(vld1q_f32(&table->py[i]), vmulq_f32(vy, scale)));
+        float32x4_t speedSq = vaddq_f32(vmulq_f32(vx, vx), vmulq_f32(vy, vy));
+        uint32x4_t fast = vcgeq_f32(speedSq, minSq);
+        vst1q_f32(&table->vx[i], vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vx), fast)));
+        vst1q_f32(&table->vy[i], vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vy), fast)));
+        moving |= (BallMask)vaddvq_u32(vandq_u32(fast, laneBits)) << i;
+    }
+#else
+    (void)balls; // Only the SIMD blocks need the padded lane count
+    for (BallMask left = table->awake; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        float vx = table->vx[i] * table->stepFriction;
+        float vy = table->vy[i] * table->stepFriction;
+        table->px[i] += vx * table->stepScale;
+        table->py[i] += vy * table->stepScale;
+        if (vx * vx + vy * vy >= minSpeedSq) {
+            moving |= (BallMask)1 << i;
+        } else {
+            vx = 0.0f;
+            vy = 0.0f;
+        }
+        table->vx[i] = vx;
+        table->vy[i] = vy;
+    }
+#endif
+
+    return moving & table->active;
+}
+
+/**
+ * @brief Keeps awake balls inside the cushions, reflecting the velocity
+ * component of any ball that crossed one.
+ * @param table The table to clamp.
+ * @param balls The variant's ball count.
+ * @return The balls that crossed a cushion.
+ */
+KERNEL BallMask clamp_to_cushions(Table* table, int balls) {
+    const float tableX1 = table->geometry.cushionX1;
+    const float tableY1 = table->geometry.cushionY1;
+    const float tableX2 = table->geometry.cushionX2;
+    const float tableY2 = table->geometry.cushionY2;
+    BallMask clamped = 0;
+
+#if SIMD_WIDTH == 8
+    const int lanes = (balls + 15) & ~15;
+    const __m256 x1 = _mm256_set1_ps(tableX1), x2 = _mm256_set1_ps(tableX2);
+    const __m256 y1 = _mm256_set1_ps(tableY1), y2 = _mm256_set1_ps(tableY2);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    for (int i = 0; i < lanes; i += 8) {
+        if (((table->awake >> i) & 0xffu) == 0) continue;
+        __m256i bits = _mm256_and_si256(_mm256_set1_epi32((int)(table->awake >> i)), laneBits);
+        __m256 awake = _mm256_castsi256_ps(_mm256_cmpeq_epi32(bits, laneBits));
+        __m256 px = _mm256_loadu_ps(&table->px[i]), py = _mm256_loadu_ps(&table->py[i]);
+        __m256 vx = _mm256_loadu_ps(&table->vx[i]), vy = _mm256_loadu_ps(&table->vy[i]);
+
+        __m256 lo = _mm256_and_ps(_mm256_cmp_ps(px, x1, _CMP_LT_OQ), awake);
+        px = _mm256_blendv_ps(px, x1, lo);
+        vx = _mm256_xor_ps(vx, _mm256_and_ps(lo, sign));
+        __m256 hi = _mm256_and_ps(_mm256_cmp_ps(px, x2, _CMP_GT_OQ), awake);
+        px = _mm256_blendv_ps(px, x2, hi);
+        vx = _mm256_xor_ps(vx, _mm256_and_ps(hi, sign));
+        __m256 hit = _mm256_or_ps(lo, hi);
+
+        lo = _mm256_and_ps(_mm256_cmp_ps(py, y1, _CMP_LT_OQ), awake);
+        py = _mm256_blendv_ps(py, y1, lo);
+        vy = _mm256_xor_ps(vy, _mm256_and_ps(lo, sign));
+        hi = _mm256_and_ps(_mm256_cmp_ps(py, y2, _CMP_GT_OQ), awake);
+        py = _mm256_blendv_ps(py, y2, hi);
+        vy = _mm256_xor_ps(vy, _mm256_and_ps(hi, sign));
+        hit = _mm256_or_ps(hit, _mm256_or_ps(lo, hi));
+        clamped |= (BallMask)_mm256_movemask_ps(hit) << i;
+
+        _mm256_storeu_ps(&table->px[i], px);
+        _mm256_storeu_ps(&table->py[i], py);
+        _mm256_storeu_ps(&table->vx[i], vx);
+        _mm256_storeu_ps(&table->vy[i], vy);
+    }
+#elif SIMD_WIDTH == 4 && defined(__SSE2__)
+    const int lanes = (balls + 15) & ~15;
+    const __m128 x1 = _mm_set1_ps(tableX1), x2 = _mm_set1_ps(tableX2);
+    const __m128 y1 = _mm_set1_ps(tableY1), y2 = _mm_set1_ps(tableY2);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+    for (int i = 0; i < lanes; i += 4) {
+        if (((table->awake >> i) & 0xfu) == 0) continue;
+        __m128i bits = _mm_and_si128(_mm_set1_epi32((int)(table->awake >> i)), laneBits);
+        __m128 awake = _mm_castsi128_ps(_mm_cmpeq_epi32(bits, laneBits));
+        __m128 px = _mm_load_ps(&table->px[i]), py = _mm_load_ps(&table->py[i]);
+        __m128 vx = _mm_load_ps(&table->vx[i]), vy = _mm_load_ps(&table->vy[i]);
+
+        // SSE2 has no blend: select with and/andnot/or
+        __m128 lo = _mm_and_ps(_mm_cmplt_ps(px, x1), awake);
+        px = _mm_or_ps(_mm_andnot_ps(lo, px), _mm_and_ps(lo, x1));
+        vx = _mm_xor_ps(vx, _mm_and_ps(lo, sign));
+        __m128 hi = _mm_and_ps(_mm_cmpgt_ps(px, x2), awake);
+        px = _mm_or_ps(_mm_andnot_ps(hi, px), _mm_and_ps(hi, x2));
+        vx = _mm_xor_ps(vx, _mm_and_ps(hi, sign));
+        __m128 hit = _mm_or_ps(lo, hi);
+
+        lo = _mm_and_ps(_mm_cmplt_ps(py, y1), awake);
+        py = _mm_or_ps(_mm_andnot_ps(lo, py), _mm_and_ps(lo, y1));
+        vy = _mm_xor_ps(vy, _mm_and_ps(lo, sign));
+        hi = _mm_and_ps(_mm_cmpgt_ps(py, y2), awake);
+        py = _mm_or_ps(_mm_andnot_ps(hi, py), _mm_and_ps(hi, y2));
+        vy = _mm_xor_ps(vy, _mm_and_ps(hi, sign));
+        hit = _mm_or_ps(hit, _mm_or_ps(lo, hi));
+        clamped |= (BallMask)_mm_movemask_ps(hit) << i;
+
+        _mm_store_ps(&table->px[i], px);
+        _mm_store_ps(&table->py[i], py);
+        _mm_store_ps(&table->vx[i], vx);
+        _mm_store_ps(&table->vy[i], vy);
+    }
+#elif SIMD_WIDTH == 4
+    const int lanes = (balls + 15) & ~15;
+    const float32x4_t x1 = vdupq_n_f32(tableX1), x2 = vdupq_n_f32(tableX2);
+    const float32x4_t y1 = vdupq_n_f32(tableY1), y2 = vdupq_n_f32(tableY2);
+    const uint32x4_t sign = vdupq_n_u32(0x80000000u);
+    const uint32x4_t laneBits = {1, 2, 4, 8};
+    for (int i = 0; i < lanes; i += 4) {
+        if (((table->awake >> i) & 0xfu) == 0) continue;
+        uint32x4_t awake = vtstq_u32(vdupq_n_u32(table->awake >> i), laneBits);
+        float32x4_t px = vld1q_f32(&table->px[i]), py = vld1q_f32(&table->py[i]);
+        uint32x4_t vx = vreinterpretq_u32_f32(vld1q_f32(&table->vx[i]));
+        uint32x4_t vy = vreinterpretq_u32_f32(vld1q_f32(&table->vy[i]));
+
+        uint32x4_t lo = vandq_u32(vcltq_f32(px, x1), awake);
+        px = vbslq_f32(lo, x1, px);
+        vx = veorq_u32(vx, vandq_u32(lo, sign));
+        uint32x4_t hi = vandq_u32(vcgtq_f32(px, x2), awake);
+        px = vbslq_f32(hi, x2, px);
+        vx = veorq_u32(vx, vandq_u32(hi, sign));
+        uint32x4_t hit = vorrq_u32(lo, hi);
+
+        lo = vandq_u32(vcltq_f32(py, y1), awake);
+        py = vbslq_f32(lo, y1, py);
+        vy = veorq_u32(vy, vandq_u32(lo, sign));
+        hi = vandq_u32(vcgtq_f32(py, y2), awake);
+        py = vbslq_f32(hi, y2, py);
+        vy = veorq_u32(vy, vandq_u32(hi, sign));
+        hit = vorrq_u32(hit, vorrq_u32(lo, hi));
+        clamped |= (BallMask)vaddvq_u32(vandq_u32(hit, laneBits)) << i;
+
+        vst1q_f32(&table->px[i], px);
+        vst1q_f32(&table->py[i], py);
+        vst1q_f32(&table->vx[i], vreinterpretq_f32_u32(vx));
+        vst1q_f32(&table->vy[i], vreinterpretq_f32_u32(vy));
+    }
+#else
+    (void)balls; // Only the SIMD blocks need the padded lane count
+    for (BallMask left = table->awake; left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        BallMask bit = (BallMask)1 << i;
+        if (table->px[i] < tableX1) { table->px[i] = tableX1; table->vx[i] *= -1; clamped |= bit; }
+        if (table->px[i] > tableX2) { table->px[i] = tableX2; table->vx[i] *= -1; clamped |= bit; }
+        if (table->py[i] < tableY1) { table->py[i] = tableY1; table->vy[i] *= -1; clamped |= bit; }
+        if (table->py[i] > tableY2) { table->py[i] = tableY2; table->vy[i] *= -1; clamped |= bit; }
+    }
+#endif
+    return clamped;
+}
+#endif
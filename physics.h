@@ -0,0 +1,300 @@
+// -----------------------------------------------------------------------------
+// Table state and physics simulation for the 8-Ball Pool Game
+//
+// This module has no SDL dependency so it can run without a window, e.g. for
+// the headless batch shot runner.
+//
+// A table is one of the variants in TABLE_VARIANTS. Each variant's ball
+// count and ball size are compile-time constants of its own copy of the
+// fixed-step kernels, and update() dispatches to the copy for the table's
+// variant (see physics.c).
+// -----------------------------------------------------------------------------
+
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Constants ---
+// Lengths are in table units, with the origin at the top-left corner of the
+// felt. One unit is one pixel of the original 1000x500 window; the renderer
+// scales units to whatever the output is.
+#define TABLE_WIDTH 900
+#define TABLE_HEIGHT 450
+#define NUM_POCKETS 6
+#define CUSHION_WIDTH 25
+#define RACK_APEX_X 700.0f // Head ball of a pool rack, and the foot spot
+#define CUE_START_X 200.0f // Cue ball at the start of a pool rack, and the head spot
+
+// The table variants:
+// X(id, name, balls, ballRadius, pocketRadius)
+// with the number of balls (the cue ball included) and the ball and pocket
+// radii in table units. Each one gets its own specialized physics kernels.
+#define TABLE_VARIANTS(X) \
+    X(VARIANT_EIGHT_BALL, "8ball", 16, 15, 30) \
+    X(VARIANT_NINE_BALL, "9ball", 10, 15, 30) \
+    X(VARIANT_SNOOKER, "snooker", 22, 10, 22) \
+    X(VARIANT_PRACTICE, "practice", 29, 12, 34)
+
+// Most balls of any variant; every ball array has room for this many
+#define MAX_BALLS 32
+
+// Physics constants
+#define FRICTION 0.99f   // Slightly higher friction to slow balls a bit more
+#define CUE_POWER_MULTIPLIER 0.15f
+#define MAX_CUE_SPEED 200.0f // Fastest shot strike_cue_ball() takes, table units per base frame
+#define MIN_VELOCITY 0.1f
+
+// Fixed-timestep settings. The constants above are tuned for one physics step
+// per frame at BASE_PHYSICS_HZ; velocities stay in those units (table units
+// per base frame) and each step is scaled to its share of a base frame.
+#define BASE_PHYSICS_HZ 60
+#define DEFAULT_PHYSICS_HZ 240
+#define MIN_PHYSICS_HZ 60
+#define MAX_PHYSICS_HZ 1000
+
+// Steps between fast-forward attempts (see Table.fastForward)
+#define FAST_FORWARD_INTERVAL 16
+
+// Longest shot simulated by simulate_to_rest(), in seconds of simulated time
+#define MAX_SHOT_SECONDS 120
+
+// Events kept per shot in ShotEvents.list
+#define MAX_SHOT_EVENTS 32
+
+// Starting value for table_hash() (the FNV-1a 64-bit offset basis)
+#define TABLE_HASH_SEED 0xcbf29ce484222325ULL
+
+// --- Data Structures ---
+
+// A simple 2D vector
+typedef struct {
+    float x;
+    float y;
+} Vec2D;
+
+// One bit per ball, bit i for ball id i
+typedef uint32_t BallMask;
+
+// Ball arrays are padded to a whole number of 16-lane blocks so the SIMD
+// kernels never need a scalar tail. Padding lanes are never active.
+#define BALL_LANES ((MAX_BALLS + 15) & ~15)
+
+// The kinds of table, see TABLE_VARIANTS
+typedef enum {
+#define VARIANT_ENUM(id, name, balls, ballRadius, pocketRadius) id,
+    TABLE_VARIANTS(VARIANT_ENUM)
+#undef VARIANT_ENUM
+    VARIANT_COUNT
+} TableVariant;
+
+#define VARIANT_FITS(id, name, balls, ballRadius, pocketRadius) \
+    _Static_assert((balls) <= MAX_BALLS && MAX_BALLS <= 8 * (int)sizeof(BallMask), #id " has too many balls");
+TABLE_VARIANTS(VARIANT_FITS)
+#undef VARIANT_FITS
+
+// Represents the six pockets on the table
+typedef struct {
+    Vec2D pos;
+} Pocket;
+
+// The table's fixed layout, derived once by setup_table() so the physics
+// loops read precomputed bounds instead of rebuilding them every step
+typedef struct {
+    float ballRadius;
+    float pocketRadius;
+    float cushionX1; // Cushion lines for ball centers
+    float cushionY1;
+    float cushionX2;
+    float cushionY2;
+    Pocket pockets[NUM_POCKETS];
+    float pocketRadiusSq[NUM_POCKETS]; // Squared capture radius of each pocket
+    float reachY1; // Ball centers strictly between reachY1 and reachY2 are
+    float reachY2; // out of reach of every pocket
+    float headSpotX; // Spots on the long axis where the rules put balls back:
+    float footSpotX; // the cue ball at the head, object balls at the foot
+} TableGeometry;
+
+#ifdef POOL_FIXED_POINT
+// State of the integer physics backend (see fixed.c). During a shot it is
+// the authoritative ball state and the Table's float arrays are a view of
+// it, refreshed after every step.
+typedef struct {
+    _Alignas(16) int32_t px[BALL_LANES]; // Positions, 14 fractional bits
+    _Alignas(16) int32_t py[BALL_LANES];
+    _Alignas(16) int32_t vx[BALL_LANES]; // Velocities, 20 fractional bits
+    _Alignas(16) int32_t vy[BALL_LANES];
+    int32_t cushionX1;                   // TableGeometry, 14 fractional bits
+    int32_t cushionY1;
+    int32_t cushionX2;
+    int32_t cushionY2;
+    int32_t pocketX[NUM_POCKETS];
+    int32_t pocketY[NUM_POCKETS];
+    int64_t pocketRadiusSq[NUM_POCKETS]; // 28 fractional bits
+    int32_t reachY1;
+    int32_t reachY2;
+    int64_t scale;    // stepScale, 32 fractional bits
+    int64_t friction; // stepFriction, 32 fractional bits
+    int64_t travel;   // Distance a ball coasts per unit of speed, 16 fractional bits
+    int64_t drift;    // Bound on a coasting ball's rounding drift per step, 14 fractional bits
+} FixedState;
+#endif
+
+// Enum for different game states. The physics only switches between
+// aiming and simulating; the rules end the game (see rules.c).
+typedef enum {
+    STATE_AIMING,
+    STATE_SIMULATING,
+    STATE_GAME_OVER
+} GameState;
+
+// Things that happen during a shot that the rules care about
+typedef enum {
+    SHOT_EVENT_CONTACT, // The cue ball touched its first ball (other: that ball)
+    SHOT_EVENT_CUSHION, // A ball hit a cushion
+    SHOT_EVENT_POCKET   // A ball dropped (other: the pocket)
+} ShotEventType;
+
+typedef struct {
+    uint8_t type;  // ShotEventType
+    uint8_t ball;
+    uint8_t other;
+} ShotEvent;
+
+// The events of the latest shot, recorded by update() as they happen and
+// cleared when the cue ball is struck. The list keeps the first
+// MAX_SHOT_EVENTS in order; the summary below covers all of them, so the
+// rules never need to look at the balls to judge a shot.
+typedef struct {
+    int count;                       // Events so far, including any the list dropped
+    ShotEvent list[MAX_SHOT_EVENTS];
+    int8_t firstContact;             // Ball the cue ball touched first, or -1
+    int8_t firstPocketed;            // Object ball pocketed first, or -1
+    BallMask cushioned;              // Balls that hit a cushion after the first contact
+    BallMask pocketed;               // Balls pocketed during the shot
+} ShotEvents;
+
+// How a table advances between physics steps
+typedef enum {
+    SOLVER_FIXED_STEP, // Discrete steps with overlap resolution (default)
+    SOLVER_EVENTS      // Exact time-of-impact event stepping (see ccd.c)
+} Solver;
+
+// Stages of update() timed when a table has a profile clock
+typedef enum {
+    PHYS_STAGE_INTEGRATE, // Friction, motion and stopping slow balls
+    PHYS_STAGE_CUSHIONS,
+    PHYS_STAGE_BALLS,     // Ball-ball broad and narrow phase
+    PHYS_STAGE_POCKETS,   // Pocketing and end-of-step bookkeeping
+    PHYS_STAGE_EVENTS,    // advance_events() under SOLVER_EVENTS
+    PHYS_STAGE_COUNT
+} PhysicsStage;
+
+// Returns a monotonic tick count (e.g. SDL_GetPerformanceCounter)
+typedef uint64_t (*ProfileClock)(void);
+
+// Ball-ball broad-phase counters. "Culled" pairs are pairs of active balls
+// the broad phase ruled out without a distance test.
+typedef struct {
+    int pairsTested;      // Pairs given a distance test in the latest step
+    int pairsCulled;      // Pairs skipped in the latest step
+    uint64_t totalTested; // Totals since the table was set up
+    uint64_t totalCulled;
+} CollisionStats;
+
+// A complete, self-contained simulation context. All physics entry points
+// take the table they operate on, so any number of tables can be simulated
+// independently (and copied by plain assignment).
+//
+// Balls are stored as a structure of arrays indexed by ball id (0 is the cue
+// ball) so the integration kernels can process several balls per
+// instruction.
+typedef struct {
+    _Alignas(16) float px[BALL_LANES]; // Positions
+    _Alignas(16) float py[BALL_LANES];
+    _Alignas(16) float vx[BALL_LANES]; // Velocities (table units per base frame)
+    _Alignas(16) float vy[BALL_LANES];
+    BallMask active;                   // Balls still on the table
+    BallMask awake;                    // Balls the next fixed step processes (see update())
+    uint8_t sweepOrder[MAX_BALLS];     // Ball ids sorted by x for the broad phase
+    CollisionStats collisions;
+    TableGeometry geometry;
+    GameState state;
+    ShotEvents shot;   // What the latest shot did so far
+    Solver solver;
+    TableVariant variant; // Kind of table racked by setup_table()
+    int ballCount;        // Balls of the variant; ids from ballCount on are never active
+    uint32_t rackSeed;   // Rack order used by setup_table(); 0 is the standard rack
+    bool fastForward;    // Let update() jump quiet tables straight to rest
+    uint64_t stepCount;  // Fixed steps simulated (or skipped) since set up
+    uint64_t fastForwardSteps; // Steps skipped by fast-forward since set up
+    uint64_t eventCount; // Events resolved by SOLVER_EVENTS since set up
+    ProfileClock profileClock; // If set, update() times its stages with it
+    uint64_t stageTicks[PHYS_STAGE_COUNT]; // Ticks per stage, summed until cleared
+    int physicsHz;      // Fixed physics steps per second
+    float stepScale;    // Fraction of a base frame covered by one step
+    float stepFriction; // FRICTION scaled to one step
+#ifdef POOL_FIXED_POINT
+    FixedState fixed;   // Integer ball state and constants (see fixed.c)
+#endif
+} Table;
+
+// --- Inline Helpers ---
+
+// Returns true if ball i is still on the table
+static inline bool ball_active(const Table* table, int i) {
+    return (table->active >> i) & 1u;
+}
+
+// Returns true if ball i has no velocity
+static inline bool ball_at_rest(const Table* table, int i) {
+    return table->vx[i] == 0.0f && table->vy[i] == 0.0f;
+}
+
+// Returns the number of balls in a mask
+static inline int ball_count(BallMask mask) {
+    int count = 0;
+    for (; mask != 0; mask &= mask - 1) count++;
+    return count;
+}
+
+// Returns the lowest ball id in a non-empty mask, so a mask can be walked
+// as a compact list of ids with `mask &= mask - 1`
+static inline int lowest_ball(BallMask mask) {
+    return __builtin_ctzll((unsigned long long)mask);
+}
+
+// Returns the mask of every ball of the table's variant
+static inline BallMask all_balls(const Table* table) {
+    return (BallMask)(((uint64_t)1 << table->ballCount) - 1);
+}
+
+// Returns ball i's position
+static inline Vec2D ball_pos(const Table* table, int i) {
+    return (Vec2D){table->px[i], table->py[i]};
+}
+
+// --- Function Prototypes ---
+const char* variant_name(TableVariant variant);
+int variant_balls(TableVariant variant);
+bool variant_from_name(const char* name, TableVariant* variant);
+void init_table(Table* table, int physicsHz);
+void setup_table(Table* table);
+void set_physics_rate(Table* table, int hz);
+bool valid_cue(Vec2D vel);
+bool strike_cue_ball(Table* table, Vec2D vel);
+void update(Table* table);
+int simulate_to_rest(Table* table);
+uint64_t table_hash(const Table* table, uint64_t hash);
+void clear_shot_events(ShotEvents* shot);
+void record_shot_event(Table* table, ShotEventType type, int ball, int other);
+void advance_events(Table* table, double frames);
+double advance_to_event(Table* table, double frames);
+#ifdef POOL_FIXED_POINT
+void fixed_set_rate(Table* table);
+void fixed_load(Table* table);
+void fixed_update(Table* table, uint64_t start);
+#endif
+
+#endif
@@ -0,0 +1,260 @@
+// -----------------------------------------------------------------------------
+// Aim preview for the 8-Ball Pool Game
+//
+// Balls travel in straight lines between events, so a path is fully
+// described by the positions at its events: advance_to_event() jumps from
+// one to the next, and a preview costs a few dozen events instead of the
+// hundreds of fixed steps the shot will actually take. The worker keeps
+// only the newest request; aims superseded while it traces are dropped.
+// -----------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "preview.h"
+
+struct PreviewWorker {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake; // Signalled when a request is made or on shutdown
+    bool pending;        // table and cue hold an untraced request
+    bool tracing;        // A request is being traced
+    bool shuttingDown;
+    Table table;
+    Vec2D cue;
+    bool fresh;          // result holds an unclaimed preview
+    AimPreview result;
+
+    // Owned by the requesting thread
+    bool requested;
+    uint64_t lastHash;
+    Vec2D lastCue;
+};
+
+// --- Function Prototypes ---
+static void* worker_main(void* arg);
+static void add_point(PreviewPath* path, const Table* table, int ball);
+static bool follow(PreviewPath* path, const Table* table, int ball, bool* done);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Traces a shot until the cue ball's first contact with another ball
+ * and on until both balls have stopped or turned PREVIEW_AFTER_POINTS
+ * times, using the event solver whatever the table's own solver is.
+ * @param table The table the shot would be played on (must be aiming).
+ * @param cue The cue ball's velocity.
+ * @param preview Receives the predicted paths.
+ */
+void preview_trace(const Table* table, Vec2D cue, AimPreview* preview) {
+    preview->cue = cue;
+    preview->tableHash = table_hash(table, TABLE_HASH_SEED);
+    preview->cuePath.count = 0;
+    preview->hitPath.count = 0;
+    preview->cueAfter.count = 0;
+    preview->hitBall = -1;
+    preview->scratch = false;
+
+    Table trace = *table;
+    trace.solver = SOLVER_EVENTS;
+    trace.profileClock = NULL;
+    if (!strike_cue_ball(&trace, cue)) {
+        return;
+    }
+    add_point(&preview->cuePath, &trace, 0);
+
+    double frames = 0.0;
+    bool hitDone = false;
+    bool cueDone = false;
+    for (int n = 0; n < PREVIEW_MAX_EVENTS && trace.state == STATE_SIMULATING &&
+                    frames < PREVIEW_MAX_FRAMES; ++n) {
+        frames += advance_to_event(&trace, PREVIEW_MAX_FRAMES - frames);
+
+        if (preview->hitBall < 0) {
+            add_point(&preview->cuePath, &trace, 0);
+            if (!ball_active(&trace, 0)) {
+                preview->scratch = true;
+                return;
+            }
+            // Only the cue ball moves before the first contact
+            for (int i = 1; i < trace.ballCount; ++i) {
+                if (ball_active(&trace, i) && !ball_at_rest(&trace, i)) {
+                    preview->hitBall = i;
+                    add_point(&preview->hitPath, &trace, i);
+                    add_point(&preview->cueAfter, &trace, 0);
+                    break;
+                }
+            }
+        } else {
+            follow(&preview->hitPath, &trace, preview->hitBall, &hitDone);
+            follow(&preview->cueAfter, &trace, 0, &cueDone);
+            if (hitDone && cueDone) {
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Creates a preview worker and its thread.
+ * @return The worker, or NULL on failure.
+ */
+PreviewWorker* preview_create() {
+    PreviewWorker* worker = calloc(1, sizeof(PreviewWorker));
+    if (worker == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->wake, NULL);
+    if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+        pthread_cond_destroy(&worker->wake);
+        pthread_mutex_destroy(&worker->lock);
+        free(worker);
+        return NULL;
+    }
+    return worker;
+}
+
+/**
+ * @brief Asks for a preview of an aim, unless it is within
+ * PREVIEW_REUSE_DELTA of the last aim requested on the same table. Replaces
+ * any request the worker has not started on.
+ * @param worker The worker.
+ * @param table The table to aim on (copied).
+ * @param cue The cue ball's velocity.
+ * @return true if the aim will be traced, false if the last preview is
+ * close enough.
+ */
+bool preview_request(PreviewWorker* worker, const Table* table, Vec2D cue) {
+    uint64_t hash = table_hash(table, TABLE_HASH_SEED);
+    float dx = cue.x - worker->lastCue.x;
+    float dy = cue.y - worker->lastCue.y;
+    if (worker->requested && hash == worker->lastHash &&
+        dx * dx + dy * dy < PREVIEW_REUSE_DELTA * PREVIEW_REUSE_DELTA) {
+        return false;
+    }
+    worker->requested = true;
+    worker->lastHash = hash;
+    worker->lastCue = cue;
+
+    pthread_mutex_lock(&worker->lock);
+    worker->table = *table;
+    worker->cue = cue;
+    worker->pending = true;
+    pthread_cond_signal(&worker->wake);
+    pthread_mutex_unlock(&worker->lock);
+    return true;
+}
+
+/**
+ * @brief Collects the newest finished preview.
+ * @param worker The worker.
+ * @param preview Receives the preview.
+ * @return true if a preview finished since the last call.
+ */
+bool preview_poll(PreviewWorker* worker, AimPreview* preview) {
+    pthread_mutex_lock(&worker->lock);
+    bool fresh = worker->fresh;
+    if (fresh) {
+        *preview = worker->result;
+        worker->fresh = false;
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return fresh;
+}
+
+/**
+ * @brief Returns true while a requested preview has not been collected yet.
+ */
+bool preview_busy(PreviewWorker* worker) {
+    pthread_mutex_lock(&worker->lock);
+    bool busy = worker->pending || worker->tracing || worker->fresh;
+    pthread_mutex_unlock(&worker->lock);
+    return busy;
+}
+
+/**
+ * @brief Stops the worker thread and frees the worker.
+ */
+void preview_destroy(PreviewWorker* worker) {
+    if (worker == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    worker->shuttingDown = true;
+    pthread_cond_signal(&worker->wake);
+    pthread_mutex_unlock(&worker->lock);
+    pthread_join(worker->thread, NULL);
+
+    pthread_cond_destroy(&worker->wake);
+    pthread_mutex_destroy(&worker->lock);
+    free(worker);
+}
+
+/**
+ * @brief Worker thread body: traces the newest request until shut down.
+ */
+static void* worker_main(void* arg) {
+    PreviewWorker* worker = arg;
+    Table table;
+    AimPreview preview;
+
+    pthread_mutex_lock(&worker->lock);
+    for (;;) {
+        while (!worker->shuttingDown && !worker->pending) {
+            pthread_cond_wait(&worker->wake, &worker->lock);
+        }
+        if (worker->shuttingDown) {
+            break;
+        }
+        table = worker->table;
+        Vec2D cue = worker->cue;
+        worker->pending = false;
+        worker->tracing = true;
+        pthread_mutex_unlock(&worker->lock);
+
+        preview_trace(&table, cue, &preview);
+
+        pthread_mutex_lock(&worker->lock);
+        worker->result = preview;
+        worker->fresh = true;
+        worker->tracing = false;
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return NULL;
+}
+
+/**
+ * @brief Appends a ball's position to a path, if there is room.
+ */
+static void add_point(PreviewPath* path, const Table* table, int ball) {
+    if (path->count < PREVIEW_MAX_POINTS) {
+        path->points[path->count++] = ball_pos(table, ball);
+    }
+}
+
+/**
+ * @brief Extends a path after the first contact with a ball's position if
+ * the ball has moved PREVIEW_MIN_SEGMENT since the path's last point or has
+ * stopped (balls only change direction at events, so each point is a turn
+ * or the end of the path).
+ * @param done Set once the ball has stopped or PREVIEW_AFTER_POINTS points
+ * follow the contact; the path is left alone after that.
+ * @return *done.
+ */
+static bool follow(PreviewPath* path, const Table* table, int ball, bool* done) {
+    if (*done) {
+        return true;
+    }
+    bool stopped = !ball_active(table, ball) || ball_at_rest(table, ball);
+    Vec2D last = path->points[path->count - 1];
+    float dx = table->px[ball] - last.x;
+    float dy = table->py[ball] - last.y;
+    float distSq = dx * dx + dy * dy;
+    if (distSq > PREVIEW_MIN_SEGMENT * PREVIEW_MIN_SEGMENT || (stopped && distSq > 0.0f)) {
+        add_point(path, table, ball);
+    }
+    *done = stopped || path->count > PREVIEW_AFTER_POINTS;
+    return *done;
+}
@@ -0,0 +1,55 @@
+// -----------------------------------------------------------------------------
+// Aim preview for the 8-Ball Pool Game
+//
+// Predicts where a shot sends the cue ball, which ball it hits first and
+// where both go after the contact, by tracing the shot event by event with
+// the continuous collision solver. A worker thread traces the latest aim
+// so the render thread never waits on it.
+// -----------------------------------------------------------------------------
+
+#ifndef PREVIEW_H
+#define PREVIEW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "physics.h"
+
+#define PREVIEW_MAX_POINTS 16    // Points per traced path
+#define PREVIEW_AFTER_POINTS 3   // Turns traced per ball after the first contact
+#define PREVIEW_MIN_SEGMENT 15 // Shorter moves are not turns, in table units (a pool ball's radius)
+#define PREVIEW_MAX_EVENTS 64    // Events traced in all
+#define PREVIEW_MAX_FRAMES 600.0 // Time traced at most, in base frames
+
+// A requested aim closer than this to the last one (2 units of mouse
+// travel) reuses its preview instead of tracing again
+#define PREVIEW_REUSE_DELTA (2.0f * CUE_POWER_MULTIPLIER)
+
+// A polyline of ball positions
+typedef struct {
+    Vec2D points[PREVIEW_MAX_POINTS];
+    int count;
+} PreviewPath;
+
+// The predicted start of a shot
+typedef struct {
+    Vec2D cue;           // The aim it was traced for
+    uint64_t tableHash;  // table_hash() of the table it was traced on
+    PreviewPath cuePath; // The cue ball up to its first contact with a ball
+    int hitBall;         // First ball hit, or -1
+    PreviewPath hitPath; // The hit ball after the contact
+    PreviewPath cueAfter; // The cue ball after the contact
+    bool scratch;        // The cue ball is pocketed before hitting a ball
+} AimPreview;
+
+// Opaque background tracer
+typedef struct PreviewWorker PreviewWorker;
+
+// --- Function Prototypes ---
+void preview_trace(const Table* table, Vec2D cue, AimPreview* preview);
+PreviewWorker* preview_create();
+bool preview_request(PreviewWorker* worker, const Table* table, Vec2D cue);
+bool preview_poll(PreviewWorker* worker, AimPreview* preview);
+bool preview_busy(PreviewWorker* worker);
+void preview_destroy(PreviewWorker* worker);
+
+#endif
@@ -0,0 +1,332 @@
+// -----------------------------------------------------------------------------
+// Frame and physics profiler for the 8-Ball Pool Game
+//
+// The game loop brackets each stage with profiler_lap() and ends every frame
+// with profiler_end_frame(). Physics stages are timed inside update() through
+// the table's profile clock and collected once per frame.
+//
+// CSV format: a header row, then one row per frame with the frame number,
+// the time of every stage in microseconds, the physics steps taken and the
+// time the loop sat idle before the frame.
+//
+// The game loop blocks while nothing changes, so frames are not evenly
+// spaced: the frame rate and busy share are measured over wall time, and
+// idle time is never counted as part of a frame.
+// -----------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <string.h>
+#include "profiler.h"
+
+// Stage names for the overlay and the CSV header, in ProfileStage order
+static const char* STAGE_NAMES[PROF_STAGE_COUNT] = {
+    "input", "integrate", "cushions", "balls", "pockets", "events",
+    "table", "draw_balls", "cue", "overlay", "present", "frame"
+};
+
+// Fonts tried, in order, when no font is given
+static const char* DEFAULT_FONTS[] = {
+    "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+    "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+    "/usr/share/fonts/dejavu/DejaVuSansMono.ttf",
+    "/System/Library/Fonts/Menlo.ttc",
+    "C:/Windows/Fonts/consola.ttf"
+};
+
+// --- Function Prototypes ---
+static void refresh_overlay(Profiler* profiler);
+static void rate_line(const Profiler* profiler, char* text, size_t size);
+static void window_stats(const Profiler* profiler, int stage, float* min, float* avg, float* p99);
+static int compare_floats(const void* a, const void* b);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Prepares a profiler with an empty window and the overlay hidden.
+ * Must be called after TTF_Init(). Without a usable font the overlay stays
+ * unavailable, but timing and the CSV log still work.
+ * @param profiler The profiler to initialize.
+ * @param csvPath File to log every frame to, or NULL for no log.
+ * @param fontPath Overlay font, or NULL to use fontData.
+ * @param fontData Overlay font read in place (e.g. from the asset pack),
+ * used when fontPath is NULL and closed by the profiler; NULL to try common
+ * monospace fonts.
+ * @return false if the CSV file could not be created.
+ */
+bool profiler_init(Profiler* profiler, const char* csvPath, const char* fontPath, SDL_RWops* fontData) {
+    memset(profiler, 0, sizeof(*profiler));
+    profiler->msPerTick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    profiler->rateStart = profiler_ticks();
+
+    if (csvPath != NULL) {
+        profiler->csv = fopen(csvPath, "w");
+        if (profiler->csv == NULL) {
+            printf("Could not create profile log %s\n", csvPath);
+            return false;
+        }
+        fprintf(profiler->csv, "frame");
+        for (int s = 0; s < PROF_STAGE_COUNT; ++s) {
+            fprintf(profiler->csv, ",%s_us", STAGE_NAMES[s]);
+        }
+        fprintf(profiler->csv, ",steps,idle_us\n");
+    }
+
+    if (fontPath != NULL) {
+        profiler->font = TTF_OpenFont(fontPath, PROFILE_FONT_SIZE);
+    } else if (fontData != NULL) {
+        profiler->font = TTF_OpenFontRW(fontData, 1, PROFILE_FONT_SIZE);
+    } else {
+        int count = (int)(sizeof(DEFAULT_FONTS) / sizeof(DEFAULT_FONTS[0]));
+        for (int i = 0; i < count && profiler->font == NULL; ++i) {
+            profiler->font = TTF_OpenFont(DEFAULT_FONTS[i], PROFILE_FONT_SIZE);
+        }
+    }
+    if (profiler->font == NULL) {
+        printf("No profiler font could be opened, the overlay is disabled. TTF_Error: %s\n", TTF_GetError());
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the current tick count. Usable as a table's profile clock.
+ */
+uint64_t profiler_ticks() {
+    return SDL_GetPerformanceCounter();
+}
+
+/**
+ * @brief Adds the ticks since start to a stage of the current frame.
+ * @param profiler The profiler to record to.
+ * @param stage The stage that just finished.
+ * @param start The tick count when the stage began.
+ * @return The current tick count, i.e. the start of the next stage.
+ */
+uint64_t profiler_lap(Profiler* profiler, ProfileStage stage, uint64_t start) {
+    uint64_t now = profiler_ticks();
+    profiler->frameTicks[stage] += now - start;
+    return now;
+}
+
+/**
+ * @brief Moves the ticks a table's update() calls spent in each stage into
+ * the current frame and clears them on the table.
+ * @param profiler The profiler to record to.
+ * @param table The table being profiled.
+ */
+void profiler_add_physics(Profiler* profiler, Table* table) {
+    for (int s = 0; s < PHYS_STAGE_COUNT; ++s) {
+        profiler->frameTicks[PROF_INTEGRATE + s] += table->stageTicks[s];
+        table->stageTicks[s] = 0;
+    }
+}
+
+/**
+ * @brief Records time the game loop spent waiting for something to change.
+ * @param profiler The profiler to record to.
+ * @param ticks The ticks spent idle.
+ */
+void profiler_add_idle(Profiler* profiler, uint64_t ticks) {
+    profiler->idleTicks += ticks;
+}
+
+/**
+ * @brief Finishes the current frame: stores it in the rolling window, logs
+ * it to the CSV file, updates the frame rate once PROFILE_RATE_SECONDS have
+ * passed and starts a new, empty frame.
+ * @param profiler The profiler to record to.
+ * @param steps Physics steps taken during the frame.
+ */
+void profiler_end_frame(Profiler* profiler, int steps) {
+    int slot = (int)(profiler->frames % PROFILE_WINDOW);
+    for (int s = 0; s < PROF_STAGE_COUNT; ++s) {
+        profiler->samples[s][slot] = (float)(profiler->frameTicks[s] * profiler->msPerTick);
+    }
+
+    if (profiler->csv != NULL) {
+        fprintf(profiler->csv, "%llu", (unsigned long long)profiler->frames);
+        for (int s = 0; s < PROF_STAGE_COUNT; ++s) {
+            fprintf(profiler->csv, ",%.1f", profiler->frameTicks[s] * profiler->msPerTick * 1000.0);
+        }
+        fprintf(profiler->csv, ",%d,%.1f\n", steps, profiler->idleTicks * profiler->msPerTick * 1000.0);
+    }
+
+    profiler->rateFrames++;
+    profiler->rateIdleTicks += profiler->idleTicks;
+    uint64_t now = profiler_ticks();
+    double elapsedMs = (now - profiler->rateStart) * profiler->msPerTick;
+    if (elapsedMs >= PROFILE_RATE_SECONDS * 1000.0) {
+        profiler->fps = (float)(profiler->rateFrames * 1000.0 / elapsedMs);
+        profiler->busyPercent = (float)(100.0 * (1.0 - profiler->rateIdleTicks * profiler->msPerTick / elapsedMs));
+        profiler->rateStart = now;
+        profiler->rateFrames = 0;
+        profiler->rateIdleTicks = 0;
+    }
+
+    memset(profiler->frameTicks, 0, sizeof(profiler->frameTicks));
+    profiler->idleTicks = 0;
+    profiler->frames++;
+}
+
+/**
+ * @brief Shows or hides the overlay (if a font is available).
+ * @param profiler The profiler to toggle.
+ */
+void profiler_toggle_overlay(Profiler* profiler) {
+    profiler->overlayVisible = !profiler->overlayVisible && profiler->font != NULL;
+}
+
+/**
+ * @brief Draws the overlay in the top left corner if it is visible. The text
+ * is updated every PROFILE_REFRESH_FRAMES frames, so it stays readable and
+ * costs little in between; it is drawn from a glyph atlas made once.
+ * @param profiler The profiler to draw.
+ * @param renderer The renderer to draw with.
+ */
+void profiler_draw_overlay(Profiler* profiler, SDL_Renderer* renderer) {
+    if (!profiler->overlayVisible) {
+        return;
+    }
+    if (profiler->atlas.texture == NULL) {
+        if (!text_create_atlas(&profiler->atlas, renderer, profiler->font)) {
+            profiler->overlayVisible = false;
+            return;
+        }
+        refresh_overlay(profiler);
+    } else if (profiler->frames % PROFILE_REFRESH_FRAMES == 0) {
+        refresh_overlay(profiler);
+    }
+
+    int width = 0;
+    int height = 0;
+    for (int i = 0; i <= PROF_STAGE_COUNT + 1; ++i) {
+        if (profiler->lines[i].width > width) width = profiler->lines[i].width;
+        height += profiler->lines[i].height;
+    }
+
+    SDL_Rect panel = {4, 4, width + 8, height + 8};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+    SDL_RenderFillRect(renderer, &panel);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    const SDL_Color white = {255, 255, 255, 255};
+    int y = panel.y + 4;
+    for (int i = 0; i <= PROF_STAGE_COUNT + 1; ++i) {
+        text_draw_label(&profiler->atlas, renderer, &profiler->lines[i], panel.x + 4, y, white);
+        y += profiler->lines[i].height;
+    }
+}
+
+/**
+ * @brief Frees the overlay's glyph atlas, e.g. after the render device was
+ * lost. It is made again the next time the overlay is drawn.
+ * @param profiler The profiler whose overlay to free.
+ */
+void profiler_release_overlay(Profiler* profiler) {
+    text_destroy_atlas(&profiler->atlas);
+}
+
+/**
+ * @brief Frees the overlay and font and closes the CSV log.
+ * @param profiler The profiler to destroy.
+ */
+void profiler_destroy(Profiler* profiler) {
+    profiler_release_overlay(profiler);
+    if (profiler->font != NULL) {
+        TTF_CloseFont(profiler->font);
+        profiler->font = NULL;
+    }
+    if (profiler->csv != NULL) {
+        fclose(profiler->csv);
+        profiler->csv = NULL;
+    }
+}
+
+/**
+ * @brief Lays out the overlay text from the current window statistics.
+ * @param profiler The profiler to refresh.
+ */
+static void refresh_overlay(Profiler* profiler) {
+    char text[TEXT_LABEL_CHARS + 1];
+    for (int i = 0; i <= PROF_STAGE_COUNT + 1; ++i) {
+        if (i == 0) {
+            snprintf(text, sizeof(text), "%-10s %7s %7s %7s", "ms", "min", "avg", "p99");
+        } else if (i == PROF_STAGE_COUNT + 1) {
+            rate_line(profiler, text, sizeof(text));
+        } else {
+            float min, avg, p99;
+            window_stats(profiler, i - 1, &min, &avg, &p99);
+            snprintf(text, sizeof(text), "%-10s %7.3f %7.3f %7.3f", STAGE_NAMES[i - 1], min, avg, p99);
+        }
+        text_layout(&profiler->atlas, text, &profiler->lines[i]);
+    }
+}
+
+/**
+ * @brief Formats the overlay's last line: frame rate, busy share and the
+ * power source (with the battery charge when running on battery).
+ */
+static void rate_line(const Profiler* profiler, char* text, size_t size) {
+    int seconds = -1;
+    int percent = -1;
+    char power[32];
+    switch (SDL_GetPowerInfo(&seconds, &percent)) {
+        case SDL_POWERSTATE_ON_BATTERY:
+            if (seconds >= 0) {
+                snprintf(power, sizeof(power), "battery %d%% %d:%02d", percent, seconds / 3600, seconds / 60 % 60);
+            } else {
+                snprintf(power, sizeof(power), "battery %d%%", percent);
+            }
+            break;
+        case SDL_POWERSTATE_CHARGING:
+            snprintf(power, sizeof(power), "charging %d%%", percent);
+            break;
+        case SDL_POWERSTATE_CHARGED:
+        case SDL_POWERSTATE_NO_BATTERY:
+            snprintf(power, sizeof(power), "mains");
+            break;
+        default:
+            snprintf(power, sizeof(power), "power unknown");
+            break;
+    }
+    snprintf(text, size, "fps %5.1f busy %3.0f%% %s", profiler->fps, profiler->busyPercent, power);
+}
+
+/**
+ * @brief Computes one stage's min, average and 99th percentile over the
+ * frames in the window.
+ * @param profiler The profiler to read.
+ * @param stage The stage to summarize.
+ * @param min Receives the shortest time (ms).
+ * @param avg Receives the mean time (ms).
+ * @param p99 Receives the 99th percentile time (ms).
+ */
+static void window_stats(const Profiler* profiler, int stage, float* min, float* avg, float* p99) {
+    int count = profiler->frames < PROFILE_WINDOW ? (int)profiler->frames : PROFILE_WINDOW;
+    if (count == 0) {
+        *min = *avg = *p99 = 0.0f;
+        return;
+    }
+
+    float sorted[PROFILE_WINDOW];
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i) {
+        sorted[i] = profiler->samples[stage][i];
+        sum += sorted[i];
+    }
+    qsort(sorted, count, sizeof(float), compare_floats);
+
+    *min = sorted[0];
+    *avg = (float)(sum / count);
+    *p99 = sorted[(count * 99 + 99) / 100 - 1];
+}
+
+/**
+ * @brief qsort() comparator for ascending floats.
+ */
+static int compare_floats(const void* a, const void* b) {
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+    return (x > y) - (x < y);
+}
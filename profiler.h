@@ -0,0 +1,74 @@
+// -----------------------------------------------------------------------------
+// Frame and physics profiler for the 8-Ball Pool Game
+//
+// Times each stage of a frame, shows min/avg/p99 over the last
+// PROFILE_WINDOW frames in a toggleable overlay and can log every frame to a
+// CSV file. Also tracks the frame rate, how much of the time the game loop
+// was busy rather than idle, and the machine's power source.
+// -----------------------------------------------------------------------------
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "physics.h"
+#include "text.h"
+
+#define PROFILE_WINDOW 240        // Frames the overlay statistics cover
+#define PROFILE_REFRESH_FRAMES 30 // Frames between overlay text updates
+#define PROFILE_FONT_SIZE 14
+#define PROFILE_RATE_SECONDS 1.0  // Span the frame rate and busy share cover
+
+// Timed stages of a frame. The physics stages follow PhysicsStage order.
+typedef enum {
+    PROF_INPUT,
+    PROF_INTEGRATE,
+    PROF_CUSHIONS,
+    PROF_BALLS,
+    PROF_POCKETS,
+    PROF_EVENTS,
+    PROF_TABLE,      // Table layer (or direct table drawing)
+    PROF_DRAW_BALLS,
+    PROF_CUE,        // Cue stick, game over screen and HUD text (and the batch with GEOMETRY_RENDER)
+    PROF_OVERLAY,    // This profiler's own overlay
+    PROF_PRESENT,    // Includes waiting for vsync
+    PROF_FRAME,      // The whole frame
+    PROF_STAGE_COUNT
+} ProfileStage;
+
+// Profiler state. Sample times are in milliseconds.
+typedef struct {
+    float samples[PROF_STAGE_COUNT][PROFILE_WINDOW]; // Ring of recent frames
+    uint64_t frameTicks[PROF_STAGE_COUNT];           // The frame in progress
+    uint64_t frames;       // Frames recorded so far
+    uint64_t idleTicks;    // Time spent idle since the last frame
+    double msPerTick;
+    uint64_t rateStart;    // Start of the current frame rate span
+    uint64_t rateFrames;   // Frames and idle time in that span
+    uint64_t rateIdleTicks;
+    float fps;             // Results of the last complete span
+    float busyPercent;     // Share of wall time not spent idle
+    FILE* csv;             // Per-frame log, or NULL
+    TTF_Font* font;        // Overlay font, or NULL if none could be opened
+    bool overlayVisible;
+    TextAtlas atlas;       // Overlay glyphs, created when first drawn
+    TextLabel lines[PROF_STAGE_COUNT + 2]; // Overlay text: header, stages, rates
+} Profiler;
+
+// --- Function Prototypes ---
+bool profiler_init(Profiler* profiler, const char* csvPath, const char* fontPath, SDL_RWops* fontData);
+uint64_t profiler_ticks();
+uint64_t profiler_lap(Profiler* profiler, ProfileStage stage, uint64_t start);
+void profiler_add_physics(Profiler* profiler, Table* table);
+void profiler_add_idle(Profiler* profiler, uint64_t ticks);
+void profiler_end_frame(Profiler* profiler, int steps);
+void profiler_toggle_overlay(Profiler* profiler);
+void profiler_draw_overlay(Profiler* profiler, SDL_Renderer* renderer);
+void profiler_release_overlay(Profiler* profiler);
+void profiler_destroy(Profiler* profiler);
+
+#endif
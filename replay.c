@@ -0,0 +1,328 @@
+// -----------------------------------------------------------------------------
+// Deterministic replay recording and playback for the 8-Ball Pool Game
+//
+// File format (all integers little-endian):
+//   header: "PRPL", u32 version, u32 physicsHz, u32 solver, u32 rackSeed,
+//           u32 event count, u32 variant
+//   event:  u8 type, u8 checked, u32 cue x bits, u32 cue y bits,
+//           u64 table hash
+// Playback judges every shot with the rules once it comes to rest, as the
+// game does, so balls the rules spot are where the game put them.
+// Floats are stored as their IEEE-754 bit patterns, so they round-trip
+// exactly.
+// -----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replay.h"
+#include "rules.h"
+
+#define REPLAY_HEADER_SIZE 28
+#define REPLAY_EVENT_SIZE 18
+
+// Events a recording has room for from the start; games rarely need more,
+// so recording one does not allocate while it is played
+#define REPLAY_RESERVED_EVENTS 1024
+
+// --- Function Prototypes ---
+static void put_u32(unsigned char* p, uint32_t v);
+static void put_u64(unsigned char* p, uint64_t v);
+static uint32_t get_u32(const unsigned char* p);
+static uint64_t get_u64(const unsigned char* p);
+static uint32_t float_bits(float f);
+static float bits_float(uint32_t bits);
+static int play_to_rest(Table* table);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Starts an empty replay of a game played on the given table, with
+ * room for REPLAY_RESERVED_EVENTS events.
+ * @param replay The replay to initialize.
+ * @param table The table the game is played on; its physics rate, solver,
+ * variant and rack seed are recorded.
+ */
+void replay_init(Replay* replay, const Table* table) {
+    replay->physicsHz = table->physicsHz;
+    replay->solver = table->solver;
+    replay->variant = table->variant;
+    replay->rackSeed = table->rackSeed;
+    replay->count = 0;
+    replay->events = malloc(REPLAY_RESERVED_EVENTS * sizeof(ReplayEvent));
+    replay->capacity = replay->events != NULL ? REPLAY_RESERVED_EVENTS : 0;
+}
+
+/**
+ * @brief Appends an event, growing the replay if its reserve is used up.
+ * Call it just before the input is applied.
+ * @param replay The replay to add to.
+ * @param type The kind of event.
+ * @param cue The cue velocity (REPLAY_SHOT) or cue ball position
+ * (REPLAY_PLACE).
+ * @param before The table just before the event. Its hash is only
+ * reproducible, and so only checked on playback, if it is not simulating.
+ * @return false if out of memory.
+ */
+bool replay_record(Replay* replay, ReplayEventType type, Vec2D cue, const Table* before) {
+    if (replay->count == replay->capacity) {
+        int capacity = replay->capacity > 0 ? replay->capacity * 2 : 64;
+        ReplayEvent* events = realloc(replay->events, capacity * sizeof(ReplayEvent));
+        if (events == NULL) {
+            return false;
+        }
+        replay->events = events;
+        replay->capacity = capacity;
+    }
+
+    ReplayEvent* event = &replay->events[replay->count++];
+    event->type = (uint8_t)type;
+    event->checked = before->state != STATE_SIMULATING;
+    event->cue = type == REPLAY_SHOT || type == REPLAY_PLACE ? cue : (Vec2D){0.0f, 0.0f};
+    event->tableHash = event->checked ? table_hash(before, TABLE_HASH_SEED) : 0;
+    return true;
+}
+
+/**
+ * @brief Writes a replay file.
+ * @param replay The replay to write.
+ * @param path The file to create.
+ * @return true on success.
+ */
+bool replay_save(const Replay* replay, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Could not create replay file '%s'!\n", path);
+        return false;
+    }
+
+    unsigned char header[REPLAY_HEADER_SIZE];
+    memcpy(header, REPLAY_MAGIC, 4);
+    put_u32(header + 4, REPLAY_VERSION);
+    put_u32(header + 8, (uint32_t)replay->physicsHz);
+    put_u32(header + 12, (uint32_t)replay->solver);
+    put_u32(header + 16, replay->rackSeed);
+    put_u32(header + 20, (uint32_t)replay->count);
+    put_u32(header + 24, (uint32_t)replay->variant);
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+
+    for (int i = 0; i < replay->count && ok; ++i) {
+        const ReplayEvent* event = &replay->events[i];
+        unsigned char record[REPLAY_EVENT_SIZE];
+        record[0] = event->type;
+        record[1] = event->checked ? 1 : 0;
+        put_u32(record + 2, float_bits(event->cue.x));
+        put_u32(record + 6, float_bits(event->cue.y));
+        put_u64(record + 10, event->tableHash);
+        ok = fwrite(record, sizeof(record), 1, file) == 1;
+    }
+
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+        printf("Could not write replay file '%s'!\n", path);
+    }
+    return ok;
+}
+
+/**
+ * @brief Reads a replay file.
+ * @param replay Receives the replay; free it with replay_free().
+ * @param path The file to read.
+ * @return false if the file is missing, truncated or not a replay.
+ */
+bool replay_load(Replay* replay, const char* path) {
+    memset(replay, 0, sizeof(*replay));
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Could not open replay file '%s'!\n", path);
+        return false;
+    }
+
+    unsigned char header[REPLAY_HEADER_SIZE];
+    if (fread(header, sizeof(header), 1, file) != 1 || memcmp(header, REPLAY_MAGIC, 4) != 0 ||
+        get_u32(header + 4) != REPLAY_VERSION) {
+        printf("'%s' is not a version %d replay file!\n", path, REPLAY_VERSION);
+        fclose(file);
+        return false;
+    }
+    replay->physicsHz = (int)get_u32(header + 8);
+    replay->solver = (Solver)get_u32(header + 12);
+    replay->rackSeed = get_u32(header + 16);
+    uint32_t count = get_u32(header + 20);
+    uint32_t variant = get_u32(header + 24);
+    if (variant >= VARIANT_COUNT) {
+        printf("Replay file '%s' is for an unknown table variant!\n", path);
+        fclose(file);
+        return false;
+    }
+    replay->variant = (TableVariant)variant;
+
+    replay->events = count > 0 ? malloc(count * sizeof(ReplayEvent)) : NULL;
+    if (count > 0 && replay->events == NULL) {
+        printf("Out of memory!\n");
+        fclose(file);
+        return false;
+    }
+    replay->capacity = (int)count;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        unsigned char record[REPLAY_EVENT_SIZE];
+        if (fread(record, sizeof(record), 1, file) != 1) {
+            printf("Replay file '%s' is truncated!\n", path);
+            replay_free(replay);
+            fclose(file);
+            return false;
+        }
+        ReplayEvent* event = &replay->events[replay->count++];
+        event->type = record[0];
+        event->checked = record[1] != 0;
+        event->cue = (Vec2D){bits_float(get_u32(record + 2)), bits_float(get_u32(record + 6))};
+        event->tableHash = get_u64(record + 10);
+    }
+
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Frees a replay's events.
+ * @param replay The replay to free.
+ */
+void replay_free(Replay* replay) {
+    free(replay->events);
+    replay->events = NULL;
+    replay->count = 0;
+    replay->capacity = 0;
+}
+
+/**
+ * @brief Plays a replay file back without a window and checks that every
+ * recorded table hash is reproduced. Prints one line per event.
+ * @param path The replay file.
+ * @return 0 if the replay reproduced the game, 1 otherwise (suitable as a
+ * process exit code).
+ */
+int run_replay(const char* path) {
+    Replay replay;
+    if (!replay_load(&replay, path)) {
+        return 1;
+    }
+
+    Table table;
+    init_table(&table, replay.physicsHz);
+    table.solver = replay.solver;
+    table.variant = replay.variant;
+    table.rackSeed = replay.rackSeed;
+    setup_table(&table);
+    Match match;
+    rules_start(&match, 0);
+
+    int checked = 0;
+    int status = 0;
+    for (int i = 0; i < replay.count && status == 0; ++i) {
+        const ReplayEvent* event = &replay.events[i];
+        if (event->checked) {
+            if (table_hash(&table, TABLE_HASH_SEED) != event->tableHash) {
+                printf("event %d: table differs from the recording\n", i + 1);
+                status = 1;
+                break;
+            }
+            checked++;
+        }
+
+        switch (event->type) {
+            case REPLAY_SHOT:
+                if (!strike_cue_ball(&table, event->cue)) {
+                    printf("event %d: shot not allowed\n", i + 1);
+                    status = 1;
+                    break;
+                }
+                printf("event %d shot %.9g %.9g steps %d", i + 1, event->cue.x, event->cue.y,
+                       play_to_rest(&table));
+                if (table.state == STATE_AIMING) {
+                    ShotVerdict verdict = rules_end_shot(&match, &table);
+                    printf(" foul %s%s", foul_name(verdict.foul), verdict.gameOver ? " game over" : "");
+                }
+                printf("\n");
+                break;
+            case REPLAY_PLACE:
+                if (!rules_place_cue_ball(&match, &table, event->cue)) {
+                    printf("event %d: cue ball placement not allowed\n", i + 1);
+                    status = 1;
+                    break;
+                }
+                printf("event %d place %.9g %.9g\n", i + 1, event->cue.x, event->cue.y);
+                break;
+            case REPLAY_RESET:
+                // A reset may interrupt a shot; finishing it first changes nothing
+                play_to_rest(&table);
+                setup_table(&table);
+                rules_start(&match, 0);
+                printf("event %d reset\n", i + 1);
+                break;
+            case REPLAY_END:
+                printf("event %d end\n", i + 1);
+                break;
+            default:
+                printf("event %d: unknown event type %d\n", i + 1, event->type);
+                status = 1;
+                break;
+        }
+    }
+
+    if (status == 0) {
+        printf("replay ok: %d events, %d table hashes matched\n", replay.count, checked);
+    }
+    replay_free(&replay);
+    return status;
+}
+
+/**
+ * @brief Steps a table with update() until it stops simulating, exactly as
+ * the game loop does. (simulate_to_rest() resolves SOLVER_EVENTS shots in a
+ * single call, which rounds differently.) Gives up after MAX_SHOT_SECONDS.
+ * @param table The table to step.
+ * @return The number of physics steps simulated.
+ */
+static int play_to_rest(Table* table) {
+    const int maxSteps = MAX_SHOT_SECONDS * table->physicsHz;
+    int steps = 0;
+    while (table->state == STATE_SIMULATING && steps < maxSteps) {
+        update(table);
+        steps++;
+    }
+    return steps;
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void put_u64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t get_u64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint32_t float_bits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
@@ -0,0 +1,57 @@
+// -----------------------------------------------------------------------------
+// Deterministic replay recording and playback for the 8-Ball Pool Game
+//
+// A replay stores only the inputs of a game: its physics settings, the table
+// variant and rack seed, every shot's cue velocity and where the cue ball
+// was placed with ball in hand (plus table resets). The fixed-step physics
+// and the rules are deterministic, so replaying the inputs reproduces the
+// game bit for bit. Each event also stores a hash of the table just before
+// it, which playback checks.
+// -----------------------------------------------------------------------------
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "physics.h"
+
+#define REPLAY_MAGIC "PRPL"
+#define REPLAY_VERSION 4
+
+// Kinds of replay events
+typedef enum {
+    REPLAY_SHOT = 1,  // The cue ball was struck
+    REPLAY_RESET = 2, // The table was set up again
+    REPLAY_END = 3,   // Recording stopped
+    REPLAY_PLACE = 4  // The cue ball was placed with ball in hand
+} ReplayEventType;
+
+// One recorded input
+typedef struct {
+    uint8_t type;    // ReplayEventType
+    bool checked;    // tableHash is valid (the table was at rest)
+    Vec2D cue;       // Cue velocity of a REPLAY_SHOT, position of a REPLAY_PLACE
+    uint64_t tableHash; // table_hash() of the table just before the event
+} ReplayEvent;
+
+// A game's settings and inputs
+typedef struct {
+    int physicsHz;
+    Solver solver;
+    TableVariant variant;
+    uint32_t rackSeed;
+    int count;
+    int capacity;
+    ReplayEvent* events;
+} Replay;
+
+// --- Function Prototypes ---
+void replay_init(Replay* replay, const Table* table);
+bool replay_record(Replay* replay, ReplayEventType type, Vec2D cue, const Table* before);
+bool replay_save(const Replay* replay, const char* path);
+bool replay_load(Replay* replay, const char* path);
+void replay_free(Replay* replay);
+int run_replay(const char* path);
+
+#endif
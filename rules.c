@@ -0,0 +1,350 @@
+// -----------------------------------------------------------------------------
+// 8-ball rules for the 8-Ball Pool Game
+//
+// The rules follow WPA 8-ball with a few simplifications:
+// - Any break is legal, and the table stays open after it. An 8-ball
+//   pocketed on the break is spotted again.
+// - On an open table the group of the first object ball pocketed by a legal
+//   shot becomes the shooter's.
+// - The cue ball must touch a ball of the shooter's group first (any object
+//   ball but the 8 on an open table, the 8 once the group is cleared), and
+//   afterwards a ball must drop or reach a cushion. Anything else, or a
+//   scratch, is a foul and gives the opponent ball in hand.
+// - The 8-ball wins if it drops on a legal shot after the shooter's group
+//   was cleared, and loses otherwise.
+// 9-ball keeps the fouls, with the lowest-numbered ball on the table as the
+// one to hit first, on the break too. The 9 wins if it drops on a legal
+// shot, the break included, and is spotted again after a foul.
+// Snooker and the practice table are free play: any ball may be hit first,
+// every object ball pocketed keeps the turn and colours are not spotted
+// again. Whoever clears the table with a legal shot wins.
+// A scratched cue ball comes back on the head spot (TableGeometry.headSpotX),
+// from where the incoming player may move it while they have ball in hand.
+// -----------------------------------------------------------------------------
+
+#include <math.h>
+#include "rules.h"
+
+#define PLACE_UNITS 16 // Placed balls snap to 1/16 table unit
+
+// --- Function Prototypes ---
+static BallMask targets_on(TableVariant variant, BallMask onTable, BallGroup group);
+static Vec2D snap_position(Vec2D pos);
+static bool spot_free(const Table* table, int ball, Vec2D pos);
+static void spot_ball(Table* table, int ball, float x, float direction);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Starts a new game: an open table with the break to come.
+ * @param match The match to start.
+ * @param breaker The player who breaks.
+ */
+void rules_start(Match* match, int breaker) {
+    match->turn = breaker;
+    match->group[0] = GROUP_OPEN;
+    match->group[1] = GROUP_OPEN;
+    match->breakShot = true;
+    match->ballInHand = false;
+    match->winner = -1;
+}
+
+/**
+ * @brief Returns the balls of a group (none for GROUP_OPEN).
+ */
+BallMask group_mask(BallGroup group) {
+    switch (group) {
+        case GROUP_SOLIDS:
+            return SOLIDS_MASK;
+        case GROUP_STRIPES:
+            return STRIPES_MASK;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Returns the group an object ball belongs to, GROUP_OPEN for the
+ * cue ball and the 8-ball.
+ */
+BallGroup ball_group(int ball) {
+    BallMask bit = (BallMask)1 << ball;
+    if (bit & SOLIDS_MASK) return GROUP_SOLIDS;
+    if (bit & STRIPES_MASK) return GROUP_STRIPES;
+    return GROUP_OPEN;
+}
+
+/**
+ * @brief Returns the balls on a table that a player of a group may hit
+ * first.
+ * @param table The table, waiting for a shot.
+ * @param group The player's group.
+ */
+BallMask rules_targets(const Table* table, BallGroup group) {
+    return targets_on(table->variant, table->active, group);
+}
+
+/**
+ * @brief Judges the shot just played on a table from its recorded events,
+ * for the player whose turn it was. Changes nothing.
+ * @param match The match before the shot.
+ * @param table The table after the shot.
+ * @return The verdict.
+ */
+ShotVerdict rules_judge(const Match* match, const Table* table) {
+    const ShotEvents* shot = &table->shot;
+    const bool eightBall = table->variant == VARIANT_EIGHT_BALL;
+    const bool nineBall = table->variant == VARIANT_NINE_BALL;
+    ShotVerdict verdict = {FOUL_NONE, false, match->group[match->turn], 0, 0, false, false, -1};
+
+    BallGroup own = verdict.group;
+    BallMask before = table->active | shot->pocketed; // The table as the shot found it
+    BallMask targets = targets_on(table->variant, before, own);
+    bool onEight = eightBall && own != GROUP_OPEN && (before & group_mask(own)) == 0;
+
+    if (shot->pocketed & CUE_BALL_MASK) {
+        verdict.foul = FOUL_SCRATCH;
+    } else if (shot->firstContact < 0) {
+        verdict.foul = FOUL_NO_CONTACT;
+    } else if (!match->breakShot || nineBall) {
+        BallMask first = (BallMask)1 << shot->firstContact;
+        if ((first & targets) == 0) {
+            verdict.foul = FOUL_WRONG_BALL;
+        } else if (!match->breakShot && (shot->pocketed & ~CUE_BALL_MASK) == 0 && shot->cushioned == 0) {
+            verdict.foul = FOUL_NO_CUSHION;
+        }
+    }
+
+    // A legal shot on an open table takes the group of its first ball down
+    if (eightBall && own == GROUP_OPEN && !match->breakShot && verdict.foul == FOUL_NONE &&
+        shot->firstPocketed >= 0) {
+        verdict.group = ball_group(shot->firstPocketed);
+    }
+
+    BallMask ownMask = ~CUE_BALL_MASK; // Every object ball outside 8-ball
+    if (eightBall) {
+        ownMask = verdict.group == GROUP_OPEN ? SOLIDS_MASK | STRIPES_MASK : group_mask(verdict.group);
+    }
+    BallMask otherMask = eightBall ? (SOLIDS_MASK | STRIPES_MASK) & ~ownMask : 0;
+    verdict.ownPocketed = ball_count(shot->pocketed & ownMask);
+    verdict.otherPocketed = ball_count(shot->pocketed & otherMask);
+
+    if (eightBall && (shot->pocketed & EIGHT_BALL_MASK)) {
+        if (match->breakShot) {
+            verdict.spotBall = 8;
+        } else {
+            verdict.gameOver = true;
+            verdict.won = verdict.foul == FOUL_NONE && onEight;
+        }
+    } else if (nineBall && (shot->pocketed & NINE_BALL_MASK)) {
+        if (verdict.foul != FOUL_NONE) {
+            verdict.spotBall = 9;
+        } else {
+            verdict.gameOver = true;
+            verdict.won = true;
+        }
+    } else if (!eightBall && !nineBall && (table->active & ~CUE_BALL_MASK) == 0) {
+        verdict.gameOver = true;
+        verdict.won = verdict.foul == FOUL_NONE;
+    }
+    verdict.keepsTurn = !verdict.gameOver && verdict.foul == FOUL_NONE && verdict.ownPocketed > 0;
+    return verdict;
+}
+
+/**
+ * @brief Judges the shot just played and applies the verdict: assigns the
+ * groups, passes the turn, gives ball in hand, spots a scratched cue ball
+ * or an object ball that goes back (ShotVerdict.spotBall) and ends the game
+ * (STATE_GAME_OVER).
+ * Call it once each time a shot comes to rest.
+ * @param match The match to update.
+ * @param table The table after the shot; balls may be spotted on it.
+ * @return The verdict.
+ */
+ShotVerdict rules_end_shot(Match* match, Table* table) {
+    ShotVerdict verdict = rules_judge(match, table);
+    int shooter = match->turn;
+    int opponent = 1 - shooter;
+
+    if (match->group[shooter] == GROUP_OPEN && verdict.group != GROUP_OPEN) {
+        match->group[shooter] = verdict.group;
+        match->group[opponent] = verdict.group == GROUP_SOLIDS ? GROUP_STRIPES : GROUP_SOLIDS;
+    }
+    match->breakShot = false;
+
+    if (verdict.gameOver) {
+        match->winner = verdict.won ? shooter : opponent;
+        match->ballInHand = false;
+        table->state = STATE_GAME_OVER;
+        return verdict;
+    }
+
+    if (verdict.spotBall >= 0) {
+        spot_ball(table, verdict.spotBall, table->geometry.footSpotX, 1.0f);
+    }
+    if (verdict.foul == FOUL_SCRATCH) {
+        spot_ball(table, 0, table->geometry.headSpotX, -1.0f);
+    }
+    match->ballInHand = verdict.foul != FOUL_NONE;
+    if (!verdict.keepsTurn) {
+        match->turn = opponent;
+    }
+    return verdict;
+}
+
+/**
+ * @brief Returns true if the player to shoot may put the cue ball at a
+ * position: they have ball in hand and it fits there (on the felt, off the
+ * pockets and clear of the other balls). Non-finite positions never fit.
+ * @param match The match.
+ * @param table The table, waiting for a shot.
+ * @param pos The position, before snapping (see rules_place_cue_ball()).
+ */
+bool rules_can_place_cue_ball(const Match* match, const Table* table, Vec2D pos) {
+    if (!match->ballInHand || match->winner >= 0 || table->state != STATE_AIMING) {
+        return false;
+    }
+    return spot_free(table, 0, snap_position(pos));
+}
+
+/**
+ * @brief Moves the cue ball to where the player with ball in hand put it.
+ * The position snaps to 1/PLACE_UNITS table unit, so it is exact in every
+ * physics backend.
+ * @param match The match.
+ * @param table The table, waiting for a shot.
+ * @param pos The new cue ball position.
+ * @return false, changing nothing, if rules_can_place_cue_ball() does not
+ * allow the placement.
+ */
+bool rules_place_cue_ball(const Match* match, Table* table, Vec2D pos) {
+    if (!rules_can_place_cue_ball(match, table, pos)) {
+        return false;
+    }
+    pos = snap_position(pos);
+    table->px[0] = pos.x;
+    table->py[0] = pos.y;
+    table->vx[0] = 0.0f;
+    table->vy[0] = 0.0f;
+    table->active |= CUE_BALL_MASK;
+    return true;
+}
+
+/**
+ * @brief Returns a foul's name for logs, e.g. "no_cushion".
+ */
+const char* foul_name(Foul foul) {
+    switch (foul) {
+        case FOUL_SCRATCH:
+            return "scratch";
+        case FOUL_NO_CONTACT:
+            return "no_contact";
+        case FOUL_WRONG_BALL:
+            return "wrong_ball";
+        case FOUL_NO_CUSHION:
+            return "no_cushion";
+        default:
+            return "none";
+    }
+}
+
+/**
+ * @brief Returns a group's name, e.g. "solids".
+ */
+const char* group_name(BallGroup group) {
+    switch (group) {
+        case GROUP_SOLIDS:
+            return "solids";
+        case GROUP_STRIPES:
+            return "stripes";
+        default:
+            return "open";
+    }
+}
+
+/**
+ * @brief Returns the object balls of a mask that a player of a group may
+ * hit first in a variant: their group, or the 8 once it is cleared, in
+ * 8-ball; the lowest-numbered ball in 9-ball; any ball in free play.
+ */
+static BallMask targets_on(TableVariant variant, BallMask onTable, BallGroup group) {
+    BallMask objects = onTable & ~CUE_BALL_MASK;
+    switch (variant) {
+        case VARIANT_EIGHT_BALL: {
+            BallMask targets = objects & (group == GROUP_OPEN ? SOLIDS_MASK | STRIPES_MASK : group_mask(group));
+            return targets != 0 ? targets : objects & EIGHT_BALL_MASK;
+        }
+        case VARIANT_NINE_BALL:
+            return objects & (~objects + 1); // The lowest set bit
+        default:
+            return objects;
+    }
+}
+
+/**
+ * @brief Rounds a placed position to whole 1/PLACE_UNITS table units.
+ */
+static Vec2D snap_position(Vec2D pos) {
+    return (Vec2D){roundf(pos.x * PLACE_UNITS) / PLACE_UNITS, roundf(pos.y * PLACE_UNITS) / PLACE_UNITS};
+}
+
+/**
+ * @brief Returns true if a ball can be put at a position: inside the
+ * cushions, out of every pocket and clear of the other balls on the table.
+ * The bounds test is written so a NaN position fails it, as every test
+ * after it would pass one.
+ */
+static bool spot_free(const Table* table, int ball, Vec2D pos) {
+    const TableGeometry* geo = &table->geometry;
+    if (!(pos.x >= geo->cushionX1 && pos.x <= geo->cushionX2 && pos.y >= geo->cushionY1 && pos.y <= geo->cushionY2)) {
+        return false;
+    }
+    for (int p = 0; p < NUM_POCKETS; ++p) {
+        float dx = geo->pockets[p].pos.x - pos.x;
+        float dy = geo->pockets[p].pos.y - pos.y;
+        if (dx * dx + dy * dy < geo->pocketRadiusSq[p]) {
+            return false;
+        }
+    }
+    const float diameter = 2.0f * geo->ballRadius;
+    for (BallMask left = table->active & ~((BallMask)1 << ball); left != 0; left &= left - 1) {
+        int i = lowest_ball(left);
+        float dx = table->px[i] - pos.x;
+        float dy = table->py[i] - pos.y;
+        if (dx * dx + dy * dy < diameter * diameter) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Puts a ball back on the table's long axis at x or, if that spot is
+ * taken, at the nearest free spot along the axis.
+ * @param table The table.
+ * @param ball The ball to spot.
+ * @param x The spot.
+ * @param direction Where to look first between two spots equally near: 1
+ * towards the foot cushion, -1 towards the head cushion.
+ */
+static void spot_ball(Table* table, int ball, float x, float direction) {
+    Vec2D pos = {x, TABLE_HEIGHT / 2.0f};
+    for (float offset = 0.0f; offset < TABLE_WIDTH; offset += 1.0f) {
+        Vec2D ahead = {x + direction * offset, pos.y};
+        Vec2D behind = {x - direction * offset, pos.y};
+        if (spot_free(table, ball, ahead)) {
+            pos = ahead;
+            break;
+        }
+        if (spot_free(table, ball, behind)) {
+            pos = behind;
+            break;
+        }
+    }
+    table->px[ball] = pos.x;
+    table->py[ball] = pos.y;
+    table->vx[ball] = 0.0f;
+    table->vy[ball] = 0.0f;
+    table->active |= (BallMask)1 << ball;
+}
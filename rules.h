@@ -0,0 +1,81 @@
+// -----------------------------------------------------------------------------
+// 8-ball rules for the 8-Ball Pool Game
+//
+// A match tracks whose turn it is, which group (solids or stripes) each
+// player has, ball in hand and the winner. Each shot is judged from the
+// events the physics recorded while it ran (Table.shot): the ball the cue
+// ball touched first, the balls that reached a cushion after that and the
+// balls that dropped, in order. Nothing rescans the table, so judging a
+// shot costs the same whatever the layout, and a cached shot outcome is
+// judged as cheaply as a simulated one.
+//
+// 8-ball is played by its rules, 9-ball by 9-ball rules and the other
+// variants as free play (see rules.c).
+//
+// This module has no SDL dependency; the game, replays and the computer
+// player all judge shots with it.
+// -----------------------------------------------------------------------------
+
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdbool.h>
+#include "physics.h"
+
+#define CUE_BALL_MASK ((BallMask)1)
+#define EIGHT_BALL_MASK ((BallMask)1 << 8)
+#define SOLIDS_MASK ((BallMask)0x00fe)  // Balls 1-7
+#define STRIPES_MASK ((BallMask)0xfe00) // Balls 9-15
+#define NINE_BALL_MASK ((BallMask)1 << 9)
+
+// A player's group of object balls in 8-ball; always open in the other
+// variants
+typedef enum {
+    GROUP_OPEN,    // Not decided yet
+    GROUP_SOLIDS,
+    GROUP_STRIPES
+} BallGroup;
+
+// Why a shot was a foul
+typedef enum {
+    FOUL_NONE,
+    FOUL_SCRATCH,    // The cue ball was pocketed
+    FOUL_NO_CONTACT, // The cue ball touched no ball
+    FOUL_WRONG_BALL, // The cue ball touched a ball it may not hit first (see rules_targets())
+    FOUL_NO_CUSHION  // Nothing dropped and no ball reached a cushion after the contact
+} Foul;
+
+// The state of a game between two players, 0 and 1
+typedef struct {
+    int turn;           // Player to shoot
+    BallGroup group[2]; // Each player's group
+    bool breakShot;     // The next shot is the break
+    bool ballInHand;    // The shooter may place the cue ball anywhere
+    int winner;         // Player who won, or -1 while the game goes on
+} Match;
+
+// The judgment of one shot, for the player who took it
+typedef struct {
+    Foul foul;
+    bool keepsTurn;      // The shooter shoots again
+    BallGroup group;     // The shooter's group after the shot
+    int ownPocketed;     // Balls of the shooter's group pocketed (any object ball on an open table)
+    int otherPocketed;   // Balls of the opponent's group pocketed
+    bool gameOver;
+    bool won;            // The shooter won (if gameOver)
+    int spotBall;        // Object ball that goes back on the foot spot, or -1
+} ShotVerdict;
+
+// --- Function Prototypes ---
+void rules_start(Match* match, int breaker);
+BallMask group_mask(BallGroup group);
+BallGroup ball_group(int ball);
+BallMask rules_targets(const Table* table, BallGroup group);
+ShotVerdict rules_judge(const Match* match, const Table* table);
+ShotVerdict rules_end_shot(Match* match, Table* table);
+bool rules_can_place_cue_ball(const Match* match, const Table* table, Vec2D pos);
+bool rules_place_cue_ball(const Match* match, Table* table, Vec2D pos);
+const char* foul_name(Foul foul);
+const char* group_name(BallGroup group);
+
+#endif
@@ -0,0 +1,318 @@
+// -----------------------------------------------------------------------------
+// Shot-outcome cache for the 8-Ball Pool Game
+//
+// A fixed array of entries sized from the memory cap, a power-of-two bucket
+// array of chained entry indices for lookup, and a doubly linked recency
+// list whose tail is evicted when the array is full. Indices instead of
+// pointers keep entries small.
+// -----------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "shotcache.h"
+
+#define NO_ENTRY (-1)
+
+typedef struct {
+    ShotKey key;
+    ShotOutcome outcome;
+    uint64_t hash;
+    int32_t nextInBucket;
+    int32_t newer; // Recency list neighbours
+    int32_t older;
+} CacheEntry;
+
+struct ShotCache {
+    CacheEntry* entries;
+    int32_t* buckets;
+    uint64_t bucketMask;
+    int capacity;
+    int count;
+    int32_t newest;
+    int32_t oldest;
+    ShotCacheStats stats;
+};
+
+// --- Function Prototypes ---
+static uint64_t hash_key(const ShotKey* key);
+static int32_t find_entry(const ShotCache* cache, const ShotKey* key, uint64_t hash);
+static void unlink_recency(ShotCache* cache, int32_t index);
+static void push_newest(ShotCache* cache, int32_t index);
+static void remove_from_bucket(ShotCache* cache, int32_t index);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Creates an empty cache.
+ * @param maxBytes Memory cap for entries and buckets together.
+ * @return The cache, or NULL if out of memory or the cap fits no entries.
+ */
+ShotCache* shotcache_create(size_t maxBytes) {
+    // Each entry also needs about one bucket (two, rounded up to a power)
+    size_t perEntry = sizeof(CacheEntry) + 2 * sizeof(int32_t);
+    size_t capacity = maxBytes / perEntry;
+    if (capacity > INT32_MAX / 2) capacity = INT32_MAX / 2;
+    if (capacity == 0) {
+        return NULL;
+    }
+    size_t buckets = 1;
+    while (buckets < capacity) buckets <<= 1;
+
+    ShotCache* cache = calloc(1, sizeof(ShotCache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->entries = malloc(capacity * sizeof(CacheEntry));
+    cache->buckets = malloc(buckets * sizeof(int32_t));
+    if (cache->entries == NULL || cache->buckets == NULL) {
+        shotcache_destroy(cache);
+        return NULL;
+    }
+    for (size_t i = 0; i < buckets; ++i) {
+        cache->buckets[i] = NO_ENTRY;
+    }
+    cache->bucketMask = buckets - 1;
+    cache->capacity = (int)capacity;
+    cache->newest = NO_ENTRY;
+    cache->oldest = NO_ENTRY;
+    cache->stats.capacity = (int)capacity;
+    return cache;
+}
+
+/**
+ * @brief Builds the key for playing a cue velocity on a table: its
+ * quantized ball layout, the quantized cue velocity and the physics
+ * settings that affect the outcome.
+ * @param key Receives the key.
+ * @param table The table the shot is played from.
+ * @param cue The cue ball's velocity.
+ */
+void shotcache_make_key(ShotKey* key, const Table* table, Vec2D cue) {
+    memset(key, 0, sizeof(*key)); // Keys are hashed and compared as bytes
+    for (int i = 0; i < table->ballCount; ++i) {
+        if (!ball_active(table, i)) continue;
+        key->pos[i][0] = (int32_t)lrintf(table->px[i] * SHOTCACHE_POS_UNITS);
+        key->pos[i][1] = (int32_t)lrintf(table->py[i] * SHOTCACHE_POS_UNITS);
+    }
+    key->cue[0] = (int32_t)lrintf(cue.x * SHOTCACHE_CUE_UNITS);
+    key->cue[1] = (int32_t)lrintf(cue.y * SHOTCACHE_CUE_UNITS);
+    key->active = (uint32_t)table->active;
+    key->variant = (int32_t)table->variant;
+    key->physicsHz = table->physicsHz;
+    key->solver = (int32_t)table->solver;
+    key->fastForward = table->fastForward ? 1 : 0;
+}
+
+/**
+ * @brief Looks a shot up and marks it most recently used. Counts a hit or
+ * a miss.
+ * @param cache The cache.
+ * @param key The shot.
+ * @param outcome Receives the cached outcome on a hit.
+ * @return true on a hit.
+ */
+bool shotcache_lookup(ShotCache* cache, const ShotKey* key, ShotOutcome* outcome) {
+    int32_t index = find_entry(cache, key, hash_key(key));
+    if (index == NO_ENTRY) {
+        cache->stats.misses++;
+        return false;
+    }
+    cache->stats.hits++;
+    unlink_recency(cache, index);
+    push_newest(cache, index);
+    *outcome = cache->entries[index].outcome;
+    return true;
+}
+
+/**
+ * @brief Adds (or replaces) a shot's outcome, evicting the least recently
+ * used entry if the cache is full.
+ * @param cache The cache.
+ * @param key The shot.
+ * @param outcome What it did.
+ */
+void shotcache_insert(ShotCache* cache, const ShotKey* key, const ShotOutcome* outcome) {
+    uint64_t hash = hash_key(key);
+    int32_t index = find_entry(cache, key, hash);
+    if (index != NO_ENTRY) {
+        cache->entries[index].outcome = *outcome;
+        unlink_recency(cache, index);
+        push_newest(cache, index);
+        return;
+    }
+
+    if (cache->count < cache->capacity) {
+        index = cache->count++;
+    } else {
+        index = cache->oldest;
+        unlink_recency(cache, index);
+        remove_from_bucket(cache, index);
+        cache->stats.evictions++;
+    }
+
+    CacheEntry* entry = &cache->entries[index];
+    entry->key = *key;
+    entry->outcome = *outcome;
+    entry->hash = hash;
+    entry->nextInBucket = cache->buckets[hash & cache->bucketMask];
+    cache->buckets[hash & cache->bucketMask] = index;
+    push_newest(cache, index);
+}
+
+/**
+ * @brief Captures a played shot's outcome.
+ * @param outcome Receives the outcome.
+ * @param table The table after the shot.
+ * @param steps The steps simulate_to_rest() returned.
+ */
+void shotcache_save_outcome(ShotOutcome* outcome, const Table* table, int steps) {
+    for (int i = 0; i < table->ballCount; ++i) {
+        outcome->px[i] = table->px[i];
+        outcome->py[i] = table->py[i];
+        outcome->vx[i] = table->vx[i];
+        outcome->vy[i] = table->vy[i];
+    }
+    outcome->active = table->active;
+    outcome->state = table->state;
+    outcome->shot = table->shot;
+    outcome->steps = steps;
+    outcome->stepCount = table->stepCount;
+    outcome->fastForwardSteps = table->fastForwardSteps;
+    outcome->eventCount = table->eventCount;
+    outcome->pairsTested = table->collisions.totalTested;
+    outcome->pairsCulled = table->collisions.totalCulled;
+}
+
+/**
+ * @brief Puts a table in a cached outcome's state, as if the shot had just
+ * been simulated on it.
+ * @param outcome The outcome.
+ * @param table The table the shot was played from; receives the outcome.
+ * @return The outcome's step count.
+ */
+int shotcache_load_outcome(const ShotOutcome* outcome, Table* table) {
+    for (int i = 0; i < table->ballCount; ++i) {
+        table->px[i] = outcome->px[i];
+        table->py[i] = outcome->py[i];
+        table->vx[i] = outcome->vx[i];
+        table->vy[i] = outcome->vy[i];
+    }
+    table->active = outcome->active;
+    table->state = outcome->state;
+    table->shot = outcome->shot;
+    table->stepCount = outcome->stepCount;
+    table->fastForwardSteps = outcome->fastForwardSteps;
+    table->eventCount = outcome->eventCount;
+    table->collisions.totalTested = outcome->pairsTested;
+    table->collisions.totalCulled = outcome->pairsCulled;
+    return outcome->steps;
+}
+
+/**
+ * @brief Plays a shot on a table through the cache: a hit skips the
+ * simulation entirely, a miss strikes the cue ball, simulates to rest and
+ * caches the outcome.
+ * @param cache The cache.
+ * @param table The table to play on (must be aiming).
+ * @param cue The cue ball's velocity.
+ * @return The number of physics steps (or events) the shot took.
+ */
+int shotcache_play(ShotCache* cache, Table* table, Vec2D cue) {
+    ShotKey key;
+    ShotOutcome outcome;
+    shotcache_make_key(&key, table, cue);
+    if (shotcache_lookup(cache, &key, &outcome)) {
+        return shotcache_load_outcome(&outcome, table);
+    }
+
+    strike_cue_ball(table, cue);
+    int steps = simulate_to_rest(table);
+    shotcache_save_outcome(&outcome, table, steps);
+    shotcache_insert(cache, &key, &outcome);
+    return steps;
+}
+
+/**
+ * @brief Returns the cache's counters.
+ */
+ShotCacheStats shotcache_stats(const ShotCache* cache) {
+    ShotCacheStats stats = cache->stats;
+    stats.entries = cache->count;
+    return stats;
+}
+
+/**
+ * @brief Frees a cache.
+ */
+void shotcache_destroy(ShotCache* cache) {
+    if (cache == NULL) {
+        return;
+    }
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+}
+
+/**
+ * @brief FNV-1a hash of a key's bytes.
+ */
+static uint64_t hash_key(const ShotKey* key) {
+    const unsigned char* bytes = (const unsigned char*)key;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < sizeof(*key); ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Returns the index of the entry for a key, or NO_ENTRY.
+ */
+static int32_t find_entry(const ShotCache* cache, const ShotKey* key, uint64_t hash) {
+    int32_t index = cache->buckets[hash & cache->bucketMask];
+    while (index != NO_ENTRY) {
+        const CacheEntry* entry = &cache->entries[index];
+        if (entry->hash == hash && memcmp(&entry->key, key, sizeof(*key)) == 0) {
+            return index;
+        }
+        index = entry->nextInBucket;
+    }
+    return NO_ENTRY;
+}
+
+/**
+ * @brief Takes an entry out of the recency list.
+ */
+static void unlink_recency(ShotCache* cache, int32_t index) {
+    CacheEntry* entry = &cache->entries[index];
+    if (entry->newer != NO_ENTRY) cache->entries[entry->newer].older = entry->older;
+    else cache->newest = entry->older;
+    if (entry->older != NO_ENTRY) cache->entries[entry->older].newer = entry->newer;
+    else cache->oldest = entry->newer;
+}
+
+/**
+ * @brief Puts an entry at the most recently used end of the list.
+ */
+static void push_newest(ShotCache* cache, int32_t index) {
+    CacheEntry* entry = &cache->entries[index];
+    entry->newer = NO_ENTRY;
+    entry->older = cache->newest;
+    if (cache->newest != NO_ENTRY) cache->entries[cache->newest].newer = index;
+    cache->newest = index;
+    if (cache->oldest == NO_ENTRY) cache->oldest = index;
+}
+
+/**
+ * @brief Unchains an entry from its hash bucket.
+ */
+static void remove_from_bucket(ShotCache* cache, int32_t index) {
+    int32_t* link = &cache->buckets[cache->entries[index].hash & cache->bucketMask];
+    while (*link != index) {
+        link = &cache->entries[*link].nextInBucket;
+    }
+    *link = cache->entries[index].nextInBucket;
+}
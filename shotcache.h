@@ -0,0 +1,76 @@
+// -----------------------------------------------------------------------------
+// Shot-outcome cache for the 8-Ball Pool Game
+//
+// Maps a quantized table layout and cue velocity to the outcome of playing
+// that shot, so nearly identical shots are only simulated once. Entries are
+// evicted least recently used first to stay within a memory cap. Not
+// thread-safe.
+// -----------------------------------------------------------------------------
+
+#ifndef SHOTCACHE_H
+#define SHOTCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "physics.h"
+
+// Key quanta: positions to 1/16 table unit, cue velocity to 1/256 unit per frame
+#define SHOTCACHE_POS_UNITS 16
+#define SHOTCACHE_CUE_UNITS 256
+
+// A quantized shot: the layout it is played from and the cue velocity.
+// Pocketed balls, and the slots past the variant's ball count, have zero
+// positions, so they do not split entries.
+typedef struct {
+    int32_t pos[MAX_BALLS][2];
+    int32_t cue[2];
+    uint32_t active;
+    int32_t variant;
+    int32_t physicsHz;
+    int32_t solver;
+    int32_t fastForward;
+} ShotKey;
+
+// What a shot did: the table it left (at rest unless the time limit was
+// hit), its events for the rules and how it got there
+typedef struct {
+    float px[MAX_BALLS];
+    float py[MAX_BALLS];
+    float vx[MAX_BALLS];
+    float vy[MAX_BALLS];
+    BallMask active;       // So the pocketed balls are the rest
+    GameState state;
+    ShotEvents shot;
+    int steps;             // As returned by simulate_to_rest()
+    uint64_t stepCount;
+    uint64_t fastForwardSteps;
+    uint64_t eventCount;
+    uint64_t pairsTested;
+    uint64_t pairsCulled;
+} ShotOutcome;
+
+// Cache counters
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    int entries;
+    int capacity; // Entries that fit in the memory cap
+} ShotCacheStats;
+
+// Opaque cache
+typedef struct ShotCache ShotCache;
+
+// --- Function Prototypes ---
+ShotCache* shotcache_create(size_t maxBytes);
+void shotcache_make_key(ShotKey* key, const Table* table, Vec2D cue);
+bool shotcache_lookup(ShotCache* cache, const ShotKey* key, ShotOutcome* outcome);
+void shotcache_insert(ShotCache* cache, const ShotKey* key, const ShotOutcome* outcome);
+void shotcache_save_outcome(ShotOutcome* outcome, const Table* table, int steps);
+int shotcache_load_outcome(const ShotOutcome* outcome, Table* table);
+int shotcache_play(ShotCache* cache, Table* table, Vec2D cue);
+ShotCacheStats shotcache_stats(const ShotCache* cache);
+void shotcache_destroy(ShotCache* cache);
+
+#endif
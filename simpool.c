@@ -0,0 +1,220 @@
+// -----------------------------------------------------------------------------
+// Multi-threaded batch shot simulator for the 8-Ball Pool Game
+//
+// Workers are created once and reused for every batch. A batch is split into
+// small chunks that idle workers claim from a shared atomic counter, so a few
+// long shots (many update() steps before the table comes to rest) only delay
+// the worker that owns them while the others keep draining the batch. The
+// calling thread works on the batch too. Results are written to their shot's
+// index, so they come back in input order.
+// -----------------------------------------------------------------------------
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "simpool.h"
+
+// Chunks per thread in a batch; more chunks balance better, fewer contend less
+#define CHUNKS_PER_THREAD 16
+
+// Upper bound on pool size
+#define MAX_THREADS 256
+
+// The batch currently being simulated
+typedef struct {
+    const Table* start;
+    const Vec2D* cues;
+    ShotResult* results;
+    int count;
+    int chunkSize;
+} Batch;
+
+struct SimPool {
+    pthread_t threads[MAX_THREADS];
+    int numThreads; // Including the calling thread
+
+    pthread_mutex_t lock;
+    pthread_cond_t workReady; // Signalled when a new batch is published
+    pthread_cond_t workDone;  // Signalled when the last worker finishes
+    unsigned generation;      // Incremented for every batch
+    int busyWorkers;          // Workers still running the current batch
+    bool shuttingDown;
+    Batch batch;
+
+    // Next unclaimed shot index, on its own cache line
+    _Alignas(64) atomic_int nextShot;
+};
+
+// --- Function Prototypes ---
+static void* worker_main(void* arg);
+static void run_chunks(SimPool* pool);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Returns the number of online CPU cores (at least 1).
+ */
+int cpu_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+/**
+ * @brief Creates a worker pool.
+ * @param numThreads Total threads to simulate with, including the caller of
+ * simpool_run(); 0 or less means one per CPU core.
+ * @return The pool, or NULL on failure.
+ */
+SimPool* simpool_create(int numThreads) {
+    if (numThreads <= 0) numThreads = cpu_count();
+    if (numThreads > MAX_THREADS) numThreads = MAX_THREADS;
+
+    SimPool* pool = calloc(1, sizeof(SimPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->workReady, NULL);
+    pthread_cond_init(&pool->workDone, NULL);
+    atomic_init(&pool->nextShot, 0);
+
+    // Thread 0 is the caller; spawn the rest
+    pool->numThreads = 1;
+    for (int i = 1; i < numThreads; ++i) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            break;
+        }
+        pool->numThreads++;
+    }
+    return pool;
+}
+
+/**
+ * @brief Returns the number of threads a pool simulates with.
+ */
+int simpool_thread_count(const SimPool* pool) {
+    return pool->numThreads;
+}
+
+/**
+ * @brief Plays every cue velocity in a batch on its own copy of the starting
+ * table and simulates each to rest. Blocks until the whole batch is done.
+ * @param pool The worker pool.
+ * @param start The table to play every shot from (must be aiming).
+ * @param cues The cue ball velocity of each shot.
+ * @param results Receives each shot's outcome, at the same index as its cue.
+ * @param count The number of shots.
+ */
+void simpool_run(SimPool* pool, const Table* start, const Vec2D* cues, ShotResult* results, int count) {
+    if (count <= 0) {
+        return;
+    }
+
+    int chunkSize = count / (pool->numThreads * CHUNKS_PER_THREAD);
+    if (chunkSize < 1) chunkSize = 1;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->batch = (Batch){start, cues, results, count, chunkSize};
+    atomic_store(&pool->nextShot, 0);
+    pool->busyWorkers = pool->numThreads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_chunks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busyWorkers > 0) {
+        pthread_cond_wait(&pool->workDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Stops all workers and frees the pool.
+ */
+void simpool_destroy(SimPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shuttingDown = true;
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->numThreads; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->workDone);
+    pthread_cond_destroy(&pool->workReady);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+/**
+ * @brief Worker thread body: waits for each new batch and helps run it.
+ */
+static void* worker_main(void* arg) {
+    SimPool* pool = arg;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shuttingDown && pool->generation == seen) {
+            pthread_cond_wait(&pool->workReady, &pool->lock);
+        }
+        if (pool->shuttingDown) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_chunks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busyWorkers == 0) {
+            pthread_cond_signal(&pool->workDone);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * @brief Claims chunks of the current batch until none are left.
+ */
+static void run_chunks(SimPool* pool) {
+    const Batch* batch = &pool->batch;
+    for (;;) {
+        int first = atomic_fetch_add_explicit(&pool->nextShot, batch->chunkSize, memory_order_relaxed);
+        if (first >= batch->count) {
+            return;
+        }
+        int last = first + batch->chunkSize;
+        if (last > batch->count) last = batch->count;
+
+        for (int i = first; i < last; ++i) {
+            ShotResult* result = &batch->results[i];
+            result->table = *batch->start;
+            strike_cue_ball(&result->table, batch->cues[i]);
+            result->steps = simulate_to_rest(&result->table);
+        }
+    }
+}
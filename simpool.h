@@ -0,0 +1,29 @@
+// -----------------------------------------------------------------------------
+// Multi-threaded batch shot simulator for the 8-Ball Pool Game
+//
+// A pool of worker threads that plays many candidate shots from the same
+// starting table, each on its own copy of that table.
+// -----------------------------------------------------------------------------
+
+#ifndef SIMPOOL_H
+#define SIMPOOL_H
+
+#include "physics.h"
+
+// Outcome of one simulated shot
+typedef struct {
+    Table table; // The table after the shot
+    int steps;   // Physics steps simulated
+} ShotResult;
+
+// Opaque worker pool
+typedef struct SimPool SimPool;
+
+// --- Function Prototypes ---
+int cpu_count();
+SimPool* simpool_create(int numThreads);
+int simpool_thread_count(const SimPool* pool);
+void simpool_run(SimPool* pool, const Table* start, const Vec2D* cues, ShotResult* results, int count);
+void simpool_destroy(SimPool* pool);
+
+#endif
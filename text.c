@@ -0,0 +1,210 @@
+// -----------------------------------------------------------------------------
+// Glyph atlas text for the 8-Ball Pool Game
+//
+// The atlas is white text on a transparent texture, packed in rows; the
+// color of a string is applied when drawing it. With GEOMETRY_RENDER a label
+// is drawn with one SDL_RenderGeometry() call. Without it every glyph is an
+// SDL_RenderCopy() from the same texture, which SDL's renderer batches into
+// one draw as well.
+// -----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include "text.h"
+
+// --- Function Prototypes ---
+static int glyph_index(char c);
+
+
+// --- Function Implementations ---
+
+/**
+ * @brief Rasterizes the printable ASCII glyphs of a font into one texture.
+ * @param atlas The atlas to fill.
+ * @param renderer The renderer the texture is for.
+ * @param font The font, at the size the atlas draws. Not kept.
+ * @return true on success.
+ */
+bool text_create_atlas(TextAtlas* atlas, SDL_Renderer* renderer, TTF_Font* font) {
+    memset(atlas, 0, sizeof(*atlas));
+    atlas->height = TTF_FontHeight(font);
+
+    // Render each glyph and place it in the next free spot of its row
+    SDL_Surface* glyphs[TEXT_GLYPHS] = {NULL};
+    const SDL_Color white = {255, 255, 255, 255};
+    int x = 0;
+    int y = 0;
+    int rowHeight = 0;
+    for (int i = 0; i < TEXT_GLYPHS; ++i) {
+        Uint16 c = (Uint16)(TEXT_FIRST_CHAR + i);
+        int advance = 0;
+        if (TTF_GlyphMetrics(font, c, NULL, NULL, NULL, NULL, &advance) == 0) {
+            atlas->advance[i] = advance;
+        }
+        glyphs[i] = TTF_RenderGlyph_Blended(font, c, white);
+        if (glyphs[i] == NULL) continue;
+
+        int w = glyphs[i]->w < TEXT_ATLAS_WIDTH ? glyphs[i]->w : TEXT_ATLAS_WIDTH;
+        if (x + w > TEXT_ATLAS_WIDTH) {
+            x = 0;
+            y += rowHeight + 1;
+            rowHeight = 0;
+        }
+        atlas->glyphs[i] = (SDL_Rect){x, y, w, glyphs[i]->h};
+        x += w + 1; // A pixel between glyphs keeps filtering from bleeding
+        if (glyphs[i]->h > rowHeight) rowHeight = glyphs[i]->h;
+    }
+
+    bool ok = false;
+    SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, TEXT_ATLAS_WIDTH, y + rowHeight, 32,
+                                                        SDL_PIXELFORMAT_RGBA32);
+    if (sheet != NULL) {
+        for (int i = 0; i < TEXT_GLYPHS; ++i) {
+            if (glyphs[i] == NULL) continue;
+            // Copy the coverage as it is instead of blending it onto nothing
+            SDL_SetSurfaceBlendMode(glyphs[i], SDL_BLENDMODE_NONE);
+            SDL_Rect dest = atlas->glyphs[i];
+            SDL_BlitSurface(glyphs[i], NULL, sheet, &dest);
+        }
+        atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+        SDL_FreeSurface(sheet);
+        if (atlas->texture != NULL) {
+            SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+            ok = true;
+        }
+    }
+    if (!ok) {
+        printf("Text atlas could not be created! SDL_Error: %s\n", SDL_GetError());
+    }
+
+    for (int i = 0; i < TEXT_GLYPHS; ++i) {
+        SDL_FreeSurface(glyphs[i]);
+    }
+    return ok;
+}
+
+/**
+ * @brief Frees an atlas's texture. Destroying an atlas that was never
+ * created does nothing.
+ * @param atlas The atlas to destroy.
+ */
+void text_destroy_atlas(TextAtlas* atlas) {
+    if (atlas->texture != NULL) {
+        SDL_DestroyTexture(atlas->texture);
+        atlas->texture = NULL;
+    }
+}
+
+/**
+ * @brief Lays out a line of text. Characters outside printable ASCII are
+ * drawn as '?', and text beyond TEXT_LABEL_CHARS is cut off.
+ * @param atlas The atlas the label will be drawn with.
+ * @param text The text.
+ * @param label Receives the layout. Left alone if it already holds the text.
+ * @return true if the label changed.
+ */
+bool text_layout(const TextAtlas* atlas, const char* text, TextLabel* label) {
+    if (label->height == atlas->height && strncmp(label->text, text, TEXT_LABEL_CHARS) == 0) {
+        return false;
+    }
+
+    int pen = 0;
+    int count = 0;
+    for (; text[count] != '\0' && count < TEXT_LABEL_CHARS; ++count) {
+        int glyph = glyph_index(text[count]);
+        label->glyph[count] = (uint8_t)glyph;
+        label->x[count] = (int16_t)pen;
+        label->text[count] = text[count];
+        pen += atlas->advance[glyph];
+    }
+    label->text[count] = '\0';
+    label->count = count;
+    label->width = pen;
+    label->height = atlas->height;
+    return true;
+}
+
+/**
+ * @brief Draws a laid out label.
+ * @param atlas The atlas the label was laid out with.
+ * @param renderer The renderer to draw with.
+ * @param label The label.
+ * @param x Left edge of the text in output pixels.
+ * @param y Top edge of the text.
+ * @param color The text color.
+ */
+void text_draw_label(const TextAtlas* atlas, SDL_Renderer* renderer, const TextLabel* label, int x, int y,
+                     SDL_Color color) {
+    if (atlas->texture == NULL || label->count == 0) {
+        return;
+    }
+
+#ifdef GEOMETRY_RENDER
+    SDL_Vertex vertices[TEXT_LABEL_CHARS * 4];
+    int indices[TEXT_LABEL_CHARS * 6];
+    int vertexCount = 0;
+    int indexCount = 0;
+    int textureWidth, textureHeight;
+    SDL_QueryTexture(atlas->texture, NULL, NULL, &textureWidth, &textureHeight);
+
+    for (int i = 0; i < label->count; ++i) {
+        SDL_Rect src = atlas->glyphs[label->glyph[i]];
+        if (src.w == 0 || src.h == 0) continue; // Space
+        float left = (float)(x + label->x[i]);
+        float top = (float)y;
+        float u0 = (float)src.x / textureWidth;
+        float v0 = (float)src.y / textureHeight;
+        float u1 = (float)(src.x + src.w) / textureWidth;
+        float v1 = (float)(src.y + src.h) / textureHeight;
+
+        int base = vertexCount;
+        vertices[vertexCount++] = (SDL_Vertex){{left, top}, color, {u0, v0}};
+        vertices[vertexCount++] = (SDL_Vertex){{left + src.w, top}, color, {u1, v0}};
+        vertices[vertexCount++] = (SDL_Vertex){{left + src.w, top + src.h}, color, {u1, v1}};
+        vertices[vertexCount++] = (SDL_Vertex){{left, top + src.h}, color, {u0, v1}};
+        const int quad[6] = {0, 1, 2, 0, 2, 3};
+        for (int k = 0; k < 6; ++k) {
+            indices[indexCount++] = base + quad[k];
+        }
+    }
+    SDL_RenderGeometry(renderer, atlas->texture, vertices, vertexCount, indices, indexCount);
+#else
+    SDL_SetTextureColorMod(atlas->texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(atlas->texture, color.a);
+    for (int i = 0; i < label->count; ++i) {
+        SDL_Rect src = atlas->glyphs[label->glyph[i]];
+        if (src.w == 0 || src.h == 0) continue; // Space
+        SDL_Rect dest = {x + label->x[i], y, src.w, src.h};
+        SDL_RenderCopy(renderer, atlas->texture, &src, &dest);
+    }
+#endif
+}
+
+/**
+ * @brief Lays out and draws a line of text that changes from frame to frame.
+ * Text that stays the same is cheaper kept in a TextLabel.
+ * @param atlas The atlas to draw with.
+ * @param renderer The renderer to draw with.
+ * @param text The text.
+ * @param x Left edge of the text in output pixels.
+ * @param y Top edge of the text.
+ * @param color The text color.
+ */
+void text_draw(const TextAtlas* atlas, SDL_Renderer* renderer, const char* text, int x, int y, SDL_Color color) {
+    TextLabel label;
+    label.height = -1; // Never matches, so the text is always laid out
+    text_layout(atlas, text, &label);
+    text_draw_label(atlas, renderer, &label, x, y, color);
+}
+
+/**
+ * @brief Returns the atlas glyph for a character: its own if it is
+ * printable ASCII, else the question mark's.
+ */
+static int glyph_index(char c) {
+    unsigned char code = (unsigned char)c;
+    if (code < TEXT_FIRST_CHAR || code > TEXT_LAST_CHAR) {
+        code = '?';
+    }
+    return code - TEXT_FIRST_CHAR;
+}
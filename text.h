@@ -0,0 +1,52 @@
+// -----------------------------------------------------------------------------
+// Glyph atlas text for the 8-Ball Pool Game
+//
+// A text atlas holds every printable ASCII glyph of one font at one size in
+// a single texture, rasterized once. Strings are laid out into labels, which
+// keep the glyphs and their pen positions, and drawn as one batch of quads
+// from the atlas. Labels have a fixed capacity, so laying out and drawing
+// text never allocates; text that does not change is laid out once and
+// kept.
+// -----------------------------------------------------------------------------
+
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#define TEXT_FIRST_CHAR 32  // Space
+#define TEXT_LAST_CHAR 126  // Tilde
+#define TEXT_GLYPHS (TEXT_LAST_CHAR - TEXT_FIRST_CHAR + 1)
+#define TEXT_ATLAS_WIDTH 512 // Atlas rows wrap at this many pixels
+#define TEXT_LABEL_CHARS 64  // Longest label; longer text is cut off
+
+// One font's glyphs in one texture
+typedef struct {
+    SDL_Texture* texture;        // NULL until created
+    SDL_Rect glyphs[TEXT_GLYPHS]; // Each glyph's place in the texture
+    int advance[TEXT_GLYPHS];    // Pen movement after each glyph
+    int height;                  // Line height
+} TextAtlas;
+
+// A string laid out with an atlas, ready to draw
+typedef struct {
+    int count;                           // Glyphs laid out
+    uint8_t glyph[TEXT_LABEL_CHARS];     // Atlas glyph index of each character
+    int16_t x[TEXT_LABEL_CHARS];         // Pen position of each glyph
+    int width;                           // Size of the whole line
+    int height;
+    char text[TEXT_LABEL_CHARS + 1];     // The text laid out, to skip unchanged updates
+} TextLabel;
+
+// --- Function Prototypes ---
+bool text_create_atlas(TextAtlas* atlas, SDL_Renderer* renderer, TTF_Font* font);
+void text_destroy_atlas(TextAtlas* atlas);
+bool text_layout(const TextAtlas* atlas, const char* text, TextLabel* label);
+void text_draw_label(const TextAtlas* atlas, SDL_Renderer* renderer, const TextLabel* label, int x, int y,
+                     SDL_Color color);
+void text_draw(const TextAtlas* atlas, SDL_Renderer* renderer, const char* text, int x, int y, SDL_Color color);
+
+#endif
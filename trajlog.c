@@ -0,0 +1,447 @@
+// -----------------------------------------------------------------------------
+// Binary trajectory log for the 8-Ball Pool Game
+//
+// File format (little-endian):
+//   header (TRAJ_HEADER_SIZE bytes): "PTRJ", u32 version, u32 ball count,
+//     u32 units per table unit, u32 physics rate, u32 rack seed, u32 shot count,
+//     u32 frame size, u64 frame count, u32 table variant, zero padding
+//   frames: TrajFrame records of the header's frame size, back to back
+//
+// Every shot starts with a keyframe holding the racked table before the
+// shot, followed by one frame per physics step. A delta frame stores each
+// ball's change in quantized position since the previous frame; a step that
+// moves a ball too far for 16 bits is stored as a keyframe instead. Pocketed
+// balls keep their last position, so their deltas are zero.
+// -----------------------------------------------------------------------------
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "trajlog.h"
+
+// Frames buffered by the writer between writes
+#define TRAJ_WRITE_FRAMES 16384
+
+struct TrajWriter {
+    FILE* file;
+    TrajHeader header;
+    unsigned char* buffer;
+    size_t frameSize;
+    int buffered;
+    int32_t prev[MAX_BALLS][2]; // Quantized positions of the last frame
+    bool ok;                    // No write has failed
+};
+
+struct TrajReader {
+    TrajHeader header;
+    const unsigned char* data; // The whole mapped file
+    size_t size;
+    const unsigned char* frames;
+    size_t frameSize;
+    uint64_t* shotStarts;      // First frame of each shot, plus the end
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+// --- Function Prototypes ---
+static void add_frame(TrajWriter* writer, const Table* table, uint16_t flags);
+static bool flush_frames(TrajWriter* writer);
+static const TrajFrame* frame_at(const TrajReader* reader, uint64_t f);
+static bool write_header(TrajWriter* writer);
+static int32_t quantize(float value);
+static void put_u32(unsigned char* p, uint32_t v);
+static uint32_t get_u32(const unsigned char* p);
+static bool map_file(TrajReader* reader, const char* path);
+static void unmap_file(TrajReader* reader);
+
+
+// --- Writer ---
+
+/**
+ * @brief Creates a trajectory log for shots played from a rack.
+ * @param path The file to create.
+ * @param rack The table every shot is played from (for the header).
+ * @return The writer, or NULL on failure.
+ */
+TrajWriter* trajlog_create(const char* path, const Table* rack) {
+    TrajWriter* writer = calloc(1, sizeof(TrajWriter));
+    if (writer == NULL) {
+        return NULL;
+    }
+    writer->frameSize = TRAJ_FRAME_SIZE(rack->ballCount);
+    writer->buffer = malloc(TRAJ_WRITE_FRAMES * writer->frameSize);
+    writer->file = fopen(path, "wb");
+    if (writer->buffer == NULL || writer->file == NULL) {
+        printf("Could not create trajectory log '%s'!\n", path);
+        if (writer->file != NULL) fclose(writer->file);
+        free(writer->buffer);
+        free(writer);
+        return NULL;
+    }
+
+    writer->header = (TrajHeader){TRAJ_VERSION, (uint32_t)rack->variant, (uint32_t)rack->ballCount,
+                                  TRAJ_UNITS_PER_TABLE_UNIT, (uint32_t)rack->physicsHz, rack->rackSeed, 0, 0};
+    writer->ok = write_header(writer);
+    return writer;
+}
+
+/**
+ * @brief Plays one shot from a rack, stepping update() until the table
+ * stops simulating (or MAX_SHOT_SECONDS pass), and logs every step. The
+ * rack's fast-forward setting is ignored.
+ * @param writer The log to write to.
+ * @param rack The table to play from.
+ * @param cue The cue ball's velocity.
+ * @param result Receives the table after the shot.
+ * @param steps Receives the number of physics steps simulated.
+ * @return false if writing the log has failed.
+ */
+bool trajlog_record_shot(TrajWriter* writer, const Table* rack, Vec2D cue, Table* result, int* steps) {
+    *result = *rack;
+    result->fastForward = false; // Every step is logged
+    add_frame(writer, result, TRAJ_KEYFRAME | TRAJ_SHOT_START);
+    strike_cue_ball(result, cue);
+
+    const int maxSteps = MAX_SHOT_SECONDS * result->physicsHz;
+    int count = 0;
+    while (result->state == STATE_SIMULATING && count < maxSteps) {
+        update(result);
+        add_frame(writer, result, 0);
+        count++;
+    }
+
+    *steps = count;
+    writer->header.shotCount++;
+    return writer->ok;
+}
+
+/**
+ * @brief Flushes and closes a log, filling in the header's counts.
+ * @param writer The log to close (freed, even on failure).
+ * @return false if any write failed.
+ */
+bool trajlog_close(TrajWriter* writer) {
+    if (writer == NULL) {
+        return false;
+    }
+    bool ok = flush_frames(writer) && writer->ok;
+    ok = fseek(writer->file, 0, SEEK_SET) == 0 && write_header(writer) && ok;
+    ok = fclose(writer->file) == 0 && ok;
+    if (!ok) {
+        printf("Could not write trajectory log!\n");
+    }
+    free(writer->buffer);
+    free(writer);
+    return ok;
+}
+
+/**
+ * @brief Appends a table's current ball positions as a frame.
+ * @param writer The log to write to.
+ * @param table The table after the step.
+ * @param flags TRAJ_KEYFRAME and/or TRAJ_SHOT_START, or 0 for a delta frame
+ * (which is promoted to a keyframe if a delta does not fit).
+ */
+static void add_frame(TrajWriter* writer, const Table* table, uint16_t flags) {
+    if (writer->buffered == TRAJ_WRITE_FRAMES && !flush_frames(writer)) {
+        writer->ok = false;
+    }
+
+    const int balls = (int)writer->header.numBalls;
+    int32_t q[MAX_BALLS][2];
+    for (int i = 0; i < balls; ++i) {
+        q[i][0] = quantize(table->px[i]);
+        q[i][1] = quantize(table->py[i]);
+        if (!(flags & TRAJ_KEYFRAME)) {
+            int32_t dx = q[i][0] - writer->prev[i][0];
+            int32_t dy = q[i][1] - writer->prev[i][1];
+            if (dx < INT16_MIN || dx > INT16_MAX || dy < INT16_MIN || dy > INT16_MAX) {
+                flags |= TRAJ_KEYFRAME;
+            }
+        }
+    }
+
+    TrajFrame* frame = (TrajFrame*)(writer->buffer + (size_t)writer->buffered++ * writer->frameSize);
+    frame->flags = flags;
+    frame->reserved = 0;
+    frame->active = table->active;
+    for (int i = 0; i < balls; ++i) {
+        for (int axis = 0; axis < 2; ++axis) {
+            int32_t value = (flags & TRAJ_KEYFRAME) ? q[i][axis] : q[i][axis] - writer->prev[i][axis];
+            frame->pos[i][axis] = (int16_t)value;
+            writer->prev[i][axis] = q[i][axis];
+        }
+    }
+    writer->header.frameCount++;
+}
+
+/**
+ * @brief Writes the buffered frames to the file.
+ * @return false if the write failed.
+ */
+static bool flush_frames(TrajWriter* writer) {
+    size_t count = (size_t)writer->buffered;
+    writer->buffered = 0;
+    return count == 0 || fwrite(writer->buffer, writer->frameSize, count, writer->file) == count;
+}
+
+/**
+ * @brief Writes the header at the current file position.
+ * @return false if the write failed.
+ */
+static bool write_header(TrajWriter* writer) {
+    unsigned char header[TRAJ_HEADER_SIZE] = {0};
+    memcpy(header, TRAJ_MAGIC, 4);
+    put_u32(header + 4, writer->header.version);
+    put_u32(header + 8, writer->header.numBalls);
+    put_u32(header + 12, writer->header.unitsPerTableUnit);
+    put_u32(header + 16, writer->header.physicsHz);
+    put_u32(header + 20, writer->header.rackSeed);
+    put_u32(header + 24, writer->header.shotCount);
+    put_u32(header + 28, (uint32_t)writer->frameSize);
+    put_u32(header + 32, (uint32_t)writer->header.frameCount);
+    put_u32(header + 36, (uint32_t)(writer->header.frameCount >> 32));
+    put_u32(header + 40, writer->header.variant);
+    return fwrite(header, sizeof(header), 1, writer->file) == 1;
+}
+
+/**
+ * @brief Converts a position to trajectory units, saturating at 16 bits
+ * (positions on the table are far inside that range).
+ */
+static int32_t quantize(float value) {
+    long q = lrintf(value * TRAJ_UNITS_PER_TABLE_UNIT);
+    if (q < INT16_MIN) q = INT16_MIN;
+    if (q > INT16_MAX) q = INT16_MAX;
+    return (int32_t)q;
+}
+
+
+// --- Reader ---
+
+/**
+ * @brief Maps a trajectory log for reading and indexes its shots. Frames
+ * are read in place from the mapping. A log whose writer did not finish is
+ * read up to its last complete frame.
+ * @param path The log to open.
+ * @return The reader, or NULL if the file is missing or not a log (its
+ * ball count must be its variant's and its position units nonzero).
+ */
+TrajReader* trajlog_open(const char* path) {
+    TrajReader* reader = calloc(1, sizeof(TrajReader));
+    if (reader == NULL) {
+        return NULL;
+    }
+    if (!map_file(reader, path)) {
+        printf("Could not open trajectory log '%s'!\n", path);
+        free(reader);
+        return NULL;
+    }
+
+    const unsigned char* h = reader->data;
+    if (reader->size < TRAJ_HEADER_SIZE || memcmp(h, TRAJ_MAGIC, 4) != 0 ||
+        get_u32(h + 4) != TRAJ_VERSION || get_u32(h + 40) >= VARIANT_COUNT ||
+        get_u32(h + 8) != (uint32_t)variant_balls((TableVariant)get_u32(h + 40)) || get_u32(h + 12) == 0 ||
+        get_u32(h + 28) != TRAJ_FRAME_SIZE(get_u32(h + 8))) {
+        printf("'%s' is not a version %d trajectory log!\n", path, TRAJ_VERSION);
+        trajlog_free(reader);
+        return NULL;
+    }
+    reader->header.version = get_u32(h + 4);
+    reader->header.variant = get_u32(h + 40);
+    reader->header.numBalls = get_u32(h + 8);
+    reader->header.unitsPerTableUnit = get_u32(h + 12);
+    reader->header.physicsHz = get_u32(h + 16);
+    reader->header.rackSeed = get_u32(h + 20);
+    reader->frameSize = get_u32(h + 28);
+    reader->header.frameCount = (reader->size - TRAJ_HEADER_SIZE) / reader->frameSize;
+    reader->frames = reader->data + TRAJ_HEADER_SIZE;
+
+    // Index the shots by their start frames
+    uint32_t shots = 0;
+    for (uint64_t f = 0; f < reader->header.frameCount; ++f) {
+        if (frame_at(reader, f)->flags & TRAJ_SHOT_START) shots++;
+    }
+    reader->shotStarts = malloc((shots + 1) * sizeof(uint64_t));
+    if (reader->shotStarts == NULL) {
+        trajlog_free(reader);
+        return NULL;
+    }
+    uint32_t shot = 0;
+    for (uint64_t f = 0; f < reader->header.frameCount; ++f) {
+        if (frame_at(reader, f)->flags & TRAJ_SHOT_START) reader->shotStarts[shot++] = f;
+    }
+    reader->shotStarts[shots] = reader->header.frameCount;
+    reader->header.shotCount = shots;
+    return reader;
+}
+
+/**
+ * @brief Returns a log's header. Shot and frame counts are those actually
+ * present in the file.
+ */
+const TrajHeader* trajlog_header(const TrajReader* reader) {
+    return &reader->header;
+}
+
+/**
+ * @brief Returns the number of frames in a shot (its starting keyframe plus
+ * one per physics step), or 0 if there is no such shot.
+ */
+int trajlog_shot_frames(const TrajReader* reader, int shot) {
+    if (shot < 0 || (uint32_t)shot >= reader->header.shotCount) {
+        return 0;
+    }
+    return (int)(reader->shotStarts[shot + 1] - reader->shotStarts[shot]);
+}
+
+/**
+ * @brief Loads the ball positions and active mask of one frame into a
+ * table, decoding from the nearest keyframe. Velocities are zeroed and the
+ * table is left simulating.
+ * @param reader The log to read.
+ * @param shot The 0-based shot index.
+ * @param frame The frame within the shot (0 is the rack before the shot).
+ * @param table Receives the frame.
+ * @return false if there is no such frame.
+ */
+bool trajlog_seek(const TrajReader* reader, int shot, int frame, Table* table) {
+    if (frame < 0 || frame >= trajlog_shot_frames(reader, shot)) {
+        return false;
+    }
+    uint64_t first = reader->shotStarts[shot];
+    uint64_t target = first + (uint64_t)frame;
+    uint64_t key = target;
+    while (key > first && !(frame_at(reader, key)->flags & TRAJ_KEYFRAME)) key--;
+
+    const int balls = (int)reader->header.numBalls;
+    int32_t q[MAX_BALLS][2];
+    for (uint64_t f = key; f <= target; ++f) {
+        const TrajFrame* record = frame_at(reader, f);
+        bool absolute = f == key;
+        for (int i = 0; i < balls; ++i) {
+            q[i][0] = (absolute ? 0 : q[i][0]) + record->pos[i][0];
+            q[i][1] = (absolute ? 0 : q[i][1]) + record->pos[i][1];
+        }
+    }
+
+    const float scale = 1.0f / (float)reader->header.unitsPerTableUnit;
+    for (int i = 0; i < balls; ++i) {
+        table->px[i] = q[i][0] * scale;
+        table->py[i] = q[i][1] * scale;
+        table->vx[i] = 0.0f;
+        table->vy[i] = 0.0f;
+    }
+    table->active = (BallMask)frame_at(reader, target)->active;
+    table->state = STATE_SIMULATING;
+    return true;
+}
+
+/**
+ * @brief Unmaps a log and frees its reader.
+ */
+void trajlog_free(TrajReader* reader) {
+    if (reader == NULL) {
+        return;
+    }
+    unmap_file(reader);
+    free(reader->shotStarts);
+    free(reader);
+}
+
+/**
+ * @brief Returns frame f of a log, in place in the mapping.
+ */
+static const TrajFrame* frame_at(const TrajReader* reader, uint64_t f) {
+    return (const TrajFrame*)(reader->frames + f * reader->frameSize);
+}
+
+/**
+ * @brief Maps a whole file read-only into reader->data.
+ * @return false if the file cannot be opened or mapped.
+ */
+static bool map_file(TrajReader* reader, const char* path) {
+#ifdef _WIN32
+    reader->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (reader->file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(reader->file, &size) || size.QuadPart == 0) {
+        CloseHandle(reader->file);
+        return false;
+    }
+    reader->mapping = CreateFileMappingA(reader->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (reader->mapping == NULL) {
+        CloseHandle(reader->file);
+        return false;
+    }
+    reader->data = MapViewOfFile(reader->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (reader->data == NULL) {
+        CloseHandle(reader->mapping);
+        CloseHandle(reader->file);
+        return false;
+    }
+    reader->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    reader->data = data;
+    reader->size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+/**
+ * @brief Releases the mapping made by map_file(), if any.
+ */
+static void unmap_file(TrajReader* reader) {
+    if (reader->data == NULL) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(reader->data);
+    CloseHandle(reader->mapping);
+    CloseHandle(reader->file);
+#else
+    munmap((void*)reader->data, reader->size);
+#endif
+    reader->data = NULL;
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
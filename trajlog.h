@@ -0,0 +1,68 @@
+// -----------------------------------------------------------------------------
+// Binary trajectory log for the 8-Ball Pool Game
+//
+// Stores every physics step of a batch of shots as frames of quantized ball
+// positions, delta-encoded against the previous step. Frames hold one entry
+// per ball of the log's table variant, so every frame of a log is the same
+// size. The writer is buffered; the reader maps the file and reads frames in
+// place.
+// -----------------------------------------------------------------------------
+
+#ifndef TRAJLOG_H
+#define TRAJLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "physics.h"
+
+#define TRAJ_MAGIC "PTRJ"
+#define TRAJ_VERSION 3
+#define TRAJ_UNITS_PER_TABLE_UNIT 16 // Position quantum is 1/16 table unit
+#define TRAJ_HEADER_SIZE 64
+
+// Frame flags
+#define TRAJ_KEYFRAME 0x1   // pos holds absolute positions, not deltas
+#define TRAJ_SHOT_START 0x2 // First frame of a shot (always a keyframe)
+
+// One physics step. The layout is the on-disk format (little-endian); a
+// frame is 8 bytes followed by 4 per ball (see TRAJ_FRAME_SIZE).
+typedef struct {
+    uint16_t flags;
+    uint16_t reserved;
+    uint32_t active;               // Balls on the table after the step
+    int16_t pos[][2];              // Quantized x,y (or their change) of each ball
+} TrajFrame;
+
+#define TRAJ_FRAME_SIZE(balls) (sizeof(TrajFrame) + (size_t)(balls) * 4)
+
+_Static_assert(MAX_BALLS <= 32, "TrajFrame.active holds 32 balls");
+_Static_assert(sizeof(TrajFrame) == 8, "TrajFrame must not be padded");
+
+// File header, as decoded by trajlog_open()
+typedef struct {
+    uint32_t version;
+    uint32_t variant;   // TableVariant the shots were played on
+    uint32_t numBalls;
+    uint32_t unitsPerTableUnit;
+    uint32_t physicsHz;
+    uint32_t rackSeed;
+    uint32_t shotCount;
+    uint64_t frameCount;
+} TrajHeader;
+
+// Opaque writer and reader
+typedef struct TrajWriter TrajWriter;
+typedef struct TrajReader TrajReader;
+
+// --- Function Prototypes ---
+TrajWriter* trajlog_create(const char* path, const Table* rack);
+bool trajlog_record_shot(TrajWriter* writer, const Table* rack, Vec2D cue, Table* result, int* steps);
+bool trajlog_close(TrajWriter* writer);
+
+TrajReader* trajlog_open(const char* path);
+const TrajHeader* trajlog_header(const TrajReader* reader);
+int trajlog_shot_frames(const TrajReader* reader, int shot);
+bool trajlog_seek(const TrajReader* reader, int shot, int frame, Table* table);
+void trajlog_free(TrajReader* reader);
+
+#endif